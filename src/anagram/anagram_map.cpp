@@ -143,6 +143,9 @@ std::unique_ptr<AnagramMap> AnagramMap::CreateFromTextfile(
 
 std::unique_ptr<AnagramMap> AnagramMap::CreateFromBinaryFile(
     const Tiles& tiles, const std::string& filename) {
+  if (AnagramMapSnapshot::IsSnapshotFile(filename)) {
+    return CreateFromSnapshotFile(tiles, filename);
+  }
   auto anagram_map = absl::make_unique<AnagramMap>(tiles);
   std::ifstream file(filename, std::ios::binary);
   if (!file) {
@@ -246,7 +249,58 @@ std::unique_ptr<AnagramMap> AnagramMap::CreateFromBinaryFile(
   return anagram_map;
 }
 
+std::unique_ptr<AnagramMap> AnagramMap::CreateFromSnapshotFile(
+    const Tiles& tiles, const std::string& filename) {
+  auto snapshot = AnagramMapSnapshot::Open(filename);
+  if (snapshot == nullptr) {
+    return nullptr;
+  }
+  LOG(INFO) << "Mapped anagram map snapshot " << filename << " with "
+            << snapshot->NumWords() << " words";
+  auto anagram_map = absl::make_unique<AnagramMap>(tiles);
+  anagram_map->snapshot_ = std::move(snapshot);
+  return anagram_map;
+}
+
+absl::Status AnagramMap::WriteToSnapshotFile(
+    const std::string& filename) const {
+  if (snapshot_ != nullptr) {
+    return absl::FailedPreconditionError(
+        "Anagram map is already a snapshot; copy the file instead");
+  }
+  std::vector<AnagramMapSnapshot::TableEntry> word_entries;
+  word_entries.reserve(map_.size());
+  for (const auto& pair : map_) {
+    word_entries.push_back(
+        {pair.first, static_cast<uint32_t>(pair.second.data() - words_.data()),
+         static_cast<uint32_t>(pair.second.size())});
+  }
+  std::vector<AnagramMapSnapshot::TableEntry> blank_entries;
+  blank_entries.reserve(blank_map_.size());
+  for (const auto& pair : blank_map_) {
+    blank_entries.push_back(
+        {pair.first, static_cast<uint32_t>(pair.second.data() - blanks_.data()),
+         static_cast<uint32_t>(pair.second.size())});
+  }
+  std::vector<AnagramMapSnapshot::TableEntry> double_blank_entries;
+  double_blank_entries.reserve(double_blank_map_.size());
+  for (const auto& pair : double_blank_map_) {
+    double_blank_entries.push_back(
+        {pair.first,
+         static_cast<uint32_t>(pair.second.data() - double_blanks_.data()),
+         static_cast<uint32_t>(pair.second.size())});
+  }
+  return AnagramMapSnapshot::Write(filename, words_, blanks_, double_blanks_,
+                                   std::move(word_entries),
+                                   std::move(blank_entries),
+                                   std::move(double_blank_entries), hook_map_);
+}
+
 absl::Status AnagramMap::WriteToBinaryFile(const std::string& filename) const {
+  if (snapshot_ != nullptr) {
+    return absl::FailedPreconditionError(
+        "Can't write a snapshot-backed anagram map as .qam");
+  }
   std::ofstream file(filename, std::ios::out | std::ios::binary);
   if (!file.is_open()) {
     return absl::NotFoundError("Could not open file " + filename);
@@ -376,33 +430,46 @@ AnagramMap::WordRange AnagramMap::Words(const absl::uint128& product,
   if (num_blanks == 0) {
     return WordRange(Words(product));
   } else if (num_blanks == 1) {
-    std::vector<absl::uint128> products;
-    const auto* blanks = Blanks(product);
-    if (blanks != nullptr) {
-      products.reserve(ranges::distance(*blanks));
-      for (const Letter letter : *blanks) {
-        const absl::uint128 new_product = product * tiles_.Prime(letter);
-        products.emplace_back(new_product);
-      }
+    const auto blanks = Blanks(product);
+    if (!blanks.has_value()) {
+      return WordRange(std::vector<absl::uint128>(), *this);
     }
-    return WordRange(products, *this);
+    return BlankWords(*blanks, product);
   } else if (num_blanks == 2) {
-    std::vector<absl::uint128> products;
-    const auto* double_blanks = DoubleBlanks(product);
-    if (double_blanks != nullptr) {
-      products.reserve(ranges::distance(*double_blanks));
-      for (const auto& blank_pair : *double_blanks) {
-        const absl::uint128 new_product =
-            product *
-            (tiles_.Prime(blank_pair.first) * tiles_.Prime(blank_pair.second));
-        products.emplace_back(new_product);
-      }
+    const auto double_blanks = DoubleBlanks(product);
+    if (!double_blanks.has_value()) {
+      return WordRange(std::vector<absl::uint128>(), *this);
     }
-    return WordRange(products, *this);
+    return DoubleBlankWords(*double_blanks, product);
   } else {
     LOG(ERROR) << "Invalid number of blanks: " << num_blanks;
-    return WordRange(nullptr);
+    return WordRange(absl::nullopt);
+  }
+}
+
+AnagramMap::WordRange AnagramMap::BlankWords(
+    absl::Span<const Letter> blanks, const absl::uint128& product) const {
+  std::vector<absl::uint128> products;
+  products.reserve(blanks.size());
+  for (const Letter letter : blanks) {
+    const absl::uint128 new_product = product * tiles_.Prime(letter);
+    products.emplace_back(new_product);
+  }
+  return WordRange(products, *this);
+}
+
+AnagramMap::WordRange AnagramMap::DoubleBlankWords(
+    absl::Span<const LetterPair> double_blanks,
+    const absl::uint128& product) const {
+  std::vector<absl::uint128> products;
+  products.reserve(double_blanks.size());
+  for (const auto& blank_pair : double_blanks) {
+    const absl::uint128 new_product =
+        product *
+        (tiles_.Prime(blank_pair.first) * tiles_.Prime(blank_pair.second));
+    products.emplace_back(new_product);
   }
+  return WordRange(products, *this);
 }
 
 void AnagramMap::BuildHookMap() {
@@ -426,8 +493,8 @@ std::vector<absl::Span<const LetterString>> AnagramMap::WordRange::MakeSpans(
   std::vector<absl::Span<const LetterString>> spans;
   spans.reserve(products.size());
   for (const auto& product : products) {
-    const auto* span = anagram_map.Words(product);
-    if (span != nullptr) {
+    const auto span = anagram_map.Words(product);
+    if (span.has_value()) {
       spans.emplace_back(*span);
     } else {
       LOG(ERROR) << "Invalid product with no words: " << product;
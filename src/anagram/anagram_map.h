@@ -1,11 +1,15 @@
 #ifndef SRC_ANAGRAM_ANAGRAM_MAP_H
 #define SRC_ANAGRAM_ANAGRAM_MAP_H
 
+#include <memory>
+
 #include "absl/container/flat_hash_map.h"
 #include "absl/numeric/int128.h"
 #include "absl/status/status.h"
+#include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "absl/types/variant.h"
+#include "src/anagram/anagram_map_snapshot.h"
 #include "src/scrabble/strings.h"
 #include "src/scrabble/tiles.h"
 
@@ -17,14 +21,21 @@ typedef absl::flat_hash_map<
 typedef absl::flat_hash_map<absl::uint128,
                             absl::Span<const LetterPair>>::const_iterator
     DoubleBlankIterator;
-typedef absl::variant<WordIterator, BlankIterator, DoubleBlankIterator>
+// Lookup result in a snapshot-backed map; slot is nullptr if there's no entry.
+struct SnapshotIterator {
+  const AnagramMapSnapshot::ProductSlot* slot;
+  int num_blanks;
+};
+typedef absl::variant<WordIterator, BlankIterator, DoubleBlankIterator,
+                      SnapshotIterator>
     AnagramMapIterator;
 
 class AnagramMap {
  public:
   class WordRange {
    public:
-    explicit WordRange(const absl::Span<const LetterString>* span);
+    explicit WordRange(
+        const absl::optional<absl::Span<const LetterString>>& span);
     explicit WordRange(const std::vector<absl::uint128>& products,
                        const AnagramMap& anagram_map);
     const std::vector<absl::Span<const LetterString>>& Spans() const {
@@ -33,7 +44,7 @@ class AnagramMap {
 
    private:
     std::vector<absl::Span<const LetterString>> MakeSpans(
-        const absl::Span<const LetterString>* span) const;
+        const absl::optional<absl::Span<const LetterString>>& span) const;
     std::vector<absl::Span<const LetterString>> MakeSpans(
         const std::vector<absl::uint128>& products,
         const AnagramMap& anagram_map) const;
@@ -44,9 +55,15 @@ class AnagramMap {
   explicit AnagramMap(const Tiles& tiles) : tiles_(tiles) {}
   static std::unique_ptr<AnagramMap> CreateFromTextfile(
       const Tiles& tiles, const std::string& filename);
+  // Also accepts a snapshot file, which is then used via
+  // CreateFromSnapshotFile(...).
   static std::unique_ptr<AnagramMap> CreateFromBinaryFile(
       const Tiles& tiles, const std::string& filename);
+  // Maps a file written by WriteToSnapshotFile(...) without parsing it.
+  static std::unique_ptr<AnagramMap> CreateFromSnapshotFile(
+      const Tiles& tiles, const std::string& filename);
   absl::Status WriteToBinaryFile(const std::string& filename) const;
+  absl::Status WriteToSnapshotFile(const std::string& filename) const;
 
   AnagramMapIterator WordIterator(const absl::uint128& product,
                                   int num_blanks) const;
@@ -55,13 +72,17 @@ class AnagramMap {
   WordRange Words(const AnagramMapIterator& iterator,
                   const absl::uint128& product) const;
   WordRange Words(const absl::uint128& product, int num_blanks) const;
-  const absl::Span<const LetterString>* Words(
+  absl::optional<absl::Span<const LetterString>> Words(
       const absl::uint128& product) const;
-  const absl::Span<const Letter>* Blanks(const absl::uint128& product) const;
-  const absl::Span<const LetterPair>* DoubleBlanks(
+  absl::optional<absl::Span<const Letter>> Blanks(
+      const absl::uint128& product) const;
+  absl::optional<absl::Span<const LetterPair>> DoubleBlanks(
       const absl::uint128& product) const;
 
   const uint32_t Hooks(const LetterString& letter_string) const {
+    if (snapshot_ != nullptr) {
+      return snapshot_->Hooks(letter_string);
+    }
     auto it = hook_map_.find(letter_string);
     if (it == hook_map_.end()) {
       return 0;
@@ -75,9 +96,16 @@ class AnagramMap {
   FRIEND_TEST(AnagramMapTest, WriteToOstream);
   FRIEND_TEST(AnagramMapTest, CreateFromBinaryFile);
   FRIEND_TEST(AnagramMapTest, CreateFromBinaryFile2);
+  FRIEND_TEST(AnagramMapTest, WriteToSnapshotFile);
 
   void BuildHookMap();
 
+  // Words formed by adding each of blanks (or blank pairs) to product.
+  WordRange BlankWords(absl::Span<const Letter> blanks,
+                       const absl::uint128& product) const;
+  WordRange DoubleBlankWords(absl::Span<const LetterPair> double_blanks,
+                             const absl::uint128& product) const;
+
   bool WriteToOstream(std::ostream& os) const;
 
   const Tiles& tiles_;
@@ -95,10 +123,13 @@ class AnagramMap {
   // Keys are LetterStrings with one empty character which can be filled with a
   // letter to make a legal word.
   absl::flat_hash_map<LetterString, uint32_t> hook_map_;
+
+  // If set, all lookups go to the snapshot and the containers above are empty.
+  std::unique_ptr<AnagramMapSnapshot> snapshot_;
 };
 
 inline AnagramMap::WordRange::WordRange(
-    const absl::Span<const LetterString>* span)
+    const absl::optional<absl::Span<const LetterString>>& span)
     : spans_(MakeSpans(span)) {}
 inline AnagramMap::WordRange::WordRange(
     const std::vector<absl::uint128>& products, const AnagramMap& anagram_map)
@@ -106,8 +137,8 @@ inline AnagramMap::WordRange::WordRange(
 
 inline std::vector<absl::Span<const LetterString>>
 AnagramMap::WordRange::MakeSpans(
-    const absl::Span<const LetterString>* span) const {
-  if (span == nullptr) {
+    const absl::optional<absl::Span<const LetterString>>& span) const {
+  if (!span.has_value()) {
     return {};
   } else {
     return {*span};
@@ -116,6 +147,9 @@ AnagramMap::WordRange::MakeSpans(
 
 inline AnagramMapIterator AnagramMap::WordIterator(const absl::uint128& product,
                                                    int num_blanks) const {
+  if (snapshot_ != nullptr) {
+    return SnapshotIterator{snapshot_->Find(product, num_blanks), num_blanks};
+  }
   switch (num_blanks) {
     case 0:
       return map_.find(product);
@@ -131,6 +165,9 @@ inline AnagramMapIterator AnagramMap::WordIterator(const absl::uint128& product,
 
 inline bool AnagramMap::HasWord(const absl::uint128& product,
                                 int num_blanks) const {
+  if (snapshot_ != nullptr) {
+    return snapshot_->Find(product, num_blanks) != nullptr;
+  }
   switch (num_blanks) {
     case 0:
       return map_.find(product) != map_.end();
@@ -157,6 +194,8 @@ inline bool AnagramMap::HasWord(const AnagramMapIterator& iterator) const {
                  absl::uint128, absl::Span<const LetterPair>>::const_iterator>(
                  &iterator)) {
     return *it != double_blank_map_.end();
+  } else if (auto it = absl::get_if<SnapshotIterator>(&iterator)) {
+    return it->slot != nullptr;
   }
   return false;
 }
@@ -167,71 +206,88 @@ inline AnagramMap::WordRange AnagramMap::Words(
           absl::uint128, absl::Span<const LetterString>>::const_iterator>(
           &iterator)) {
     if (*it == map_.end()) {
-      return WordRange(nullptr);
+      return WordRange(absl::nullopt);
     } else {
-      return WordRange(&((*it)->second));
+      return WordRange((*it)->second);
     }
   } else if (auto it = absl::get_if<absl::flat_hash_map<
                  absl::uint128, absl::Span<const Letter>>::const_iterator>(
                  &iterator)) {
     if (*it == blank_map_.end()) {
-      return WordRange(nullptr);
+      return WordRange(absl::nullopt);
     } else {
-      std::vector<absl::uint128> products;
-      const auto& blanks = (*it)->second;
-      products.reserve(blanks.size());
-      for (const Letter letter : blanks) {
-        const absl::uint128 new_product = product * tiles_.Prime(letter);
-        products.emplace_back(new_product);
-      }
-      return WordRange(products, *this);
+      return BlankWords((*it)->second, product);
     }
   } else if (auto it = absl::get_if<absl::flat_hash_map<
                  absl::uint128, absl::Span<const LetterPair>>::const_iterator>(
                  &iterator)) {
     if (*it == double_blank_map_.end()) {
-      return WordRange(nullptr);
+      return WordRange(absl::nullopt);
     } else {
-      std::vector<absl::uint128> products;
-      const auto& double_blanks = (*it)->second;
-      products.reserve(double_blanks.size());
-      for (const auto& blank_pair : double_blanks) {
-        const absl::uint128 new_product =
-            product *
-            (tiles_.Prime(blank_pair.first) * tiles_.Prime(blank_pair.second));
-        products.emplace_back(new_product);
-      }
-      return WordRange(products, *this);
+      return DoubleBlankWords((*it)->second, product);
+    }
+  } else if (auto it = absl::get_if<SnapshotIterator>(&iterator)) {
+    if (it->slot == nullptr) {
+      return WordRange(absl::nullopt);
+    }
+    switch (it->num_blanks) {
+      case 0:
+        return WordRange(snapshot_->Words(*it->slot));
+      case 1:
+        return BlankWords(snapshot_->Blanks(*it->slot), product);
+      case 2:
+        return DoubleBlankWords(snapshot_->DoubleBlanks(*it->slot), product);
     }
   }
-  return WordRange(nullptr);
+  return WordRange(absl::nullopt);
 }
 
-inline const absl::Span<const LetterString>* AnagramMap::Words(
+inline absl::optional<absl::Span<const LetterString>> AnagramMap::Words(
     const absl::uint128& product) const {
+  if (snapshot_ != nullptr) {
+    const auto* slot = snapshot_->Find(product, 0);
+    if (slot == nullptr) {
+      return absl::nullopt;
+    }
+    return snapshot_->Words(*slot);
+  }
   const auto it = map_.find(product);
   if (it == map_.end()) {
-    return nullptr;
+    return absl::nullopt;
   }
-  return &it->second;
+  return it->second;
 }
 
-inline const absl::Span<const Letter>* AnagramMap::Blanks(
+inline absl::optional<absl::Span<const Letter>> AnagramMap::Blanks(
     const absl::uint128& product) const {
+  if (snapshot_ != nullptr) {
+    const auto* slot = snapshot_->Find(product, 1);
+    if (slot == nullptr) {
+      return absl::nullopt;
+    }
+    return snapshot_->Blanks(*slot);
+  }
   const auto it = blank_map_.find(product);
   if (it == blank_map_.end()) {
-    return nullptr;
+    return absl::nullopt;
   }
-  return &it->second;
+  return it->second;
 }
 
-inline const absl::Span<const LetterPair>* AnagramMap::DoubleBlanks(
+inline absl::optional<absl::Span<const LetterPair>> AnagramMap::DoubleBlanks(
     const absl::uint128& product) const {
+  if (snapshot_ != nullptr) {
+    const auto* slot = snapshot_->Find(product, 2);
+    if (slot == nullptr) {
+      return absl::nullopt;
+    }
+    return snapshot_->DoubleBlanks(*slot);
+  }
   const auto it = double_blank_map_.find(product);
   if (it == double_blank_map_.end()) {
-    return nullptr;
+    return absl::nullopt;
   }
-  return &it->second;
+  return it->second;
 }
 
 #endif  // SRC_ANAGRAM_ANAGRAM_MAP_H
\ No newline at end of file
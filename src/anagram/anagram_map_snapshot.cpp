@@ -0,0 +1,378 @@
+#include "src/anagram/anagram_map_snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <tuple>
+#include <type_traits>
+
+#include "absl/memory/memory.h"
+#include "glog/logging.h"
+
+namespace {
+constexpr char kMagic[8] = {'Q', '2', 'A', 'N', 'S', 'N', 'A', 'P'};
+constexpr uint32_t kVersion = 1;
+
+// Fixed-layout file header. Sections follow at 8-byte aligned offsets. Values
+// are stored in native byte order; snapshots are meant to be built on the
+// machine (or architecture) that uses them.
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t letter_string_size;
+  uint64_t file_size;
+  uint64_t num_words;
+  uint64_t words_offset;
+  uint64_t num_blanks;
+  uint64_t blanks_offset;
+  uint64_t num_double_blanks;
+  uint64_t double_blanks_offset;
+  // Indexed by number of blanks.
+  uint64_t table_capacities[3];
+  uint64_t table_offsets[3];
+  uint64_t hook_table_capacity;
+  uint64_t hook_table_offset;
+};
+
+// The words section is an array of LetterStrings read in place, which is
+// only sound for a trivially copyable type whose bytes are all there is to
+// it. The size is also checked against the file header, so a snapshot from
+// a build with a different layout is rejected.
+static_assert(std::is_trivially_copyable<LetterString>::value,
+              "LetterString must be trivially copyable to live in a snapshot");
+static_assert(std::is_standard_layout<LetterString>::value,
+              "LetterString must be standard layout to live in a snapshot");
+static_assert(sizeof(LetterString) ==
+                  FIXED_STRING_MAXIMUM_LENGTH + 3 + 2 * sizeof(int),
+              "LetterString must be its letters and two int positions");
+static_assert(alignof(LetterString) == alignof(int),
+              "LetterString must be int-aligned to live in a snapshot");
+
+uint64_t Mix(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+// Must never change for a given kVersion: the tables are laid out with it.
+uint64_t HashKey(uint64_t low, uint64_t high) {
+  return Mix(low ^ Mix(high + 0x9e3779b97f4a7c15ULL));
+}
+
+// Power of two, at most half full, so probes always reach an empty slot.
+uint64_t TableCapacity(size_t num_entries) {
+  uint64_t capacity = 16;
+  while (capacity < 2 * num_entries) {
+    capacity <<= 1;
+  }
+  return capacity;
+}
+
+uint64_t Align(uint64_t offset) { return (offset + 7) & ~uint64_t{7}; }
+
+bool PackHookKey(const LetterString& letter_string, uint64_t* low,
+                 uint64_t* high) {
+  if (letter_string.size() > 24) {
+    return false;
+  }
+  *low = 0;
+  *high = 0;
+  int i = 0;
+  for (const Letter letter : letter_string) {
+    const uint64_t value = static_cast<uint8_t>(letter);
+    if (i < 12) {
+      *low |= value << (5 * i);
+    } else {
+      *high |= value << (5 * (i - 12));
+    }
+    ++i;
+  }
+  return true;
+}
+
+bool WritePadded(std::ofstream& file, const void* data, size_t size,
+                 uint64_t* offset) {
+  const uint64_t aligned = Align(*offset);
+  static const char kZeroes[8] = {0};
+  file.write(kZeroes, aligned - *offset);
+  file.write(static_cast<const char*>(data), size);
+  *offset = aligned + size;
+  return file.good();
+}
+}  // namespace
+
+bool AnagramMapSnapshot::IsSnapshotFile(const std::string& filename) {
+  std::ifstream file(filename, std::ios::binary);
+  char magic[sizeof(kMagic)];
+  if (!file.read(magic, sizeof(magic))) {
+    return false;
+  }
+  return std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+std::unique_ptr<AnagramMapSnapshot> AnagramMapSnapshot::Open(
+    const std::string& filename) {
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(ERROR) << "Could not open file " << filename;
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(Header)) {
+    LOG(ERROR) << "Could not stat snapshot " << filename;
+    close(fd);
+    return nullptr;
+  }
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    LOG(ERROR) << "Could not mmap snapshot " << filename;
+    return nullptr;
+  }
+  auto snapshot = absl::WrapUnique(new AnagramMapSnapshot());
+  snapshot->data_ = static_cast<const char*>(data);
+  snapshot->size_ = st.st_size;
+
+  const auto* header = reinterpret_cast<const Header*>(snapshot->data_);
+  if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0) {
+    LOG(ERROR) << "Not an anagram map snapshot: " << filename;
+    return nullptr;
+  }
+  if (header->version != kVersion ||
+      header->letter_string_size != sizeof(LetterString)) {
+    LOG(ERROR) << "Incompatible snapshot version " << header->version
+               << " (LetterString size " << header->letter_string_size
+               << ") in " << filename;
+    return nullptr;
+  }
+  if (header->file_size != snapshot->size_) {
+    LOG(ERROR) << "Truncated snapshot " << filename;
+    return nullptr;
+  }
+  const auto fits = [&snapshot](uint64_t offset, uint64_t count,
+                                size_t element_size) {
+    return offset % 8 == 0 && offset <= snapshot->size_ &&
+           count <= (snapshot->size_ - offset) / element_size;
+  };
+  bool ok = fits(header->words_offset, header->num_words,
+                 sizeof(LetterString)) &&
+            fits(header->blanks_offset, header->num_blanks, sizeof(Letter)) &&
+            fits(header->double_blanks_offset, header->num_double_blanks,
+                 sizeof(std::pair<Letter, Letter>)) &&
+            fits(header->hook_table_offset, header->hook_table_capacity,
+                 sizeof(HookSlot));
+  const auto power_of_two = [](uint64_t capacity) {
+    return capacity != 0 && (capacity & (capacity - 1)) == 0;
+  };
+  ok = ok && power_of_two(header->hook_table_capacity);
+  for (int i = 0; i < 3; ++i) {
+    ok = ok && power_of_two(header->table_capacities[i]) &&
+         fits(header->table_offsets[i], header->table_capacities[i],
+              sizeof(ProductSlot));
+  }
+  if (!ok) {
+    LOG(ERROR) << "Corrupt section offsets in snapshot " << filename;
+    return nullptr;
+  }
+
+  const char* base = snapshot->data_;
+  snapshot->num_words_ = header->num_words;
+  snapshot->words_ =
+      reinterpret_cast<const LetterString*>(base + header->words_offset);
+  snapshot->blanks_ =
+      reinterpret_cast<const Letter*>(base + header->blanks_offset);
+  snapshot->double_blanks_ = reinterpret_cast<const std::pair<Letter, Letter>*>(
+      base + header->double_blanks_offset);
+  for (int i = 0; i < 3; ++i) {
+    snapshot->tables_[i] =
+        reinterpret_cast<const ProductSlot*>(base + header->table_offsets[i]);
+    snapshot->table_masks_[i] = header->table_capacities[i] - 1;
+  }
+  snapshot->hook_table_ =
+      reinterpret_cast<const HookSlot*>(base + header->hook_table_offset);
+  snapshot->hook_table_mask_ = header->hook_table_capacity - 1;
+  return snapshot;
+}
+
+AnagramMapSnapshot::~AnagramMapSnapshot() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+const AnagramMapSnapshot::ProductSlot* AnagramMapSnapshot::Find(
+    const absl::uint128& product, int num_blanks) const {
+  if (num_blanks < 0 || num_blanks > 2) {
+    LOG(INFO) << "Invalid number of blanks: " << num_blanks;
+    return nullptr;
+  }
+  const ProductSlot* table = tables_[num_blanks];
+  const uint64_t mask = table_masks_[num_blanks];
+  const uint64_t low = absl::Uint128Low64(product);
+  const uint64_t high = absl::Uint128High64(product);
+  for (uint64_t i = HashKey(low, high) & mask;; i = (i + 1) & mask) {
+    const ProductSlot& slot = table[i];
+    if (slot.length == 0) {
+      return nullptr;
+    }
+    if (slot.product_low == low && slot.product_high == high) {
+      return &slot;
+    }
+  }
+}
+
+uint32_t AnagramMapSnapshot::Hooks(const LetterString& letter_string) const {
+  uint64_t low;
+  uint64_t high;
+  if (!PackHookKey(letter_string, &low, &high)) {
+    return 0;
+  }
+  const uint32_t length = letter_string.size();
+  for (uint64_t i = HashKey(low, high) & hook_table_mask_;;
+       i = (i + 1) & hook_table_mask_) {
+    const HookSlot& slot = hook_table_[i];
+    if (slot.length == 0) {
+      return 0;
+    }
+    if (slot.key_low == low && slot.key_high == high &&
+        slot.length == length) {
+      return slot.hooks;
+    }
+  }
+}
+
+absl::Status AnagramMapSnapshot::Write(
+    const std::string& filename, absl::Span<const LetterString> words,
+    absl::Span<const Letter> blanks,
+    absl::Span<const std::pair<Letter, Letter>> double_blanks,
+    std::vector<TableEntry> word_entries,
+    std::vector<TableEntry> blank_entries,
+    std::vector<TableEntry> double_blank_entries,
+    const absl::flat_hash_map<LetterString, uint32_t>& hook_map) {
+  // Copy words into zeroed storage so unused letters and padding are
+  // deterministic in the file.
+  std::vector<char> word_bytes(words.size() * sizeof(LetterString), 0);
+  for (size_t i = 0; i < words.size(); ++i) {
+    new (&word_bytes[i * sizeof(LetterString)])
+        LetterString(words[i].begin(), words[i].size());
+  }
+
+  // Entries are inserted in product order so that the same lexicon always
+  // produces the same file.
+  std::vector<TableEntry>* entries[3] = {&word_entries, &blank_entries,
+                                         &double_blank_entries};
+  std::vector<ProductSlot> tables[3];
+  for (int i = 0; i < 3; ++i) {
+    std::sort(entries[i]->begin(), entries[i]->end(),
+              [](const TableEntry& a, const TableEntry& b) {
+                return a.product < b.product;
+              });
+    tables[i].resize(TableCapacity(entries[i]->size()), ProductSlot{0, 0, 0, 0});
+    const uint64_t mask = tables[i].size() - 1;
+    for (const auto& entry : *entries[i]) {
+      if (entry.length == 0) {
+        return absl::InvalidArgumentError("Empty anagram map entry");
+      }
+      const uint64_t low = absl::Uint128Low64(entry.product);
+      const uint64_t high = absl::Uint128High64(entry.product);
+      uint64_t j = HashKey(low, high) & mask;
+      while (tables[i][j].length != 0) {
+        j = (j + 1) & mask;
+      }
+      tables[i][j] = ProductSlot{low, high, entry.begin, entry.length};
+    }
+  }
+
+  struct HookEntry {
+    uint64_t low;
+    uint64_t high;
+    uint32_t hooks;
+    uint32_t length;
+  };
+  std::vector<HookEntry> hook_entries;
+  hook_entries.reserve(hook_map.size());
+  for (const auto& pair : hook_map) {
+    HookEntry entry;
+    if (!PackHookKey(pair.first, &entry.low, &entry.high)) {
+      LOG(WARNING) << "Skipping hook key too long for snapshot";
+      continue;
+    }
+    entry.hooks = pair.second;
+    entry.length = pair.first.size();
+    hook_entries.push_back(entry);
+  }
+  std::sort(hook_entries.begin(), hook_entries.end(),
+            [](const HookEntry& a, const HookEntry& b) {
+              return std::tie(a.high, a.low, a.length) <
+                     std::tie(b.high, b.low, b.length);
+            });
+  std::vector<HookSlot> hook_table(TableCapacity(hook_entries.size()),
+                                   HookSlot{0, 0, 0, 0});
+  const uint64_t hook_mask = hook_table.size() - 1;
+  for (const auto& entry : hook_entries) {
+    uint64_t j = HashKey(entry.low, entry.high) & hook_mask;
+    while (hook_table[j].length != 0) {
+      j = (j + 1) & hook_mask;
+    }
+    hook_table[j] = HookSlot{entry.low, entry.high, entry.hooks, entry.length};
+  }
+
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.letter_string_size = sizeof(LetterString);
+  uint64_t offset = sizeof(Header);
+  header.num_words = words.size();
+  header.words_offset = Align(offset);
+  offset = header.words_offset + word_bytes.size();
+  header.num_blanks = blanks.size();
+  header.blanks_offset = Align(offset);
+  offset = header.blanks_offset + blanks.size() * sizeof(Letter);
+  header.num_double_blanks = double_blanks.size();
+  header.double_blanks_offset = Align(offset);
+  offset = header.double_blanks_offset +
+           double_blanks.size() * sizeof(std::pair<Letter, Letter>);
+  for (int i = 0; i < 3; ++i) {
+    header.table_capacities[i] = tables[i].size();
+    header.table_offsets[i] = Align(offset);
+    offset = header.table_offsets[i] + tables[i].size() * sizeof(ProductSlot);
+  }
+  header.hook_table_capacity = hook_table.size();
+  header.hook_table_offset = Align(offset);
+  offset = header.hook_table_offset + hook_table.size() * sizeof(HookSlot);
+  header.file_size = offset;
+
+  std::ofstream file(filename, std::ios::out | std::ios::binary);
+  if (!file.is_open()) {
+    return absl::NotFoundError("Could not open file " + filename);
+  }
+  uint64_t written = 0;
+  bool ok = WritePadded(file, &header, sizeof(header), &written) &&
+            WritePadded(file, word_bytes.data(), word_bytes.size(), &written) &&
+            WritePadded(file, blanks.data(), blanks.size() * sizeof(Letter),
+                        &written) &&
+            WritePadded(file, double_blanks.data(),
+                        double_blanks.size() * sizeof(std::pair<Letter, Letter>),
+                        &written);
+  for (int i = 0; i < 3; ++i) {
+    ok = ok && WritePadded(file, tables[i].data(),
+                           tables[i].size() * sizeof(ProductSlot), &written);
+  }
+  ok = ok && WritePadded(file, hook_table.data(),
+                         hook_table.size() * sizeof(HookSlot), &written);
+  if (!ok || written != header.file_size) {
+    return absl::InternalError("Could not write to file " + filename);
+  }
+  return absl::OkStatus();
+}
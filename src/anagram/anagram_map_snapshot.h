@@ -0,0 +1,100 @@
+#ifndef SRC_ANAGRAM_ANAGRAM_MAP_SNAPSHOT_H
+#define SRC_ANAGRAM_ANAGRAM_MAP_SNAPSHOT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/numeric/int128.h"
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "src/scrabble/strings.h"
+
+// Read-only view of an AnagramMap stored as a flat snapshot file (.qas). The
+// file holds the word, blank and double-blank arrays followed by open
+// addressing tables keyed by prime product, plus the hook table, all in the
+// in-memory layout. Opening a snapshot just maps the file, so processes using
+// the same lexicon share its pages and there is nothing to parse or rebuild.
+class AnagramMapSnapshot {
+ public:
+  // Table slot for a product's run of words, blank letters or blank pairs.
+  // Empty slots have length 0.
+  struct ProductSlot {
+    uint64_t product_low;
+    uint64_t product_high;
+    uint32_t begin;
+    uint32_t length;
+  };
+
+  // Hook table slot. The key is a LetterString with one 0 (the hook square),
+  // packed 5 bits per letter, 12 letters per word.
+  struct HookSlot {
+    uint64_t key_low;
+    uint64_t key_high;
+    uint32_t hooks;
+    uint32_t length;
+  };
+
+  struct TableEntry {
+    absl::uint128 product;
+    uint32_t begin;
+    uint32_t length;
+  };
+
+  static std::unique_ptr<AnagramMapSnapshot> Open(const std::string& filename);
+
+  // True iff the file starts with the snapshot magic.
+  static bool IsSnapshotFile(const std::string& filename);
+
+  // Entries are (product, begin, length) runs within the corresponding array.
+  static absl::Status Write(
+      const std::string& filename, absl::Span<const LetterString> words,
+      absl::Span<const Letter> blanks,
+      absl::Span<const std::pair<Letter, Letter>> double_blanks,
+      std::vector<TableEntry> word_entries,
+      std::vector<TableEntry> blank_entries,
+      std::vector<TableEntry> double_blank_entries,
+      const absl::flat_hash_map<LetterString, uint32_t>& hook_map);
+
+  ~AnagramMapSnapshot();
+
+  // Returns nullptr if there is no entry for product with this many blanks.
+  const ProductSlot* Find(const absl::uint128& product, int num_blanks) const;
+
+  absl::Span<const LetterString> Words(const ProductSlot& slot) const {
+    return absl::MakeConstSpan(words_ + slot.begin, slot.length);
+  }
+  absl::Span<const Letter> Blanks(const ProductSlot& slot) const {
+    return absl::MakeConstSpan(blanks_ + slot.begin, slot.length);
+  }
+  absl::Span<const std::pair<Letter, Letter>> DoubleBlanks(
+      const ProductSlot& slot) const {
+    return absl::MakeConstSpan(double_blanks_ + slot.begin, slot.length);
+  }
+
+  uint32_t Hooks(const LetterString& letter_string) const;
+
+  size_t NumWords() const { return num_words_; }
+
+ private:
+  AnagramMapSnapshot() = default;
+
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  size_t num_words_ = 0;
+  const LetterString* words_ = nullptr;
+  const Letter* blanks_ = nullptr;
+  const std::pair<Letter, Letter>* double_blanks_ = nullptr;
+
+  // Indexed by number of blanks.
+  const ProductSlot* tables_[3] = {nullptr, nullptr, nullptr};
+  uint64_t table_masks_[3] = {0, 0, 0};
+
+  const HookSlot* hook_table_ = nullptr;
+  uint64_t hook_table_mask_ = 0;
+};
+
+#endif  // SRC_ANAGRAM_ANAGRAM_MAP_SNAPSHOT_H
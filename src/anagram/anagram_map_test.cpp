@@ -19,6 +19,7 @@ using ::google::protobuf::TextFormat;
 using ::google::protobuf::util::MessageDifferencer;
 using ::google::protobuf::util::ParseDelimitedFromZeroCopyStream;
 using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
 using ::testing::Pair;
 using ::testing::UnorderedElementsAre;
 
@@ -68,7 +69,7 @@ TEST_F(AnagramMapTest, CreateFromTextfile2) {
   ASSERT_NE(anagram_map, nullptr);
   EXPECT_EQ(anagram_map->map_.size(), 39317);
   const auto words = anagram_map->Words(P("AEIOUCNRT"));
-  ASSERT_NE(words, nullptr);
+  ASSERT_NE(words, absl::nullopt);
   EXPECT_THAT(*words, ElementsAre(LS("AUTOCRINE"), LS("CAUTIONER"),
                                   LS("COINTREAU"), LS("RECAUTION")));
 
@@ -286,7 +287,7 @@ TEST_F(AnagramMapTest, CreateFromBinaryFile2) {
   EXPECT_TRUE(anagram_map->HasWord(it));
   EXPECT_TRUE(anagram_map->HasWord(P("AEIOUCNRT"), 0));
   const auto words = anagram_map->Words(P("AEIOUCNRT"));
-  ASSERT_NE(words, nullptr);
+  ASSERT_NE(words, absl::nullopt);
   EXPECT_THAT(*words, ElementsAre(LS("AUTOCRINE"), LS("CAUTIONER"),
                                   LS("COINTREAU"), LS("RECAUTION")));
 
@@ -377,3 +378,51 @@ TEST_F(AnagramMapTest, CreateFromBinaryFile2) {
       (1 << L('H')) | (1 << L('P')) | (1 << L('T'));
   EXPECT_EQ(anagram_map->Hooks(has_ing), has_ing_expected_hooks);
 }
+
+TEST_F(AnagramMapTest, WriteToSnapshotFile) {
+  const std::string input_filepath = "src/anagram/testdata/csw21nines.txt";
+  auto anagram_map = AnagramMap::CreateFromTextfile(*tiles_, input_filepath);
+  ASSERT_NE(anagram_map, nullptr);
+  const std::string snapshot_filepath =
+      testing::TempDir() + "csw21nines.qas";
+  ASSERT_TRUE(anagram_map->WriteToSnapshotFile(snapshot_filepath).ok());
+
+  // CreateFromBinaryFile recognizes the snapshot too.
+  auto snapshot_map =
+      AnagramMap::CreateFromBinaryFile(*tiles_, snapshot_filepath);
+  ASSERT_NE(snapshot_map, nullptr);
+  EXPECT_TRUE(snapshot_map->map_.empty());
+  EXPECT_FALSE(snapshot_map->WriteToSnapshotFile(snapshot_filepath).ok());
+
+  for (const auto& pair : anagram_map->map_) {
+    const auto words = snapshot_map->Words(pair.first);
+    ASSERT_NE(words, absl::nullopt);
+    EXPECT_THAT(*words, ElementsAreArray(pair.second));
+  }
+  for (const auto& pair : anagram_map->blank_map_) {
+    const auto blanks = snapshot_map->Blanks(pair.first);
+    ASSERT_NE(blanks, absl::nullopt);
+    EXPECT_THAT(*blanks, ElementsAreArray(pair.second));
+  }
+  for (const auto& pair : anagram_map->double_blank_map_) {
+    const auto double_blanks = snapshot_map->DoubleBlanks(pair.first);
+    ASSERT_NE(double_blanks, absl::nullopt);
+    EXPECT_THAT(*double_blanks, ElementsAreArray(pair.second));
+  }
+  for (const auto& pair : anagram_map->hook_map_) {
+    EXPECT_EQ(snapshot_map->Hooks(pair.first), pair.second);
+  }
+  EXPECT_EQ(snapshot_map->Hooks(LS("QQQ.")), 0);
+  EXPECT_FALSE(snapshot_map->HasWord(P("STRONCK"), 0));
+  EXPECT_EQ(snapshot_map->Words(P("STRONCK")), absl::nullopt);
+
+  auto it = snapshot_map->WordIterator(P("STRONCK"), 2);
+  EXPECT_TRUE(snapshot_map->HasWord(it));
+  const auto it_range = snapshot_map->Words(it, P("STRONCK"));
+  auto span_join = it_range.Spans() | ranges::view::join;
+  const auto range_words =
+      std::vector<LetterString>(span_join.begin(), span_join.end());
+  EXPECT_THAT(range_words, ElementsAre(LS("CORNSTALK"), LS("TURNCOCKS"),
+                                       LS("COKERNUTS"), LS("ORESTUNCK"),
+                                       LS("STOCKHORN")));
+}
@@ -7,22 +7,48 @@
 #include "src/anagram/anagram_map.h"
 
 ABSL_FLAG(std::string, input_textfile, "", "input .txt file path");
+ABSL_FLAG(std::string, input_binary_file, "",
+          "input .qam file path, used instead of input_textfile");
 ABSL_FLAG(std::string, output_file, "", "output .qam file path");
+ABSL_FLAG(std::string, output_snapshot_file, "",
+          "output .qas snapshot file path (memory-mapped at load time)");
 
 int main(int argc, char *argv[]) {
   absl::ParseCommandLine(argc, argv);
   LOG(INFO) << "Hello world!" << std::endl;
   LOG(INFO) << "input_textfile: " << absl::GetFlag(FLAGS_input_textfile);
+  LOG(INFO) << "input_binary_file: " << absl::GetFlag(FLAGS_input_binary_file);
   LOG(INFO) << "output_file: " << absl::GetFlag(FLAGS_output_file);
+  LOG(INFO) << "output_snapshot_file: "
+            << absl::GetFlag(FLAGS_output_snapshot_file);
 
   auto tiles = absl::make_unique<Tiles>(
         "src/anagram/testdata/english_scrabble_tiles.textproto");
 
-  std::unique_ptr<AnagramMap> anagram_map = AnagramMap::CreateFromTextfile(
-      *tiles, absl::GetFlag(FLAGS_input_textfile));
-  if (!anagram_map->WriteToBinaryFile(absl::GetFlag(FLAGS_output_file)).ok()) {
+  std::unique_ptr<AnagramMap> anagram_map;
+  if (!absl::GetFlag(FLAGS_input_binary_file).empty()) {
+    anagram_map = AnagramMap::CreateFromBinaryFile(
+        *tiles, absl::GetFlag(FLAGS_input_binary_file));
+  } else {
+    anagram_map = AnagramMap::CreateFromTextfile(
+        *tiles, absl::GetFlag(FLAGS_input_textfile));
+  }
+  if (anagram_map == nullptr) {
+    LOG(ERROR) << "Failed to read anagram map";
+    return 1;
+  }
+  if (!absl::GetFlag(FLAGS_output_file).empty() &&
+      !anagram_map->WriteToBinaryFile(absl::GetFlag(FLAGS_output_file)).ok()) {
     LOG(ERROR) << "Failed to write to file: " << absl::GetFlag(FLAGS_output_file);
     return 1;
   }
+  if (!absl::GetFlag(FLAGS_output_snapshot_file).empty()) {
+    const auto status = anagram_map->WriteToSnapshotFile(
+        absl::GetFlag(FLAGS_output_snapshot_file));
+    if (!status.ok()) {
+      LOG(ERROR) << "Failed to write snapshot: " << status;
+      return 1;
+    }
+  }
   return 0;
-}
\ No newline at end of file
+}
@@ -1,10 +1,17 @@
 #include "src/leaves/leaves.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
 
+#include "absl/memory/memory.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_split.h"
 #include "glog/logging.h"
@@ -14,9 +21,74 @@
 
 using google::protobuf::Arena;
 
+constexpr int Leaves::kMaxLeaveSize;
+constexpr float Leaves::kMissingLeaveValue;
+constexpr uint32_t Leaves::kInvalidOffset;
+
+namespace {
+constexpr char kMagic[8] = {'Q', '2', 'L', 'E', 'A', 'V', 'E', 'S'};
+constexpr uint32_t kVersion = 1;
+
+// Fixed-layout file header, followed directly by num_values floats in rank
+// order. The distribution is recorded so a table is never read against tiles
+// it was not ranked with.
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t max_leave_size;
+  uint32_t num_letter_types;
+  uint32_t reserved;
+  int32_t distribution[32];
+  uint64_t num_values;
+};
+}  // namespace
+
+Leaves::Leaves(const Tiles& tiles) : num_letter_types_(tiles.BlankIndex()) {
+  CHECK_LT(num_letter_types_, 32);
+  distribution_.fill(0);
+  for (int letter = 1; letter <= num_letter_types_; ++letter) {
+    distribution_[letter] = tiles.Count(letter);
+  }
+  // ways[letter][remaining]: number of leaves of at most remaining tiles
+  // using only this and later letters.
+  uint64_t ways[33][kMaxLeaveSize + 1];
+  for (int remaining = 0; remaining <= kMaxLeaveSize; ++remaining) {
+    ways[num_letter_types_ + 1][remaining] = 1;
+  }
+  for (int letter = num_letter_types_; letter >= 1; --letter) {
+    for (int remaining = 0; remaining <= kMaxLeaveSize; ++remaining) {
+      uint64_t offset = 0;
+      for (int count = 0; count <= kMaxLeaveSize; ++count) {
+        if (count > remaining || count > distribution_[letter]) {
+          offsets_[letter][remaining][count] = kInvalidOffset;
+          continue;
+        }
+        offsets_[letter][remaining][count] = offset;
+        offset += ways[letter + 1][remaining - count];
+      }
+      ways[letter][remaining] = offset;
+    }
+  }
+  num_values_ = ways[1][kMaxLeaveSize];
+  CHECK_LT(num_values_, kInvalidOffset);
+}
+
+Leaves::~Leaves() {
+  if (mapped_data_ != nullptr) {
+    munmap(mapped_data_, mapped_size_);
+  }
+}
+
+void Leaves::AllocateValues() {
+  owned_values_.assign(num_values_, kMissingLeaveValue);
+  values_ = owned_values_.data();
+}
+
 std::unique_ptr<Leaves> Leaves::CreateFromCsv(const Tiles& tiles,
                                               const std::string& filename) {
-  auto leaves = absl::make_unique<Leaves>();
+  auto leaves = absl::make_unique<Leaves>(tiles);
+  leaves->AllocateValues();
+  std::vector<bool> seen(leaves->num_values_, false);
   std::ifstream input(filename);
   if (!input) {
     LOG(ERROR) << "Failed to open " << filename;
@@ -35,14 +107,11 @@ std::unique_ptr<Leaves> Leaves::CreateFromCsv(const Tiles& tiles,
       LOG(INFO) << "Invalid tiles: " << letters;
       return nullptr;
     }
-    const absl::uint128 product = tiles.ToProduct(*letter_string);
-    absl::uint128 big_threshold = 1;
-    big_threshold <<= 64;
-    if (product > big_threshold) {
-      LOG(INFO) << "Product too large for tiles: " << letters;
+    const int64_t rank = leaves->Rank(*letter_string);
+    if (rank < 0) {
+      LOG(INFO) << "Not a valid leave for tiles: " << letters;
       return nullptr;
     }
-    const uint64_t small_product = static_cast<uint64_t>(product);
 
     const auto& float_string = tokens[1];
     float value;
@@ -51,20 +120,90 @@ std::unique_ptr<Leaves> Leaves::CreateFromCsv(const Tiles& tiles,
       LOG(INFO) << "Could not parse float: " << float_string;
       return nullptr;
     }
-    if (leaves->leave_map_.count(small_product) > 0) {
+    if (seen[rank]) {
       LOG(ERROR) << "Duplicate entries for tiles: " << letters;
       return nullptr;
     }
-    leaves->leave_map_[small_product] = value;
+    seen[rank] = true;
+    leaves->owned_values_[rank] = value;
   }
-  leaves->leave_map_[1] = 0.0;  // add empty leave in case it's missing
+  leaves->owned_values_[0] = 0.0;  // empty leave, in case it's missing
   return leaves;
 }
 
 std::unique_ptr<Leaves> Leaves::CreateFromBinaryFile(
     const Tiles& tiles, const std::string& filename) {
   LOG(INFO) << "CreateFromBinaryFile(...) filename: " << filename;
-  auto leaves = absl::make_unique<Leaves>();
+  std::ifstream file(filename, std::ios::in | std::ios::binary);
+  if (!file.is_open()) {
+    LOG(ERROR) << "Could not open file " << filename;
+    return nullptr;
+  }
+  char magic[sizeof(kMagic)];
+  if (file.read(magic, sizeof(magic)) &&
+      std::memcmp(magic, kMagic, sizeof(kMagic)) == 0) {
+    return CreateFromSnapshotFile(tiles, filename);
+  }
+  return CreateFromProtoFile(tiles, filename);
+}
+
+std::unique_ptr<Leaves> Leaves::CreateFromSnapshotFile(
+    const Tiles& tiles, const std::string& filename) {
+  auto leaves = absl::make_unique<Leaves>(tiles);
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(ERROR) << "Could not open file " << filename;
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(Header)) {
+    LOG(ERROR) << "Could not stat leaves file " << filename;
+    close(fd);
+    return nullptr;
+  }
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    LOG(ERROR) << "Could not mmap leaves file " << filename;
+    return nullptr;
+  }
+  leaves->mapped_data_ = data;
+  leaves->mapped_size_ = st.st_size;
+
+  const auto* header = static_cast<const Header*>(data);
+  if (header->version != kVersion ||
+      header->max_leave_size != kMaxLeaveSize ||
+      header->num_letter_types != leaves->num_letter_types_ ||
+      header->num_values != leaves->num_values_) {
+    LOG(ERROR) << "Leaves file " << filename
+               << " was not built for these tiles with this version";
+    return nullptr;
+  }
+  for (int letter = 0; letter < 32; ++letter) {
+    if (header->distribution[letter] != leaves->distribution_[letter]) {
+      LOG(ERROR) << "Leaves file " << filename
+                 << " has a different tile distribution";
+      return nullptr;
+    }
+  }
+  if (sizeof(Header) + leaves->num_values_ * sizeof(float) !=
+      leaves->mapped_size_) {
+    LOG(ERROR) << "Leaves file " << filename << " has the wrong size";
+    return nullptr;
+  }
+  leaves->values_ = reinterpret_cast<const float*>(
+      static_cast<const char*>(data) + sizeof(Header));
+  LOG(INFO) << "Mapped " << leaves->num_values_ << " leaves.";
+  return leaves;
+}
+
+// Older .qlv files are a delimited q2::proto::Leaves keyed by prime product.
+std::unique_ptr<Leaves> Leaves::CreateFromProtoFile(
+    const Tiles& tiles, const std::string& filename) {
+  auto leaves = absl::make_unique<Leaves>(tiles);
+  leaves->AllocateValues();
+  std::vector<bool> seen(leaves->num_values_, false);
   std::ifstream file(filename, std::ios::in | std::ios::binary);
   if (!file.is_open()) {
     LOG(ERROR) << "Could not open file " << filename;
@@ -80,18 +219,31 @@ std::unique_ptr<Leaves> Leaves::CreateFromBinaryFile(
     LOG(ERROR) << "Could not parse file " << filename;
     return nullptr;
   }
-  leaves->leave_map_.reserve(proto_leaves->leaves_size());
   for (const auto& leave : proto_leaves->leaves()) {
-    const auto& product = leave.product();
-    const auto& value = leave.value();
-    if (leaves->leave_map_.count(product) > 0) {
-      LOG(ERROR) << "Duplicate entries for product: " << product;
+    uint64_t product = leave.product();
+    LetterString letters;
+    for (Letter letter = tiles.FirstLetter(); letter <= tiles.BlankIndex();
+         ++letter) {
+      const uint64_t prime = tiles.Prime(letter);
+      while (product % prime == 0 && letters.size() <= kMaxLeaveSize) {
+        letters.push_back(letter);
+        product /= prime;
+      }
+    }
+    const int64_t rank = (product == 1) ? leaves->Rank(letters) : -1;
+    if (rank < 0) {
+      LOG(ERROR) << "Not a valid leave product: " << leave.product();
+      return nullptr;
+    }
+    if (seen[rank]) {
+      LOG(ERROR) << "Duplicate entries for product: " << leave.product();
       return nullptr;
     }
-    leaves->leave_map_[product] = value;
+    seen[rank] = true;
+    leaves->owned_values_[rank] = leave.value();
   }
-  leaves->leave_map_[1] = 0.0;  // add empty leave in case it's missing
-  LOG(INFO) << "Loaded " << leaves->leave_map_.size() << " leaves.";
+  leaves->owned_values_[0] = 0.0;  // empty leave, in case it's missing
+  LOG(INFO) << "Loaded " << proto_leaves->leaves_size() << " leaves.";
   return leaves;
 }
 
@@ -107,15 +259,18 @@ absl::Status Leaves::WriteToBinaryFile(const std::string& filename) const {
 }
 
 bool Leaves::WriteToOstream(std::ostream& os) const {
-  Arena arena;
-  auto leaves = Arena::CreateMessage<q2::proto::Leaves>(&arena);
-  for (const auto& entry : leave_map_) {
-    auto* leave = leaves->add_leaves();
-    leave->set_product(entry.first);
-    leave->set_value(entry.second);
-  }
-  if (!google::protobuf::util::SerializeDelimitedToOstream(*leaves, &os)) {
-    return false;
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.max_leave_size = kMaxLeaveSize;
+  header.num_letter_types = num_letter_types_;
+  for (int letter = 0; letter < 32; ++letter) {
+    header.distribution[letter] = distribution_[letter];
   }
-  return true;
-}
\ No newline at end of file
+  header.num_values = num_values_;
+  os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  os.write(reinterpret_cast<const char*>(values_),
+           num_values_ * sizeof(float));
+  return os.good();
+}
@@ -1,35 +1,112 @@
 #ifndef SRC_LEAVES_LEAVES_H
 #define SRC_LEAVES_LEAVES_H
 
-#include "absl/container/flat_hash_map.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "absl/status/status.h"
 #include "glog/logging.h"
 #include "src/scrabble/tiles.h"
 
+// Leave values stored in a dense table indexed by the combinatorial rank of
+// the leave's multiset of tiles under the Tiles distribution, so a lookup is a
+// handful of adds and one load rather than a hash probe. Every multiset of at
+// most kMaxLeaveSize tiles drawable from the bag has a slot; leaves missing
+// from the input, leaves with too many tiles and leaves that cannot be drawn
+// all have kMissingLeaveValue.
+//
+// The binary format (.qlv) is the table itself behind a small header, and is
+// mapped read-only so processes using the same leaves share its pages. Files
+// in the older protobuf-delimited format are still accepted by
+// CreateFromBinaryFile.
 class Leaves {
  public:
+  static constexpr int kMaxLeaveSize = 6;
+  static constexpr float kMissingLeaveValue = 0.0;
+
   static std::unique_ptr<Leaves> CreateFromCsv(const Tiles& tiles,
                                                const std::string& filename);
   static std::unique_ptr<Leaves> CreateFromBinaryFile(
       const Tiles& tiles, const std::string& filename);
   absl::Status WriteToBinaryFile(const std::string& filename) const;
 
-  float Value(uint64_t product) const;
+  explicit Leaves(const Tiles& tiles);
+  ~Leaves();
+  Leaves(const Leaves&) = delete;
+  Leaves& operator=(const Leaves&) = delete;
+
+  // Letters need not be sorted. Designated blanks are not valid leave tiles.
+  float Value(const LetterString& leave) const;
+
+  size_t NumValues() const { return num_values_; }
 
  private:
+  static constexpr uint32_t kInvalidOffset = 0xFFFFFFFF;
+
+  static std::unique_ptr<Leaves> CreateFromSnapshotFile(
+      const Tiles& tiles, const std::string& filename);
+  static std::unique_ptr<Leaves> CreateFromProtoFile(
+      const Tiles& tiles, const std::string& filename);
+
+  // Returns -1 for leaves that have no slot in the table.
+  int64_t Rank(const LetterString& leave) const;
+
+  // Allocates an owned table with every value set to kMissingLeaveValue.
+  void AllocateValues();
   bool WriteToOstream(std::ostream& os) const;
 
-  absl::flat_hash_map<uint64_t, float> leave_map_;
+  const int num_letter_types_;
+  std::array<int, 32> distribution_;
+
+  // offsets_[letter][remaining][count] is the number of leaves ranked before
+  // those taking count of this letter, given that leaves are ordered by their
+  // counts of each letter in turn and at most remaining tiles are left for
+  // this and later letters. kInvalidOffset if count exceeds the distribution.
+  uint32_t offsets_[32][kMaxLeaveSize + 1][kMaxLeaveSize + 1];
+  size_t num_values_ = 0;
+
+  const float* values_ = nullptr;
+  std::vector<float> owned_values_;
+  void* mapped_data_ = nullptr;
+  size_t mapped_size_ = 0;
 };
 
-inline float Leaves::Value(uint64_t product) const {
-  const auto it = leave_map_.find(product);
-  /*
-  if (it == leave_map_.end()) {
-    LOG(ERROR) << "No leave value for product " << product;
-    return 0.0;
+inline int64_t Leaves::Rank(const LetterString& leave) const {
+  if (leave.size() > kMaxLeaveSize) {
+    return -1;
+  }
+  std::array<uint8_t, 32> counts = {0};
+  for (Letter letter : leave) {
+    if (letter < 1 || letter > num_letter_types_) {
+      return -1;
+    }
+    counts[letter]++;
+  }
+  int64_t rank = 0;
+  int remaining = kMaxLeaveSize;
+  for (int letter = 1; letter <= num_letter_types_; ++letter) {
+    const int count = counts[letter];
+    if (count == 0) {
+      continue;
+    }
+    const uint32_t offset = offsets_[letter][remaining][count];
+    if (offset == kInvalidOffset) {
+      return -1;
+    }
+    rank += offset;
+    remaining -= count;
+  }
+  return rank;
+}
+
+inline float Leaves::Value(const LetterString& leave) const {
+  const int64_t rank = Rank(leave);
+  if (rank < 0) {
+    return kMissingLeaveValue;
   }
-  */
-  return it->second;
+  return values_[rank];
 }
-#endif  // SRC_LEAVES_LEAVES_H
\ No newline at end of file
+#endif  // SRC_LEAVES_LEAVES_H
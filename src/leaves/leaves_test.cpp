@@ -25,24 +25,39 @@ TEST_F(LeavesTest, CreateFromCsv) {
   const std::string input_filepath = "src/leaves/testdata/macondo.csv";
   auto leaves = Leaves::CreateFromCsv(*tiles_, input_filepath);
   ASSERT_NE(leaves, nullptr);
-  EXPECT_FLOAT_EQ(leaves->Value(1), 0.0);
-  uint64_t i_product = tiles_->Prime(L('I'));
-  EXPECT_FLOAT_EQ(leaves->Value(i_product), 0.7403481220894292);
-  EXPECT_FLOAT_EQ(leaves->Value(1009 /* big prime */), 0.0 /* default */);
-  uint64_t anise_blank_product =
-      static_cast<uint64_t>(tiles_->ToProduct(LS("AEINS?")));
-  EXPECT_FLOAT_EQ(leaves->Value(anise_blank_product), 38.35431501026073);
+  EXPECT_FLOAT_EQ(leaves->Value(LetterString()), 0.0);
+  EXPECT_FLOAT_EQ(leaves->Value(LS("I")), 0.7403481220894292);
+  EXPECT_FLOAT_EQ(leaves->Value(LS("AEINS?")), 38.35431501026073);
+  EXPECT_FLOAT_EQ(leaves->Value(LS("SANIE?")), 38.35431501026073);
+  EXPECT_FLOAT_EQ(leaves->Value(LS("QQ")), Leaves::kMissingLeaveValue);
+  EXPECT_FLOAT_EQ(leaves->Value(LS("AEINST?")), Leaves::kMissingLeaveValue);
 }
 
 TEST_F(LeavesTest, CreateFromBinaryFile) {
   const std::string input_filepath = "src/leaves/testdata/macondo.qlv";
   auto leaves = Leaves::CreateFromBinaryFile(*tiles_, input_filepath);
   ASSERT_NE(leaves, nullptr);
-  EXPECT_FLOAT_EQ(leaves->Value(1), 0.0);
-  uint64_t i_product = tiles_->Prime(L('I'));
-  EXPECT_FLOAT_EQ(leaves->Value(i_product), 0.7403481220894292);
-  EXPECT_FLOAT_EQ(leaves->Value(1009 /* big prime */), 0.0 /* default */);
-  uint64_t anise_blank_product =
-      static_cast<uint64_t>(tiles_->ToProduct(LS("AEINS?")));
-  EXPECT_FLOAT_EQ(leaves->Value(anise_blank_product), 38.35431501026073);
-}
\ No newline at end of file
+  EXPECT_FLOAT_EQ(leaves->Value(LetterString()), 0.0);
+  EXPECT_FLOAT_EQ(leaves->Value(LS("I")), 0.7403481220894292);
+  EXPECT_FLOAT_EQ(leaves->Value(LS("AEINS?")), 38.35431501026073);
+  EXPECT_FLOAT_EQ(leaves->Value(LS("SANIE?")), 38.35431501026073);
+  EXPECT_FLOAT_EQ(leaves->Value(LS("QQ")), Leaves::kMissingLeaveValue);
+  EXPECT_FLOAT_EQ(leaves->Value(LS("AEINST?")), Leaves::kMissingLeaveValue);
+}
+
+TEST_F(LeavesTest, WriteToBinaryFile) {
+  auto leaves =
+      Leaves::CreateFromCsv(*tiles_, "src/leaves/testdata/macondo.csv");
+  ASSERT_NE(leaves, nullptr);
+  const std::string filename = testing::TempDir() + "macondo_table.qlv";
+  ASSERT_TRUE(leaves->WriteToBinaryFile(filename).ok());
+  auto mapped = Leaves::CreateFromBinaryFile(*tiles_, filename);
+  ASSERT_NE(mapped, nullptr);
+  EXPECT_EQ(mapped->NumValues(), leaves->NumValues());
+  for (const std::string leave :
+       {"", "I", "Q", "QU", "EEE", "AEINS?", "ERS", "VVW", "??"}) {
+    EXPECT_FLOAT_EQ(mapped->Value(LS(leave)), leaves->Value(LS(leave)))
+        << leave;
+  }
+  EXPECT_FLOAT_EQ(mapped->Value(LS("QQ")), Leaves::kMissingLeaveValue);
+}
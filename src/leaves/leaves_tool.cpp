@@ -7,22 +7,34 @@
 #include "src/leaves/leaves.h"
 
 ABSL_FLAG(std::string, input_csv, "", "input .csv file path");
+ABSL_FLAG(std::string, input_binary_file, "",
+          "input .qlv file path (either format), used instead of input_csv");
 ABSL_FLAG(std::string, output_file, "", "output .qlv file path");
 
 int main(int argc, char *argv[]) {
   absl::ParseCommandLine(argc, argv);
   LOG(INFO) << "Hello world!" << std::endl;
   LOG(INFO) << "input_csv: " << absl::GetFlag(FLAGS_input_csv);
+  LOG(INFO) << "input_binary_file: " << absl::GetFlag(FLAGS_input_binary_file);
   LOG(INFO) << "output_file: " << absl::GetFlag(FLAGS_output_file);
 
   auto tiles = absl::make_unique<Tiles>(
         "src/leaves/testdata/english_scrabble_tiles.textproto");
 
-  std::unique_ptr<Leaves> leaves = Leaves::CreateFromCsv(
-      *tiles, absl::GetFlag(FLAGS_input_csv));
+  std::unique_ptr<Leaves> leaves;
+  if (!absl::GetFlag(FLAGS_input_binary_file).empty()) {
+    leaves = Leaves::CreateFromBinaryFile(
+        *tiles, absl::GetFlag(FLAGS_input_binary_file));
+  } else {
+    leaves = Leaves::CreateFromCsv(*tiles, absl::GetFlag(FLAGS_input_csv));
+  }
+  if (leaves == nullptr) {
+    LOG(ERROR) << "Failed to read leaves";
+    return 1;
+  }
   if (!leaves->WriteToBinaryFile(absl::GetFlag(FLAGS_output_file)).ok()) {
     LOG(ERROR) << "Failed to write to file: " << absl::GetFlag(FLAGS_output_file);
     return 1;
   }
   return 0;
-}
\ No newline at end of file
+}
@@ -134,35 +134,39 @@ absl::flat_hash_map<uint64_t, std::array<int, 8>> MakeRackWordSizesMap(
         continue;
       }
       const uint64_t key = MagpieRackToUint64(s);
-      if (map.find(key) == map.end()) {
+      const auto it = map.find(key);
+      if (it == map.end()) {
         //LOG(INFO) << "impossible rack: " << MagpieRackToString(s);
         continue;
       }
-      if (map[key][played_through] < s.num_elements) {
-        map[key][played_through] = s.num_elements;
+      if (it->second[played_through] < s.num_elements) {
+        it->second[played_through] = s.num_elements;
       }
     }
   }
   for (int num_elements = 1; num_elements < max_size; num_elements++) {
     for (const auto& s : subselections) {
-      const uint64_t key1 = MagpieRackToUint64(s);
       if (s.num_elements != num_elements) {
         continue;
       }
-      if (map.find(key1) == map.end()) {
+      const uint64_t key1 = MagpieRackToUint64(s);
+      const auto it1 = map.find(key1);
+      if (it1 == map.end()) {
         //LOG(INFO) << "impossible rack: " << MagpieRackToString(s);
         continue;
       }
+      const std::array<int, 8> sizes1 = it1->second;
       const std::vector<MagpieRack> with_extra_tile = AddTile(s);
       for (const auto& s_plus_tile : with_extra_tile) {
         const uint64_t key2 = MagpieRackToUint64(s_plus_tile);
-        if (map.find(key2) == map.end()) {
+        const auto it2 = map.find(key2);
+        if (it2 == map.end()) {
           //LOG(INFO) << "impossible rack: " << MagpieRackToString(s_plus_tile);
           continue;
         }
         for (int i = 0; i <= max_playthrough; ++i) {
-          if (map[key2][i] < map[key1][i]) {
-            map[key2][i] = map[key1][i];
+          if (it2->second[i] < sizes1[i]) {
+            it2->second[i] = sizes1[i];
           }
         }
       }
@@ -20,6 +20,8 @@ MagpieRack MagpieRackFromString(const std::string& letters);
 std::string MagpieRackToString(const MagpieRack& rack);
 uint64_t MagpieRackToUint64(const MagpieRack& rack);
 
+// Reference implementation, kept for tests. RackWordSizes builds the same
+// table much faster and with far less memory.
 absl::flat_hash_map<uint64_t, std::array<int, 8>> MakeRackWordSizesMap(
     const std::vector<std::string>& words, const MagpieRack& bag, int max_size,
     int max_playthrough);
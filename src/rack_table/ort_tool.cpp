@@ -3,6 +3,7 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -10,16 +11,22 @@
 #include "absl/flags/flag.h"
 #include "absl/flags/parse.h"
 #include "absl/flags/usage.h"
-#include "absl/strings/str_join.h"
 #include "glog/logging.h"
 #include "src/rack_table/magpie_rack.h"
+#include "src/rack_table/rack_word_sizes.h"
 
 ABSL_FLAG(std::string, input_wordlist, "", "input .txt file path");
-ABSL_FLAG(std::string, output_word_sizes, "", "output .txt file path");
+ABSL_FLAG(std::string, output_word_sizes, "",
+          "optional output .txt file path");
 ABSL_FLAG(int, num_buckets, 0, "number of hash table buckets");
 
-ABSL_FLAG(std::string, input_word_sizes, "", "input .txt file path");
+ABSL_FLAG(std::string, input_word_sizes, "",
+          "input .txt file path, converted to .ort instead of building from "
+          "input_wordlist");
 ABSL_FLAG(std::string, output_ort, "", "output .ort file path");
+ABSL_FLAG(int, num_threads, 0,
+          "threads used to build from input_wordlist (0 for one per core), "
+          "capped so their tables fit in 1 GiB");
 
 bool IsPrime(int num_buckets) {
   if (num_buckets < 2) {
@@ -110,8 +117,9 @@ int main(int argc, char* argv[]) {
   absl::ParseCommandLine(argc, argv);
   const std::string input_wordlist = absl::GetFlag(FLAGS_input_wordlist);
   const std::string input_word_sizes = absl::GetFlag(FLAGS_input_word_sizes);
+  const std::string output_ort = absl::GetFlag(FLAGS_output_ort);
   const int num_buckets = absl::GetFlag(FLAGS_num_buckets);
-  if (!input_word_sizes.empty()) {
+  if (!output_ort.empty()) {
     const bool is_prime = IsPrime(num_buckets);
     if (!is_prime) {
       if (num_buckets > 3) {
@@ -122,7 +130,13 @@ int main(int argc, char* argv[]) {
       std::cout << "num_buckets must be prime" << std::endl;
       return 1;
     }
-    WriteOrt(input_word_sizes, absl::GetFlag(FLAGS_output_ort), num_buckets);
+  }
+  if (!input_word_sizes.empty()) {
+    if (output_ort.empty()) {
+      std::cout << "output_ort is required with input_word_sizes" << std::endl;
+      return 1;
+    }
+    WriteOrt(input_word_sizes, output_ort, num_buckets);
     return 0;
   }
 
@@ -139,16 +153,26 @@ int main(int argc, char* argv[]) {
 
   const int rack_size = 7;
   const int max_playthrough = 5;
-  const auto map =
-      MakeRackWordSizesMap(words, english_bag, rack_size, max_playthrough);
+  int num_threads = absl::GetFlag(FLAGS_num_threads);
+  if (num_threads <= 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  LOG(INFO) << "Building rack word sizes for " << words.size()
+            << " words on " << num_threads << " threads";
+  RackWordSizes rack_word_sizes(english_bag, rack_size, max_playthrough);
+  rack_word_sizes.Build(words, num_threads);
+
   const std::string output_word_sizes = absl::GetFlag(FLAGS_output_word_sizes);
-  std::ofstream output(output_word_sizes);
-  for (const auto& pair : map) {
-    const auto& key = pair.first;
-    const auto& value = pair.second;
-    const auto kth = std::next(value.begin(), max_playthrough + 1);
-    const std::string value_string = absl::StrJoin(value.begin(), kth, " ");
-    output << key << " " << value_string << std::endl;
+  if (!output_word_sizes.empty()) {
+    std::ofstream output(output_word_sizes);
+    rack_word_sizes.WriteWordSizes(output);
+  }
+  if (!output_ort.empty()) {
+    const auto status = rack_word_sizes.WriteOrt(output_ort, num_buckets);
+    if (!status.ok()) {
+      LOG(ERROR) << "Failed to write " << output_ort << ": " << status;
+      return 1;
+    }
   }
   return 0;
-}
\ No newline at end of file
+}
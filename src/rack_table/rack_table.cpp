@@ -0,0 +1,118 @@
+#include "src/rack_table/rack_table.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "absl/memory/memory.h"
+#include "glog/logging.h"
+
+constexpr int RackTable::kMaxRackSize;
+constexpr int RackTable::kMaxPlaythrough;
+constexpr uint32_t RackTable::kUnknownWordSizes;
+
+namespace {
+constexpr int kQuotientBits = 14;
+constexpr uint32_t kQuotientMask = (1 << kQuotientBits) - 1;
+constexpr int kMaxLetter = 31;
+}  // namespace
+
+std::unique_ptr<RackTable> RackTable::CreateFromOrtFile(
+    const std::string& filename) {
+  LOG(INFO) << "CreateFromOrtFile(...) filename: " << filename;
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(ERROR) << "Could not open file " << filename;
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < 2 * sizeof(uint32_t)) {
+    LOG(ERROR) << "Could not stat rack table " << filename;
+    close(fd);
+    return nullptr;
+  }
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    LOG(ERROR) << "Could not mmap rack table " << filename;
+    return nullptr;
+  }
+  auto table = absl::WrapUnique(new RackTable());
+  table->data_ = data;
+  table->size_ = st.st_size;
+
+  const auto* words = static_cast<const uint32_t*>(data);
+  table->num_buckets_ = words[0];
+  table->num_values_ = words[1];
+  const uint64_t expected_size =
+      sizeof(uint32_t) * (2 + (static_cast<uint64_t>(table->num_buckets_) + 1) +
+                          table->num_values_);
+  if (table->num_buckets_ == 0 || expected_size != table->size_) {
+    LOG(ERROR) << "Rack table " << filename << " has the wrong size";
+    return nullptr;
+  }
+  table->bucket_starts_ = words + 2;
+  table->values_ = table->bucket_starts_ + table->num_buckets_ + 1;
+  if (table->bucket_starts_[table->num_buckets_] != table->num_values_) {
+    LOG(ERROR) << "Rack table " << filename << " has inconsistent buckets";
+    return nullptr;
+  }
+  LOG(INFO) << "Mapped " << table->num_values_ << " racks in "
+            << table->num_buckets_ << " buckets.";
+  return table;
+}
+
+RackTable::~RackTable() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+}
+
+uint32_t RackTable::Lookup(uint64_t key) const {
+  const uint64_t quotient = key / num_buckets_;
+  if (quotient > kQuotientMask) {
+    return kUnknownWordSizes;
+  }
+  const uint64_t bucket = key % num_buckets_;
+  const uint32_t* begin = values_ + bucket_starts_[bucket];
+  const uint32_t* end = values_ + bucket_starts_[bucket + 1];
+  // Buckets hold one or two racks on average, so scan rather than bisect.
+  for (const uint32_t* it = begin; it < end; ++it) {
+    const uint32_t value_quotient = *it & kQuotientMask;
+    if (value_quotient == quotient) {
+      return *it >> kQuotientBits;
+    }
+    if (value_quotient > quotient) {
+      break;
+    }
+  }
+  return kUnknownWordSizes;
+}
+
+uint32_t RackTable::WordSizes(const LetterString& rack) const {
+  const int size = rack.size();
+  if (size == 0 || size > kMaxRackSize) {
+    return kUnknownWordSizes;
+  }
+  // Racks are short, so an insertion sort beats counting over the alphabet.
+  Letter sorted[kMaxRackSize];
+  for (int i = 0; i < size; ++i) {
+    const Letter letter = rack[i];
+    if (letter < 1 || letter > kMaxLetter) {
+      return kUnknownWordSizes;
+    }
+    int j = i;
+    while (j > 0 && sorted[j - 1] > letter) {
+      sorted[j] = sorted[j - 1];
+      --j;
+    }
+    sorted[j] = letter;
+  }
+  uint64_t key = 0;
+  for (int i = 0; i < size; ++i) {
+    key = (key << 5) | static_cast<uint64_t>(sorted[i]);
+  }
+  return Lookup(key);
+}
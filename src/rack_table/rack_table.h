@@ -0,0 +1,70 @@
+#ifndef SRC_RACK_TABLE_RACK_TABLE_H
+#define SRC_RACK_TABLE_RACK_TABLE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "src/scrabble/strings.h"
+
+// Read-only view of an .ort file written by ort_tool. For every rack of up to
+// kMaxRackSize tiles, the table gives the most rack tiles usable in a word
+// that plays through exactly k tiles already on the board, for k from 0 to
+// kMaxPlaythrough.
+//
+// File layout (native byte order, 4-byte words):
+//   num_buckets, num_values,
+//   num_buckets + 1 bucket start offsets into the values,
+//   num_values packed values.
+// A rack's key is its letters in ascending order, 5 bits each. It lives in
+// bucket key % num_buckets, and its packed value holds key / num_buckets in the
+// low 14 bits followed by a 3-bit word size for each playthrough count.
+// Values within a bucket are sorted by quotient.
+class RackTable {
+ public:
+  static constexpr int kMaxRackSize = 7;
+  static constexpr int kMaxPlaythrough = 5;
+
+  // Sizes returned for racks the table knows nothing about: any word fits.
+  static constexpr uint32_t kUnknownWordSizes = 0x3FFFF;
+
+  static std::unique_ptr<RackTable> CreateFromOrtFile(
+      const std::string& filename);
+
+  ~RackTable();
+  RackTable(const RackTable&) = delete;
+  RackTable& operator=(const RackTable&) = delete;
+
+  // Word sizes for rack packed 3 bits per playthrough count, to be read with
+  // MaxTilesPlayed(...). Letters need not be sorted; undesignated blanks
+  // are allowed. Racks that are empty, too long, or absent from the table get
+  // kUnknownWordSizes, so callers may only use the result to rule words out.
+  uint32_t WordSizes(const LetterString& rack) const;
+
+  // Most tiles playable from the rack through playthrough board tiles. Beyond
+  // kMaxPlaythrough the table has no information and this returns
+  // kMaxRackSize.
+  static int MaxTilesPlayed(uint32_t word_sizes, int playthrough) {
+    if (playthrough > kMaxPlaythrough) {
+      return kMaxRackSize;
+    }
+    return (word_sizes >> (3 * playthrough)) & 7;
+  }
+
+  uint32_t NumBuckets() const { return num_buckets_; }
+  uint32_t NumValues() const { return num_values_; }
+
+ private:
+  RackTable() = default;
+
+  uint32_t Lookup(uint64_t key) const;
+
+  void* data_ = nullptr;
+  size_t size_ = 0;
+  uint32_t num_buckets_ = 0;
+  uint32_t num_values_ = 0;
+  const uint32_t* bucket_starts_ = nullptr;
+  const uint32_t* values_ = nullptr;
+};
+
+#endif  // SRC_RACK_TABLE_RACK_TABLE_H
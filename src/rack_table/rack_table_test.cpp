@@ -0,0 +1,107 @@
+#include "src/rack_table/rack_table.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "src/rack_table/magpie_rack.h"
+
+namespace {
+// Same layout as ort_tool's WriteOrt(...).
+void WriteOrt(const absl::flat_hash_map<uint64_t, std::array<int, 8>>& map,
+              uint32_t num_buckets, const std::string& filename) {
+  std::vector<std::vector<std::pair<uint32_t, uint32_t>>> buckets(num_buckets);
+  for (const auto& pair : map) {
+    uint32_t packed_value = 0;
+    for (int j = 0; j < 6; j++) {
+      packed_value |= pair.second[j] << (14 + (3 * j));
+    }
+    const uint32_t quotient = pair.first / num_buckets;
+    packed_value |= quotient;
+    buckets[pair.first % num_buckets].emplace_back(quotient, packed_value);
+  }
+  std::ofstream output(filename, std::ios::binary);
+  const uint32_t num_values = map.size();
+  output.write(reinterpret_cast<const char*>(&num_buckets),
+               sizeof(num_buckets));
+  output.write(reinterpret_cast<const char*>(&num_values), sizeof(num_values));
+  uint32_t bucket_start = 0;
+  for (const auto& bucket : buckets) {
+    output.write(reinterpret_cast<const char*>(&bucket_start),
+                 sizeof(bucket_start));
+    bucket_start += bucket.size();
+  }
+  output.write(reinterpret_cast<const char*>(&bucket_start),
+               sizeof(bucket_start));
+  for (auto& bucket : buckets) {
+    std::sort(bucket.begin(), bucket.end());
+    for (const auto& value : bucket) {
+      output.write(reinterpret_cast<const char*>(&value.second),
+                   sizeof(value.second));
+    }
+  }
+}
+
+LetterString LS(const std::string& s) {
+  LetterString ret;
+  for (const char c : s) {
+    ret.push_back(c == '?' ? 27 : c - 'A' + 1);
+  }
+  return ret;
+}
+
+std::vector<int> MaxTilesPlayed(const RackTable& table,
+                                const std::string& rack) {
+  const uint32_t word_sizes = table.WordSizes(LS(rack));
+  std::vector<int> ret;
+  for (int playthrough = 0; playthrough <= 6; ++playthrough) {
+    ret.push_back(RackTable::MaxTilesPlayed(word_sizes, playthrough));
+  }
+  return ret;
+}
+}  // namespace
+
+TEST(RackTableTest, CreateFromOrtFile) {
+  const MagpieRack english_bag = MagpieRackFromString(
+      "AAAAAAAAABBCCDDDDEEEEEEEEEEEEFFGGGHHIIIIIIIIIJKLLLL"
+      "MMNNNNNNOOOOOOOOPPQRRRRRRSSSSTTTTTTUUUUVVWWXYYZ??");
+  const auto map =
+      MakeRackWordSizesMap({"AA", "AB", "BACK"}, english_bag, 4, 3);
+  const std::string filename = testing::TempDir() + "aa_ab_back.ort";
+  WriteOrt(map, 101, filename);
+
+  auto table = RackTable::CreateFromOrtFile(filename);
+  ASSERT_NE(table, nullptr);
+  EXPECT_EQ(table->NumBuckets(), 101);
+  EXPECT_EQ(table->NumValues(), map.size());
+
+  using ::testing::ElementsAre;
+  EXPECT_THAT(MaxTilesPlayed(*table, "A"), ElementsAre(0, 1, 0, 1, 0, 0, 7));
+  EXPECT_THAT(MaxTilesPlayed(*table, "AA"), ElementsAre(2, 1, 0, 1, 0, 0, 7));
+  EXPECT_THAT(MaxTilesPlayed(*table, "K"), ElementsAre(0, 0, 0, 1, 0, 0, 7));
+  EXPECT_THAT(MaxTilesPlayed(*table, "BACK"),
+              ElementsAre(4, 3, 2, 1, 0, 0, 7));
+  EXPECT_THAT(MaxTilesPlayed(*table, "KCAB"),
+              ElementsAre(4, 3, 2, 1, 0, 0, 7));
+  EXPECT_THAT(MaxTilesPlayed(*table, "?B"), ElementsAre(2, 1, 2, 1, 0, 0, 7));
+  EXPECT_THAT(MaxTilesPlayed(*table, "C??"),
+              ElementsAre(2, 3, 2, 1, 0, 0, 7));
+
+  // Racks the table can't answer for don't rule anything out.
+  EXPECT_EQ(table->WordSizes(LS("")), RackTable::kUnknownWordSizes);
+  EXPECT_EQ(table->WordSizes(LS("ABCDEFGH")), RackTable::kUnknownWordSizes);
+  EXPECT_EQ(table->WordSizes(LS("ABCDE")), RackTable::kUnknownWordSizes);
+}
+
+TEST(RackTableTest, RejectsTruncatedFile) {
+  const std::string filename = testing::TempDir() + "truncated.ort";
+  std::ofstream output(filename, std::ios::binary);
+  const uint32_t header[3] = {101, 5, 0};
+  output.write(reinterpret_cast<const char*>(header), sizeof(header));
+  output.close();
+  EXPECT_EQ(RackTable::CreateFromOrtFile(filename), nullptr);
+}
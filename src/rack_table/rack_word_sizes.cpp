@@ -0,0 +1,330 @@
+#include "src/rack_table/rack_word_sizes.h"
+
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+#include "glog/logging.h"
+
+constexpr size_t RackWordSizes::kMaxBuildBytes;
+constexpr uint32_t RackWordSizes::kInvalidOffset;
+constexpr int RackWordSizes::kBlank;
+
+namespace {
+constexpr int kNumLetters = 32;
+constexpr int kQuotientBits = 14;
+constexpr int kOrtPlaythroughs = 6;
+
+int KeySize(uint64_t key) {
+  int size = 0;
+  while (key) {
+    key >>= 5;
+    size++;
+  }
+  return size;
+}
+}  // namespace
+
+RackWordSizes::RackWordSizes(const MagpieRack& bag, int max_size,
+                             int max_playthrough)
+    : bag_(bag),
+      max_size_(max_size),
+      max_playthrough_(max_playthrough),
+      stride_(max_playthrough + 1),
+      offsets_(kNumLetters * (max_size + 1) * (max_size + 1)) {
+  CHECK_GE(max_size, 1);
+  CHECK_LE(max_size, 12);
+  CHECK_GE(max_playthrough, 0);
+  CHECK_LT(max_playthrough, 8);
+  // ways[letter][remaining]: racks of at most remaining tiles using only this
+  // and later letters.
+  std::vector<std::vector<uint64_t>> ways(
+      kNumLetters + 1, std::vector<uint64_t>(max_size + 1, 0));
+  for (int remaining = 0; remaining <= max_size; ++remaining) {
+    ways[kNumLetters][remaining] = 1;
+  }
+  for (int letter = kNumLetters - 1; letter >= 1; --letter) {
+    for (int remaining = 0; remaining <= max_size; ++remaining) {
+      uint64_t offset = 0;
+      for (int count = 0; count <= max_size; ++count) {
+        if (count > remaining || count > bag_.counts[letter]) {
+          Offset(letter, remaining, count) = kInvalidOffset;
+          continue;
+        }
+        Offset(letter, remaining, count) = offset;
+        offset += ways[letter + 1][remaining - count];
+      }
+      ways[letter][remaining] = offset;
+    }
+  }
+  CHECK_LT(ways[1][max_size], kInvalidOffset);
+  keys_.reserve(ways[1][max_size]);
+  EnumerateRacks(1, max_size, 0);
+  CHECK_EQ(keys_.size(), ways[1][max_size]);
+}
+
+// Visits racks in rank order, so keys_[rank] is the key of that rack.
+void RackWordSizes::EnumerateRacks(int letter, int remaining, uint64_t key) {
+  if (letter == kNumLetters) {
+    keys_.push_back(key);
+    return;
+  }
+  const int max_count = std::min(remaining, bag_.counts[letter]);
+  for (int count = 0; count <= max_count; ++count) {
+    EnumerateRacks(letter + 1, remaining - count, key);
+    key = (key << 5) | letter;
+  }
+}
+
+uint32_t RackWordSizes::RankOfLetters(const int* letters, int num_letters,
+                                      int skip) const {
+  uint32_t rank = 0;
+  int remaining = max_size_;
+  int i = 0;
+  while (i < num_letters) {
+    const int letter = letters[i];
+    int count = 0;
+    for (; i < num_letters && letters[i] == letter; ++i) {
+      if (i != skip) {
+        count++;
+      }
+    }
+    rank += Offset(letter, remaining, count);
+    remaining -= count;
+  }
+  return rank;
+}
+
+void RackWordSizes::AddWord(const std::string& word,
+                            std::vector<uint8_t>* sizes) const {
+  const int length = word.size();
+  if (length > max_size_ + max_playthrough_) {
+    return;
+  }
+  std::array<int, kNumLetters> counts = {0};
+  for (const char c : word) {
+    if (c < 'A' || c > 'Z') {
+      return;
+    }
+    counts[c - 'A' + 1]++;
+  }
+  WordLetters word_letters;
+  word_letters.length = length;
+  word_letters.num_letters = 0;
+  for (int letter = 1; letter <= 26; ++letter) {
+    if (counts[letter] > 0) {
+      word_letters.letters[word_letters.num_letters] = letter;
+      word_letters.counts[word_letters.num_letters] = counts[letter];
+      word_letters.num_letters++;
+    }
+  }
+  AddSubracks(word_letters, 0, max_size_, 0, 0, 0, sizes);
+}
+
+// Chooses, letter by letter, how many of the word's tiles come from the rack
+// as themselves and how many as blanks. The rank is accumulated as we go;
+// blanks sort last, so their offset is added once all letters are chosen.
+void RackWordSizes::AddSubracks(const WordLetters& word, int index,
+                                int remaining, uint32_t rank, int num_tiles,
+                                int num_blanks,
+                                std::vector<uint8_t>* sizes) const {
+  if (index == word.num_letters) {
+    if (num_tiles == 0) {
+      return;
+    }
+    const int playthrough = word.length - num_tiles;
+    if (playthrough > max_playthrough_) {
+      return;
+    }
+    const uint32_t blank_offset = Offset(kBlank, remaining, num_blanks);
+    if (blank_offset == kInvalidOffset) {
+      return;
+    }
+    uint8_t& size = (*sizes)[(rank + blank_offset) * stride_ + playthrough];
+    size = std::max<uint8_t>(size, num_tiles);
+    return;
+  }
+  const int letter = word.letters[index];
+  const int word_count = word.counts[index];
+  for (int natural = 0; natural <= word_count; ++natural) {
+    const uint32_t offset = Offset(letter, remaining, natural);
+    if (offset == kInvalidOffset) {
+      break;
+    }
+    for (int blanked = 0; natural + blanked <= word_count; ++blanked) {
+      if (num_blanks + blanked > bag_.counts[kBlank] ||
+          num_tiles + natural + blanked > max_size_) {
+        break;
+      }
+      AddSubracks(word, index + 1, remaining - natural, rank + offset,
+                  num_tiles + natural + blanked, num_blanks + blanked, sizes);
+    }
+  }
+}
+
+int RackWordSizes::MaxBuildThreads() const {
+  const size_t table_size = keys_.size() * stride_;
+  return std::max<size_t>(
+      1, std::min<size_t>(kMaxBuildBytes / table_size, 1 << 16));
+}
+
+void RackWordSizes::Build(const std::vector<std::string>& words,
+                          int num_threads) {
+  num_threads = std::max(1, num_threads);
+  if (num_threads > MaxBuildThreads()) {
+    LOG(INFO) << "Building on " << MaxBuildThreads() << " threads instead of "
+              << num_threads << " to stay within " << kMaxBuildBytes
+              << " bytes";
+    num_threads = MaxBuildThreads();
+  }
+  const size_t table_size = keys_.size() * stride_;
+  sizes_.assign(table_size, 0);
+  if (num_threads == 1) {
+    for (const auto& word : words) {
+      AddWord(word, &sizes_);
+    }
+  } else {
+    // Thread 0 fills sizes_ itself; the others get their own arrays.
+    std::vector<std::vector<uint8_t>> partials(num_threads - 1);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+      std::vector<uint8_t>* sizes = &sizes_;
+      if (t > 0) {
+        partials[t - 1].assign(table_size, 0);
+        sizes = &partials[t - 1];
+      }
+      threads.emplace_back([this, &words, num_threads, t, sizes]() {
+        for (size_t i = t; i < words.size(); i += num_threads) {
+          AddWord(words[i], sizes);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (auto& partial : partials) {
+      for (size_t i = 0; i < table_size; ++i) {
+        sizes_[i] = std::max(sizes_[i], partial[i]);
+      }
+      std::vector<uint8_t>().swap(partial);
+    }
+  }
+  Propagate();
+}
+
+// A rack can do whatever any of its subracks can, so each rack takes the
+// maximum over the racks with one tile fewer. Smaller racks go first.
+void RackWordSizes::Propagate() {
+  std::vector<std::vector<uint32_t>> ranks_by_size(max_size_ + 1);
+  for (uint32_t rank = 1; rank < keys_.size(); ++rank) {
+    ranks_by_size[KeySize(keys_[rank])].push_back(rank);
+  }
+  int letters[16];
+  for (int size = 2; size <= max_size_; ++size) {
+    for (const uint32_t rank : ranks_by_size[size]) {
+      uint64_t key = keys_[rank];
+      for (int i = size - 1; i >= 0; --i) {
+        letters[i] = key & 31;
+        key >>= 5;
+      }
+      uint8_t* sizes = &sizes_[rank * stride_];
+      for (int i = 0; i < size; ++i) {
+        if (i > 0 && letters[i] == letters[i - 1]) {
+          continue;
+        }
+        const uint32_t subrack = RankOfLetters(letters, size, i);
+        const uint8_t* subrack_sizes = &sizes_[subrack * stride_];
+        for (int playthrough = 0; playthrough < stride_; ++playthrough) {
+          sizes[playthrough] =
+              std::max(sizes[playthrough], subrack_sizes[playthrough]);
+        }
+      }
+    }
+  }
+}
+
+absl::flat_hash_map<uint64_t, std::array<int, 8>> RackWordSizes::ToMap()
+    const {
+  absl::flat_hash_map<uint64_t, std::array<int, 8>> map;
+  map.reserve(NumRacks());
+  for (uint32_t rank = 1; rank < keys_.size(); ++rank) {
+    auto& value = map[keys_[rank]];
+    value.fill(0);
+    for (int playthrough = 0; playthrough < stride_; ++playthrough) {
+      value[playthrough] = sizes_[rank * stride_ + playthrough];
+    }
+  }
+  return map;
+}
+
+void RackWordSizes::WriteWordSizes(std::ostream& os) const {
+  for (uint32_t rank = 1; rank < keys_.size(); ++rank) {
+    os << keys_[rank];
+    for (int playthrough = 0; playthrough < stride_; ++playthrough) {
+      os << " " << static_cast<int>(sizes_[rank * stride_ + playthrough]);
+    }
+    os << "\n";
+  }
+}
+
+absl::Status RackWordSizes::WriteOrt(const std::string& filename,
+                                     uint32_t num_buckets) const {
+  if (max_size_ > 7 || max_playthrough_ + 1 > kOrtPlaythroughs) {
+    return absl::InvalidArgumentError(
+        ".ort holds 3-bit sizes for at most 6 playthrough counts");
+  }
+  if (num_buckets == 0) {
+    return absl::InvalidArgumentError("num_buckets must be positive");
+  }
+  const uint32_t num_values = NumRacks();
+  // Counting sort of the racks into buckets.
+  std::vector<uint32_t> bucket_starts(static_cast<size_t>(num_buckets) + 1, 0);
+  for (uint32_t rank = 1; rank < keys_.size(); ++rank) {
+    bucket_starts[keys_[rank] % num_buckets + 1]++;
+  }
+  for (uint32_t bucket = 0; bucket < num_buckets; ++bucket) {
+    bucket_starts[bucket + 1] += bucket_starts[bucket];
+  }
+  std::vector<uint32_t> values(num_values);
+  {
+    std::vector<uint32_t> next(bucket_starts.begin(), bucket_starts.end() - 1);
+    for (uint32_t rank = 1; rank < keys_.size(); ++rank) {
+      const uint64_t key = keys_[rank];
+      const uint64_t quotient = key / num_buckets;
+      if (quotient >= (1 << kQuotientBits)) {
+        return absl::InvalidArgumentError(
+            "num_buckets too small for 14-bit quotients");
+      }
+      uint32_t packed_value = quotient;
+      for (int playthrough = 0; playthrough < stride_; ++playthrough) {
+        packed_value |= sizes_[rank * stride_ + playthrough]
+                        << (kQuotientBits + 3 * playthrough);
+      }
+      values[next[key % num_buckets]++] = packed_value;
+    }
+  }
+  const uint32_t quotient_mask = (1 << kQuotientBits) - 1;
+  for (uint32_t bucket = 0; bucket < num_buckets; ++bucket) {
+    std::sort(values.begin() + bucket_starts[bucket],
+              values.begin() + bucket_starts[bucket + 1],
+              [quotient_mask](uint32_t a, uint32_t b) {
+                return (a & quotient_mask) < (b & quotient_mask);
+              });
+  }
+
+  std::ofstream output(filename, std::ios::out | std::ios::binary);
+  if (!output.is_open()) {
+    return absl::NotFoundError("Could not open file " + filename);
+  }
+  output.write(reinterpret_cast<const char*>(&num_buckets),
+               sizeof(num_buckets));
+  output.write(reinterpret_cast<const char*>(&num_values), sizeof(num_values));
+  output.write(reinterpret_cast<const char*>(bucket_starts.data()),
+               bucket_starts.size() * sizeof(uint32_t));
+  output.write(reinterpret_cast<const char*>(values.data()),
+               values.size() * sizeof(uint32_t));
+  if (!output.good()) {
+    return absl::InternalError("Could not write to file " + filename);
+  }
+  return absl::OkStatus();
+}
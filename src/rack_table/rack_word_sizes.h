@@ -0,0 +1,96 @@
+#ifndef SRC_RACK_TABLE_RACK_WORD_SIZES_H
+#define SRC_RACK_TABLE_RACK_WORD_SIZES_H
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "src/rack_table/magpie_rack.h"
+
+// Builds the same table as MakeRackWordSizesMap(...), but without
+// materializing MagpieRacks. Every rack of up to max_size tiles drawable from
+// the bag gets a dense index (its rank when racks are ordered by their count
+// of each letter in turn), and word sizes live in flat per-index arrays.
+// Words are sharded across threads, each filling its own array, and the
+// arrays are merged by taking maxima. Each array is
+// NumRacks() * (max_playthrough + 1) bytes, so the number of threads is
+// capped to keep them within kMaxBuildBytes together.
+class RackWordSizes {
+ public:
+  static constexpr size_t kMaxBuildBytes = size_t{1} << 30;
+
+  RackWordSizes(const MagpieRack& bag, int max_size, int max_playthrough);
+
+  // Uses at most MaxBuildThreads() threads.
+  void Build(const std::vector<std::string>& words, int num_threads);
+
+  // Most threads whose arrays fit in kMaxBuildBytes, and at least 1.
+  int MaxBuildThreads() const;
+
+  // Number of non-empty racks of at most max_size tiles in the bag.
+  size_t NumRacks() const { return keys_.size() - 1; }
+
+  // Keyed by MagpieRackToUint64(...), for comparison with
+  // MakeRackWordSizesMap(...).
+  absl::flat_hash_map<uint64_t, std::array<int, 8>> ToMap() const;
+
+  // One line per rack: key, then word sizes for each playthrough count.
+  void WriteWordSizes(std::ostream& os) const;
+
+  // Writes the table in the .ort layout read by RackTable. num_buckets must
+  // be prime and large enough that key / num_buckets fits in 14 bits.
+  absl::Status WriteOrt(const std::string& filename,
+                        uint32_t num_buckets) const;
+
+ private:
+  static constexpr uint32_t kInvalidOffset = 0xFFFFFFFF;
+  static constexpr int kBlank = 27;
+
+  uint32_t& Offset(int letter, int remaining, int count) {
+    return offsets_[(letter * (max_size_ + 1) + remaining) * (max_size_ + 1) +
+                    count];
+  }
+  uint32_t Offset(int letter, int remaining, int count) const {
+    return offsets_[(letter * (max_size_ + 1) + remaining) * (max_size_ + 1) +
+                    count];
+  }
+
+  void EnumerateRacks(int letter, int remaining, uint64_t key);
+
+  // Distinct letters of a word, ascending, with their counts.
+  struct WordLetters {
+    int length;
+    int num_letters;
+    std::array<int, 26> letters;
+    std::array<int, 26> counts;
+  };
+
+  // Rank of the sorted letters, leaving out the one at index skip (if any).
+  uint32_t RankOfLetters(const int* letters, int num_letters, int skip) const;
+
+  // Records every subrack of word (with up to bag blanks of its tiles
+  // replaced by blanks) in sizes, which is indexed by
+  // rank * stride_ + playthrough.
+  void AddWord(const std::string& word, std::vector<uint8_t>* sizes) const;
+  void AddSubracks(const WordLetters& word, int index, int remaining,
+                   uint32_t rank, int num_tiles, int num_blanks,
+                   std::vector<uint8_t>* sizes) const;
+
+  void Propagate();
+
+  const MagpieRack bag_;
+  const int max_size_;
+  const int max_playthrough_;
+  const int stride_;
+  std::vector<uint32_t> offsets_;
+
+  // Indexed by rank. Rank 0 is the empty rack.
+  std::vector<uint64_t> keys_;
+  std::vector<uint8_t> sizes_;
+};
+
+#endif  // SRC_RACK_TABLE_RACK_WORD_SIZES_H
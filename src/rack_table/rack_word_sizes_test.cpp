@@ -0,0 +1,63 @@
+#include "src/rack_table/rack_word_sizes.h"
+
+#include <gtest/gtest.h>
+
+#include "gmock/gmock.h"
+#include "src/rack_table/magpie_rack.h"
+#include "src/rack_table/rack_table.h"
+
+namespace {
+MagpieRack EnglishBag() {
+  return MagpieRackFromString(
+      "AAAAAAAAABBCCDDDDEEEEEEEEEEEEFFGGGHHIIIIIIIIIJKLLLL"
+      "MMNNNNNNOOOOOOOOPPQRRRRRRSSSSTTTTTTUUUUVVWWXYYZ??");
+}
+
+const std::vector<std::string> kWords = {
+    "AA",     "AB",      "BACK",    "QI",       "ZA",     "CRWTH",
+    "BANANA", "QUIZ",    "JOKE",    "RETAINS",  "OXAZEPAM", "SESQUIOXIDE",
+    "ZZZ",    "PIZZAZZ", "EEEEEE"};
+}  // namespace
+
+TEST(RackWordSizesTest, MatchesMakeRackWordSizesMap) {
+  const auto expected = MakeRackWordSizesMap(kWords, EnglishBag(), 4, 3);
+  for (const int num_threads : {1, 3}) {
+    RackWordSizes rack_word_sizes(EnglishBag(), 4, 3);
+    EXPECT_EQ(rack_word_sizes.NumRacks(), expected.size());
+    rack_word_sizes.Build(kWords, num_threads);
+    EXPECT_EQ(rack_word_sizes.ToMap(), expected) << num_threads;
+  }
+}
+
+TEST(RackWordSizesTest, WriteOrt) {
+  RackWordSizes rack_word_sizes(EnglishBag(), 7, 5);
+  EXPECT_EQ(rack_word_sizes.NumRacks(), 4114349 - 1);
+  rack_word_sizes.Build(kWords, 2);
+  const std::string filename = testing::TempDir() + "rack_word_sizes.ort";
+  ASSERT_TRUE(rack_word_sizes.WriteOrt(filename, 5297687).ok());
+  EXPECT_FALSE(rack_word_sizes.WriteOrt(filename, 101).ok());
+
+  auto table = RackTable::CreateFromOrtFile(filename);
+  ASSERT_NE(table, nullptr);
+  EXPECT_EQ(table->NumValues(), rack_word_sizes.NumRacks());
+  const auto map = rack_word_sizes.ToMap();
+  for (const std::string rack : {"A", "QI", "AEINRST", "???", "ZZ", "CHRTW"}) {
+    const MagpieRack magpie_rack = MagpieRackFromString(rack);
+    const auto it = map.find(MagpieRackToUint64(magpie_rack));
+    LetterString letters;
+    for (const char c : rack) {
+      letters.push_back(c == '?' ? 27 : c - 'A' + 1);
+    }
+    const uint32_t word_sizes = table->WordSizes(letters);
+    if (it == map.end()) {
+      // Not drawable from the bag.
+      EXPECT_EQ(word_sizes, RackTable::kUnknownWordSizes) << rack;
+      continue;
+    }
+    for (int playthrough = 0; playthrough <= 5; ++playthrough) {
+      EXPECT_EQ(RackTable::MaxTilesPlayed(word_sizes, playthrough),
+                it->second[playthrough])
+          << rack << " " << playthrough;
+    }
+  }
+}
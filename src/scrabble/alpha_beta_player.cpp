@@ -1,118 +1,236 @@
 #include "src/scrabble/alpha_beta_player.h"
 
+#include <algorithm>
+#include <thread>
+
+#include "absl/types/optional.h"
 #include "src/scrabble/move_finder.h"
 #include "src/scrabble/rack.h"
 
+constexpr int AlphaBetaPlayer::kResolvedDepth;
+constexpr float AlphaBetaPlayer::kNullWindow;
+
 Move AlphaBetaPlayer::ChooseBestMove(
     const std::vector<GamePosition>* previous_positions,
     const GamePosition& pos) {
   //LOG(INFO) << "AlphaBetaPlayer::ChooseBestMove";
   SetStartOfTurnTime();
-  nodes_.clear();
-  Move dummy;
-  dummy.SetEquity(0.0);
-  nodes_.emplace_back(absl::make_unique<GameNode>(dummy, nullptr, 0.0, 0));
-  root_node_ = nodes_.back().get();
   GamePosition p = pos;
   p.SetKnownOppRack(pos.GetUnseenToPlayer());
-  const GameNode* best_node;
-  const GameState initial_state(
-      tiles_.ToProduct64(p.GetRack().Letters()),
-      tiles_.ToProduct64(p.GetKnownOppRack().Letters()),
-      0,  // num_placed_letters
-      {}  // initializes the array with zeroes
-  );
-  move_finder_->CacheCrossesAndScores(p.GetBoard());
-  best_node =
-      AlphaBeta(root_node_, initial_state, true, num_plies_, -1e10, 1e10, &p);
-  // for (int i = 1; i <= num_plies_; ++i) {
-  //   best_node = AlphaBeta(root_node_, initial_state, true, i, -1e10, 1e10,
-  //   &p);
-  // }
-  CHECK_NOTNULL(best_node);
-  if (best_node->GetMove().GetAction() == Move::Exchange) {
-  } else if (best_node->GetMove().Score() <= 0) {
+  SearchWorker* main_worker = workers_[0].get();
+  main_worker->move_finder->CacheCrossesAndScores(p.GetBoard());
+  if (workers_.size() > 1) {
+    CrossesAndScores root_crosses;
+    main_worker->move_finder->GetCrossesAndScores(&root_crosses);
+    for (int i = 1; i < workers_.size(); ++i) {
+      workers_[i]->move_finder->SetCrossesAndScores(root_crosses);
+    }
+  }
+  transposition_table_.Clear();
+  deadline_ = absl::InfiniteFuture();
+  if (time_budget_fraction_ > 0) {
+    deadline_ = StartOfTurnTime() +
+                time_budget_fraction_ * pos.TimeRemainingStart();
+  }
+  const uint64_t board_hash = zobrist_.BoardHash(p.GetBoard());
+  for (auto& worker : workers_) {
+    if (worker->line.size() < num_plies_ + 1) {
+      worker->line.resize(num_plies_ + 1);
+    }
+  }
+  main_worker->stopped = false;
+  // Each iteration starts from the moves stored in the transposition table
+  // by the one before, so the previous principal variation is searched
+  // first.
+  absl::optional<Move> best_move;
+  completed_depth_ = 0;
+  // Without a time budget, there's no need to have a shallower result ready,
+  // and going straight to full depth searches fewer nodes.
+  first_depth_ = (time_budget_fraction_ > 0) ? 1 : num_plies_;
+  for (search_depth_ = first_depth_; search_depth_ <= num_plies_;
+       ++search_depth_) {
+    stop_helpers_ = false;
+    // Copied before any thread starts changing p.
+    std::vector<GamePosition> helper_positions(workers_.size() - 1, p);
+    std::vector<std::thread> helpers;
+    helpers.reserve(workers_.size() - 1);
+    for (int i = 1; i < workers_.size(); ++i) {
+      SearchWorker* helper = workers_[i].get();
+      helper->reached_depth_limit = false;
+      helper->stopped = false;
+      GamePosition* helper_p = &helper_positions[i - 1];
+      helpers.emplace_back([this, helper, board_hash, helper_p]() {
+        AlphaBeta(helper, board_hash, true, search_depth_, -1e10, 1e10,
+                  helper_p);
+      });
+    }
+    main_worker->reached_depth_limit = false;
+    const float value = AlphaBeta(main_worker, board_hash, true, search_depth_,
+                                  -1e10, 1e10, &p);
+    stop_helpers_ = true;
+    for (auto& helper : helpers) {
+      helper.join();
+    }
+    if (main_worker->stopped) {
+      LOG(INFO) << "out of time during search to depth " << search_depth_;
+      break;
+    }
+    // Copied out, since the next iteration regenerates the root's moves.
+    const Ply& root = main_worker->line[0];
+    best_move = root.moves[root.move_index];
+    completed_depth_ = search_depth_;
+    best_line_value_ = value;
+    // Nothing deeper to search once every line reaches the end of the game.
+    if (!main_worker->reached_depth_limit) {
+      break;
+    }
+  }
+  CHECK(best_move.has_value());
+  if (best_move->GetAction() == Move::Exchange) {
+  } else if (best_move->Score() <= 0) {
     std::stringstream ss;
-    best_node->GetMove().Display(tiles_, ss);
+    best_move->Display(tiles_, ss);
     LOG(INFO) << "low best move: " << ss.str();
-  } else if (best_node->GetMove().Score() >= 400) {
+  } else if (best_move->Score() >= 400) {
     std::stringstream ss;
-    best_node->GetMove().Display(tiles_, ss);
+    best_move->Display(tiles_, ss);
     LOG(INFO) << "high best move: " << ss.str();
   }
-  return best_node->GetMove();
+  return best_move.value();
 }
 
-std::vector<Move> AlphaBetaPlayer::MovesAfterParent(const GameNode* parent,
-                                                    GamePosition* p) {
+void AlphaBetaPlayer::MovesAfterParent(SearchWorker* worker, int ply,
+                                       GamePosition* p) {
+  MoveFinder* move_finder = worker->move_finder.get();
   const Bag empty_bag(tiles_, {});
   p->SwapWithKnownOppRack();
-  move_finder_->FindMoves(p->GetRack(), p->GetBoard(), empty_bag,
-                          MoveFinder::RecordAll, false);
+  move_finder->FindMoves(p->GetRack(), p->GetBoard(), empty_bag,
+                         MoveFinder::RecordAll, false);
   int opp_stuck_score = 0;
   const bool opp_stuck_with_tile =
-      detect_stuck_tiles_ && move_finder_->StuckWithTile(&opp_stuck_score);
+      detect_stuck_tiles_ && move_finder->StuckWithTile(&opp_stuck_score);
   if (opp_stuck_with_tile) {
     // LOG(INFO) << "opp stuck with tile, opp_stuck_score = " <<
     // opp_stuck_score; std::stringstream ss; p->Display(ss); LOG(INFO) <<
     // std::endl << ss.str();
   }
+  worker->line[ply].opp_moves = move_finder->Moves();
   p->SwapWithKnownOppRack();
-  move_finder_->FindMoves(p->GetRack(), p->GetBoard(), empty_bag,
-                          MoveFinder::RecordAll, false);
-  // move_finder_->FindMoves(p->GetRack(), p->GetBoard(),
+  if (ply == 0) {
+    move_finder->FindMoves(p->GetRack(), p->GetBoard(), empty_bag,
+                           MoveFinder::RecordAll, false);
+  } else {
+    // The rack is the one the parent found opp_moves for, and the board
+    // differs only by the parent's move.
+    move_finder->FindMovesAfter(p->GetRack(), p->GetBoard(),
+                                MoveBefore(*worker, ply),
+                                worker->line[ply - 1].opp_moves);
+  }
+  // move_finder->FindMoves(p->GetRack(), p->GetBoard(),
   // p->GetUnseenToPlayer(),
   //                         MoveFinder::RecordAll, false);
-  bool preceded_by_pass = false;
-  if (parent && (parent->GetMove().GetAction() != Move::Place)) {
-    preceded_by_pass = true;
-  }
-  move_finder_->SetEndgameEquities(
+  const bool preceded_by_pass = PrecededByPass(*worker, ply);
+  move_finder->SetEndgameEquities(
       p->GetRack().Letters(), p->GetKnownOppRack().Letters(),
       opp_stuck_with_tile, opp_stuck_score, preceded_by_pass,
       stuck_tiles_left_multiplier_, stuck_leave_score_multiplier_,
       stuck_leave_value_multiplier_, opp_stuck_score_multiplier_,
       unstuck_leave_score_weight_, unstuck_leave_value_weight_, tiles_);
-  move_finder_->SortMoves();
-  return move_finder_->Moves();
+  move_finder->SortMoves();
+  // Assigned rather than swapped, so the buffer keeps its capacity.
+  worker->line[ply].moves = move_finder->Moves();
+}
+
+float AlphaBetaPlayer::LineValue(const SearchWorker& worker, int ply,
+                                  bool terminal) const {
+  // Summed from the root, whose stand-in move is worth nothing. The first
+  // move is the root player's, then sides alternate.
+  float value = 0.0;
+  float sign = 1.0;
+  for (int i = 1; i <= ply; ++i) {
+    const Move& move = MoveBefore(worker, i);
+    value += sign * ((terminal && i == ply) ? move.Equity() : move.Score());
+    sign = -sign;
+  }
+  return value;
+}
+
+uint64_t AlphaBetaPlayer::PositionHash(const SearchWorker& worker, int ply,
+                                       uint64_t board_hash, bool on_turn,
+                                       const GamePosition& p) const {
+  uint64_t hash = board_hash ^ zobrist_.RackHash(p.GetRack().Letters(), 0) ^
+                  zobrist_.RackHash(p.GetKnownOppRack().Letters(), 1);
+  if (on_turn) {
+    hash ^= zobrist_.Turn();
+  }
+  if (PrecededByPass(worker, ply)) {
+    hash ^= zobrist_.AfterPass();
+  }
+  // Caps limit the moves searched below here, so a subtree searched under
+  // one suffix of caps_per_ply_ doesn't stand in for another.
+  if (!caps_per_ply_.empty()) {
+    hash ^= zobrist_.CapIndex(
+        std::min<int>(ply, static_cast<int>(caps_per_ply_.size()) - 1));
+  }
+  return hash;
 }
 
-AlphaBetaPlayer::GameNode* AlphaBetaPlayer::AlphaBeta(GameNode* parent,
-                                                      const GameState& state,
-                                                      bool on_turn, int depth,
-                                                      float alpha, float beta,
-                                                      GamePosition* p) {
+float AlphaBetaPlayer::AlphaBeta(SearchWorker* worker, uint64_t board_hash,
+                                 bool on_turn, int depth, float alpha,
+                                 float beta, GamePosition* p) {
   // std::stringstream ss;
   // p->Display(ss);
   // LOG(INFO) << "AlphaBetaPlayer::AlphaBeta: depth=" << depth
   //           << " on_turn=" << on_turn << " alpha=" << alpha << " beta=" << beta;
-  // LOG(INFO) << "nodes_.size(): " << nodes_.size();
   // LOG(INFO) << "position: " << std::endl << ss.str();
+  const int ply = search_depth_ - depth;
   if (depth == 0) {
-    parent->SetValue(parent->CalculateValue(*p, !on_turn, true));
-    // LOG(INFO) << "depth = 0, return parent node with value " <<
-    // parent->Value(); std::stringstream ss; parent->GetMove().Display(tiles_,
-    // ss); LOG(INFO) << "parent move: " << ss.str();
-    return parent;
+    worker->reached_depth_limit = true;
+    return LineValue(*worker, ply, true);
   }
   if (p->GetKnownOppRack().NumTiles() == 0) {
-    parent->SetValue(parent->CalculateValue(*p, !on_turn, true));
-    // LOG(INFO) << "known opp rack is empty, there has been an outplay. return
-    // "
-    //              "parent node with value "
-    //           << parent->Value();
-    // std::stringstream ss;
-    // parent->GetMove().Display(tiles_, ss);
-    // LOG(INFO) << "parent move: " << ss.str();
-    return parent;
+    // LOG(INFO) << "known opp rack is empty, there has been an outplay.";
+    return LineValue(*worker, ply, true);
+  }
+  if (Stopped(worker)) {
+    return 0.0;
   }
+  // Values below are for whole lines from the root. The table holds them
+  // less the scores played so far.
+  const float scored = LineValue(*worker, ply, false);
+  const uint64_t hash = PositionHash(*worker, ply, board_hash, on_turn, *p);
+  const float original_alpha = alpha;
+  const float original_beta = beta;
+  int hash_move_index = -1;
+  TranspositionTable::Entry entry;
+  if (transposition_table_.Probe(hash, &entry)) {
+    hash_move_index = entry.best_move_index;
+    // The root has to return a child with a move, so it is always searched.
+    if (ply > 0 && entry.depth >= depth) {
+      const float value = scored + entry.value;
+      if (entry.bound == TranspositionTable::Exact ||
+          (entry.bound == TranspositionTable::Lower && value >= beta) ||
+          (entry.bound == TranspositionTable::Upper && value <= alpha)) {
+        if (entry.depth != kResolvedDepth) {
+          worker->reached_depth_limit = true;
+        }
+        return value;
+      }
+      if (entry.bound == TranspositionTable::Lower) {
+        alpha = std::max(alpha, value);
+      } else {
+        beta = std::min(beta, value);
+      }
+    }
+  }
+  MoveFinder* move_finder = worker->move_finder.get();
   const Rack original_rack = p->GetRack();
-  GameNode* best_node = nullptr;
-  const int ply = num_plies_ - depth;
+  int best_move_index = -1;
   const int cap = CapAtPly(ply);
   //LOG(INFO) << "ply: " << ply << " cap: " << cap;
-  int i = 0;
-  std::vector<Move> moves = MovesAfterParent(parent, p);
+  MovesAfterParent(worker, ply, p);
+  // Stays put while children are searched, which only use later plies.
+  const std::vector<Move>& moves = worker->line[ply].moves;
   //LOG(INFO) << "moves.size(): " << moves.size();
   bool can_play = false;
   for (const auto& move : moves) {
@@ -121,98 +239,103 @@ AlphaBetaPlayer::GameNode* AlphaBetaPlayer::AlphaBeta(GameNode* parent,
       break;
     }
   }
-  if (on_turn) {
-    float value = -1e10;
-    for (const Move& move : moves) {
-      std::stringstream ss;
-      move.Display(tiles_, ss);
-      // LOG(INFO) << "move #" << i << ": " << ss.str()
-      //           << " equity: " << move.Equity();
-      i++;
-      if (i > cap) {
-        // LOG(INFO) << "i > cap, breaking"
-        //           << " i: " << i << " cap: " << cap;
-        break;
-      }
-      if (can_play && (move.GetAction() != Move::Place)) {
-        //LOG(INFO) << "Let's not pass since we have a scoring move";
-        continue;
-      }
-      p->UnsafePlaceMove(move);
-      // LOG(INFO) << "Placing move: " << ss.str();
-      p->RemoveRackTiles(move);
-      p->SwapWithKnownOppRack();
-      move_finder_->CacheCrossesAndScores(p->GetBoard(), move);
-      nodes_.emplace_back(
-          absl::make_unique<GameNode>(move, parent, 0.0, depth));
-      GameNode* child = nodes_.back().get();
-      auto* best_child =
-          AlphaBeta(child, state, !on_turn, depth - 1, alpha, beta, p);
-      p->UnsafeUndoMove(move);
-      // LOG(INFO) << "Undoing move: " << ss.str();
-      p->SetKnownOppRack(original_rack);
-      p->SwapWithKnownOppRack();
-      move_finder_->CacheCrossesAndScores(p->GetBoard(), move);
-      if (best_child->Value() > value) {
-        value = best_child->Value();
-        best_node = child;
-      }
-      if (value > alpha) {
-        alpha = value;
-      }
-      if (alpha >= beta) {
-        break;
-      }
+  const int num_moves = moves.size();
+  if (hash_move_index >= num_moves) {
+    hash_move_index = -1;
+  }
+  // Helpers go through the root's moves from their own offset instead.
+  const int num_root_moves = std::min(cap, num_moves);
+  const int root_offset =
+      (ply == 0) ? worker->root_offset % num_root_moves : 0;
+  // Whether any line below reaches depth 0, tracked apart from the caller's.
+  const bool caller_reached_depth_limit = worker->reached_depth_limit;
+  worker->reached_depth_limit = false;
+  // The player to move maximizes, their opponent minimizes.
+  float value = on_turn ? -1e10 : 1e10;
+  // Moves are tried in sorted order, except that the best move stored for
+  // this position goes first.
+  for (int i = 0; i < num_moves; ++i) {
+    int index = i;
+    if (root_offset > 0) {
+      index = (i < num_root_moves) ? (i + root_offset) % num_root_moves : i;
+    } else if (hash_move_index >= 0) {
+      index = (i == 0) ? hash_move_index : (i <= hash_move_index ? i - 1 : i);
     }
-    parent->SetValue(value);
-    CHECK_NOTNULL(best_node);
-    return best_node;
-  } else {
-    float value = +1e10;
-    for (const Move& move : moves) {
-      // std::stringstream ss;
-      // move.Display(tiles_, ss);
-      // LOG(INFO) << "move #" << i << ": " << ss.str()
-      //           << " equity: " << move.Equity();
-      i++;
-      if (i > cap) {
-        // LOG(INFO) << "i > cap, breaking"
-        //           << " i: " << i << " cap: " << cap;
-        break;
-      }
-      if (can_play && (move.GetAction() != Move::Place)) {
-        // LOG(INFO) << "Let's not pass since we have a scoring move";
-        continue;
-      }
-      p->UnsafePlaceMove(move);
-      // LOG(INFO) << "Placing move: " << ss.str();
-      p->RemoveRackTiles(move);
-      p->SwapWithKnownOppRack();
-      move_finder_->CacheCrossesAndScores(p->GetBoard(), move);
-      nodes_.emplace_back(
-          absl::make_unique<GameNode>(move, parent, 0.0, depth));
-      GameNode* child = nodes_.back().get();
-      auto* best_child =
-          AlphaBeta(child, state, !on_turn, depth - 1, alpha, beta, p);
-      p->UnsafeUndoMove(move);
-      // LOG(INFO) << "Undoing move: " << ss.str();
-      p->SetKnownOppRack(original_rack);
-      p->SwapWithKnownOppRack();
-      move_finder_->CacheCrossesAndScores(p->GetBoard(), move);
-      if (best_child->Value() < value) {
-        value = best_child->Value();
-        best_node = child;
-      }
-      if (value < beta) {
-        beta = value;
-      }
-      if (alpha >= beta) {
-        break;
+    if (index >= cap) {
+      // LOG(INFO) << "index >= cap, skipping"
+      //           << " index: " << index << " cap: " << cap;
+      continue;
+    }
+    const Move& move = moves[index];
+    // std::stringstream ss;
+    // move.Display(tiles_, ss);
+    // LOG(INFO) << "move #" << index << ": " << ss.str()
+    //           << " equity: " << move.Equity();
+    if (can_play && (move.GetAction() != Move::Place)) {
+      // LOG(INFO) << "Let's not pass since we have a scoring move";
+      continue;
+    }
+    p->UnsafePlaceMove(move);
+    // LOG(INFO) << "Placing move: " << ss.str();
+    p->RemoveRackTiles(move);
+    p->SwapWithKnownOppRack();
+    move_finder->CacheCrossesAndScores(p->GetBoard(), move);
+    worker->line[ply].move_index = index;
+    const uint64_t child_hash = board_hash ^ zobrist_.MoveHash(move);
+    float child_value;
+    if (best_move_index < 0) {
+      child_value =
+          AlphaBeta(worker, child_hash, !on_turn, depth - 1, alpha, beta, p);
+    } else {
+      // Principal variation search: the first move searched is expected to
+      // be best, so later ones get a null window that only shows whether
+      // they beat it, and are searched again if they might.
+      const float null_alpha = on_turn ? alpha : beta - kNullWindow;
+      const float null_beta = on_turn ? alpha + kNullWindow : beta;
+      child_value = AlphaBeta(worker, child_hash, !on_turn, depth - 1,
+                              null_alpha, null_beta, p);
+      if (!worker->stopped && child_value > alpha && child_value < beta) {
+        child_value =
+            AlphaBeta(worker, child_hash, !on_turn, depth - 1, alpha, beta, p);
       }
     }
-    parent->SetValue(value);
-    CHECK_NOTNULL(best_node);
-    return best_node;
+    p->UnsafeUndoMove(move);
+    // LOG(INFO) << "Undoing move: " << ss.str();
+    p->SetKnownOppRack(original_rack);
+    p->SwapWithKnownOppRack();
+    move_finder->CacheCrossesAndScores(p->GetBoard(), move);
+    if (worker->stopped) {
+      return 0.0;
+    }
+    if (on_turn ? (child_value > value) : (child_value < value)) {
+      value = child_value;
+      best_move_index = index;
+    }
+    if (on_turn) {
+      alpha = std::max(alpha, value);
+    } else {
+      beta = std::min(beta, value);
+    }
+    if (alpha >= beta) {
+      break;
+    }
   }
-  return nullptr;
-}
\ No newline at end of file
+  CHECK_GE(best_move_index, 0);
+  worker->line[ply].move_index = best_move_index;
+  TranspositionTable::Entry result;
+  result.value = value - scored;
+  // A result that no line reached depth 0 for holds at any depth.
+  result.depth = worker->reached_depth_limit ? depth : kResolvedDepth;
+  worker->reached_depth_limit =
+      worker->reached_depth_limit || caller_reached_depth_limit;
+  if (value <= original_alpha) {
+    result.bound = TranspositionTable::Upper;
+  } else if (value >= original_beta) {
+    result.bound = TranspositionTable::Lower;
+  } else {
+    result.bound = TranspositionTable::Exact;
+  }
+  result.best_move_index = best_move_index;
+  transposition_table_.Store(hash, result);
+  return value;
+}
@@ -1,6 +1,8 @@
 #ifndef SRC_SCRABBLE_ALPHA_BETA_PLAYER_H
 #define SRC_SCRABBLE_ALPHA_BETA_PLAYER_H
 
+#include <atomic>
+
 #include "absl/memory/memory.h"
 #include "src/anagram/anagram_map.h"
 #include "src/leaves/leaves.h"
@@ -13,58 +15,11 @@
 #include "src/scrabble/move.h"
 #include "src/scrabble/move_finder.h"
 #include "src/scrabble/rack.h"
+#include "src/scrabble/transposition_table.h"
+#include "src/scrabble/zobrist.h"
 
 class AlphaBetaPlayer : public ComputerPlayer {
  public:
-  struct PlacedLetter {
-    uint8_t row : 4;
-    uint8_t col : 4;
-    Letter letter;
-  };
-  class GameState {
-   public:
-    GameState(uint64_t on_move_rack_product, uint64_t off_move_rack_product,
-              uint8_t num_placed_letters,
-              std::array<PlacedLetter, 14> placed_letters)
-        : on_move_rack_product_(on_move_rack_product),
-          off_move_rack_product_(off_move_rack_product),
-          num_placed_letters_(num_placed_letters),
-          placed_letters_(placed_letters) {}
-
-   private:
-    uint64_t on_move_rack_product_;
-    uint64_t off_move_rack_product_;
-    uint8_t num_placed_letters_;
-    std::array<PlacedLetter, 14> placed_letters_;
-  };
-
-  class GameNode {
-   public:
-    GameNode(const Move& move, GameNode* parent, float value, uint8_t depth)
-        : move_(move), parent_(parent), value_(value), depth_(depth) {}
-    const Move& GetMove() const { return move_; }
-    const GameNode* Parent() const { return parent_; }
-    float Value() const { return value_; }
-    uint8_t Depth() const { return depth_; }
-    void SetValue(float value) { value_ = value; }
-    float CalculateValue(const GamePosition& position, bool on_turn,
-                         bool terminal) {
-      const float sign = on_turn ? 1.0 : -1.0;
-      const float net = sign * (terminal ? move_.Equity() : move_.Score());
-      // LOG(INFO) << "net: " << net;
-      if (parent_ == nullptr) {
-        return net;
-      }
-      return net + parent_->CalculateValue(position, !on_turn, false);
-    }
-
-   private:
-    Move move_;
-    GameNode* parent_;
-    float value_;
-    uint8_t depth_;
-  };
-
   static void Register() {
     LOG(INFO) << "Registering AlphaBetaPlayer";
     ComponentFactory::GetInstance()->RegisterComputerPlayer(
@@ -86,24 +41,125 @@ class AlphaBetaPlayer : public ComputerPlayer {
         stuck_leave_value_multiplier_(config.stuck_leave_value_multiplier()),
         opp_stuck_score_multiplier_(config.opp_stuck_score_multiplier()),
         unstuck_leave_score_weight_(config.unstuck_leave_score_weight()),
-        unstuck_leave_value_weight_(config.unstuck_leave_value_weight()) {
-    move_finder_ = absl::make_unique<MoveFinder>(
-        *DataManager::GetInstance()->GetAnagramMap(config.anagram_map_file()),
-        *DataManager::GetInstance()->GetBoardLayout(config.board_layout_file()),
-        tiles_, *DataManager::GetInstance()->GetLeaves(config.leaves_file()));
+        unstuck_leave_value_weight_(config.unstuck_leave_value_weight()),
+        time_budget_fraction_(config.time_budget_fraction()),
+        transposition_table_(config.transposition_table_bits() == 0
+                                 ? 18
+                                 : config.transposition_table_bits()) {
+    const int search_threads = std::max(1, config.search_threads());
+    for (int i = 0; i < search_threads; ++i) {
+      auto worker = absl::make_unique<SearchWorker>();
+      worker->move_finder = absl::make_unique<MoveFinder>(
+          *DataManager::GetInstance()->GetAnagramMap(config.anagram_map_file()),
+          *DataManager::GetInstance()->GetBoardLayout(
+              config.board_layout_file()),
+          tiles_, *DataManager::GetInstance()->GetLeaves(config.leaves_file()));
+      worker->move_finder->SetRackTable(
+          DataManager::GetInstance()->GetRackTable(config.rack_table_file()));
+      worker->root_offset = i;
+      workers_.push_back(std::move(worker));
+    }
     for (const auto& cap_per_ply : config.caps_per_ply()) {
       caps_per_ply_.push_back(cap_per_ply);
     }
+    CHECK_LE(static_cast<int>(caps_per_ply_.size()), Zobrist::kMaxCapIndices);
+    root_move_.SetEquity(0.0);
   }
 
   Move ChooseBestMove(const std::vector<GamePosition>* previous_position,
                       const GamePosition& position) override;
 
+  // Depth of the last iteration the most recent ChooseBestMove finished, and
+  // the value of the best line it found: the net score for the player to
+  // move, counting the last move of the line by its equity.
+  int CompletedDepth() const { return completed_depth_; }
+  float BestLineValue() const { return best_line_value_; }
+
  private:
-  GameNode* AlphaBeta(GameNode* parent, const GameState& state, bool on_turn,
-                      int depth, float alpha, float beta, GamePosition* p);
-  std::vector<Move> MovesAfterParent(const GameNode* parent,
-                                     GamePosition* position);
+  // The line being searched, one entry per position on it, starting at the
+  // root. Each ply's moves are generated into a buffer that is reused by
+  // every node at that ply, and a node is just the index of the move being
+  // tried, so a subtree is gone as soon as its next sibling is started and
+  // memory is bounded by depth times branching factor, however many nodes
+  // are visited. Buffers keep their capacity from one search to the next.
+  struct Ply {
+    std::vector<Move> moves;
+    // Index in moves of the move being searched, then of the best one.
+    int move_index;
+    // The other player's moves on the same board, which their moves at the
+    // next ply are found from.
+    std::vector<Move> opp_moves;
+  };
+
+  // Everything a search thread changes as it searches. With search_threads
+  // > 1, every thread searches the whole tree from the root, sharing only
+  // the transposition table ("lazy SMP"): each fills in results the others
+  // can use, and they start from different root moves so that they don't
+  // all search the same lines at once. The first worker's search runs on
+  // the calling thread and decides the move; the others are stopped when it
+  // finishes.
+  struct SearchWorker {
+    std::unique_ptr<MoveFinder> move_finder;
+    std::vector<Ply> line;
+    // The root's moves are tried starting from this one (modulo the root's
+    // cap), rather than from the transposition table's best move.
+    int root_offset;
+    // Whether the search so far has stopped any line at depth 0, rather
+    // than at the end of the game. If not, deeper iterations would find the
+    // same.
+    bool reached_depth_limit;
+    // Set when out of time or, for helpers, when the first worker is done.
+    // Nothing searched after that is stored.
+    bool stopped;
+  };
+
+  // Searches the position at ply search_depth_ - depth of worker's line,
+  // returning the value of its best line from the root. board_hash is
+  // zobrist_.BoardHash(p->GetBoard()), kept up to date as moves are placed
+  // and undone.
+  float AlphaBeta(SearchWorker* worker, uint64_t board_hash, bool on_turn,
+                  int depth, float alpha, float beta, GamePosition* p);
+  // The move played to reach the position at ply.
+  const Move& MoveBefore(const SearchWorker& worker, int ply) const {
+    if (ply == 0) {
+      return root_move_;
+    }
+    const Ply& previous = worker.line[ply - 1];
+    return previous.moves[previous.move_index];
+  }
+  // Net score of the moves played to reach ply for the player to move at the
+  // root, counting the last of them by its equity if terminal.
+  float LineValue(const SearchWorker& worker, int ply, bool terminal) const;
+  // Hash of everything the search below a node depends on: the board, both
+  // racks, which side is to move, whether the last move was a pass and, with
+  // caps_per_ply set, which of the caps apply from this ply on.
+  uint64_t PositionHash(const SearchWorker& worker, int ply,
+                        uint64_t board_hash, bool on_turn,
+                        const GamePosition& p) const;
+  bool PrecededByPass(const SearchWorker& worker, int ply) const {
+    return MoveBefore(worker, ply).GetAction() != Move::Place;
+  }
+  // Checks the clock, except during the first iteration, which has to
+  // finish so that there is a move to play, and whether helpers should
+  // stop.
+  bool Stopped(SearchWorker* worker) {
+    if (!worker->stopped &&
+        ((search_depth_ > first_depth_ && absl::Now() > deadline_) ||
+         (worker != workers_[0].get() &&
+          stop_helpers_.load(std::memory_order_relaxed)))) {
+      worker->stopped = true;
+    }
+    return worker->stopped;
+  }
+  // Generates the moves at ply into worker's line[ply].moves, and the other
+  // player's into line[ply].opp_moves.
+  void MovesAfterParent(SearchWorker* worker, int ply, GamePosition* position);
+
+  // Stored depth of results that searched every line to the end of the
+  // game.
+  static constexpr int kResolvedDepth = TranspositionTable::kMaxDepth;
+  // Width of the windows principal variation search uses to test moves.
+  static constexpr float kNullWindow = 1e-3;
 
   int CapAtPly(int ply) const {
     if (caps_per_ply_.empty()) {
@@ -116,7 +172,6 @@ class AlphaBetaPlayer : public ComputerPlayer {
   }
   const Tiles& tiles_;
   const Leaves& leaves_;
-  std::unique_ptr<MoveFinder> move_finder_;
   int num_plies_;
   bool detect_stuck_tiles_;
   float stuck_tiles_left_multiplier_;
@@ -125,9 +180,25 @@ class AlphaBetaPlayer : public ComputerPlayer {
   float opp_stuck_score_multiplier_;
   float unstuck_leave_score_weight_;
   float unstuck_leave_value_weight_;
-  std::vector<std::unique_ptr<GameNode>> nodes_;
-  GameNode* root_node_;
+  float time_budget_fraction_;
+  // Stands in for the move before the root, and is treated as a pass.
+  Move root_move_;
+  std::vector<std::unique_ptr<SearchWorker>> workers_;
+  std::atomic<bool> stop_helpers_;
   std::vector<int> caps_per_ply_;
+
+  // Depths of the first and current iterations, and when to stop.
+  int first_depth_;
+  int search_depth_;
+  absl::Time deadline_;
+  int completed_depth_ = 0;
+  float best_line_value_ = 0;
+
+  // Results are stored relative to the node they were searched from: the
+  // value of the best line minus the scores already played to reach the
+  // node, which is the same however the node was reached.
+  const Zobrist zobrist_;
+  TranspositionTable transposition_table_;
 };
 
 #endif  // SRC_SCRABBLE_ALPHA_BETA_PLAYER_H
\ No newline at end of file
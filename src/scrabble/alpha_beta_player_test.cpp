@@ -113,7 +113,7 @@ TEST_F(AlphaBetaPlayerTest, Ming) {
 
   const Rack rack(tiles->ToLetterString("MILDING").value());
   auto pos = absl::make_unique<GamePosition>(
-      *layout, board, 1, 2, rack, 395, 448, 0, absl::Minutes(25), 0, *tiles);
+      *layout, board, 1, 2, rack, 395, 448, 0, 0, absl::Minutes(25), 0, *tiles);
   std::stringstream ss2;
   pos->Display(ss2);
   LOG(INFO) << "position:" << std::endl << ss2.str();
@@ -184,7 +184,7 @@ TEST_F(AlphaBetaPlayerTest, Alkyd) {
 
   const Rack rack(tiles->ToLetterString("AADDILW").value());
   auto pos = absl::make_unique<GamePosition>(
-      *layout, board, 1, 2, rack, 471, 384, 0, absl::Minutes(25), 0, *tiles);
+      *layout, board, 1, 2, rack, 471, 384, 0, 0, absl::Minutes(25), 0, *tiles);
   std::stringstream ss2;
   pos->Display(ss2);
   LOG(INFO) << "position:" << std::endl << ss2.str();
@@ -255,7 +255,7 @@ TEST_F(AlphaBetaPlayerTest, ViceOrVirge) {
 
   const Rack rack(tiles->ToLetterString("EEIIDRV").value());
   auto pos = absl::make_unique<GamePosition>(
-      *layout, board, 1, 2, rack, 345, 446, 0, absl::Minutes(25), 0, *tiles);
+      *layout, board, 1, 2, rack, 345, 446, 0, 0, absl::Minutes(25), 0, *tiles);
   std::stringstream ss2;
   pos->Display(ss2);
   LOG(INFO) << "position:" << std::endl << ss2.str();
@@ -326,7 +326,7 @@ TEST_F(AlphaBetaPlayerTest, Gio) {
 
   const Rack rack(tiles->ToLetterString("EPILOGI").value());
   auto pos = absl::make_unique<GamePosition>(
-      *layout, board, 1, 2, rack, 345, 446, 0, absl::Minutes(25), 0, *tiles);
+      *layout, board, 1, 2, rack, 345, 446, 0, 0, absl::Minutes(25), 0, *tiles);
   std::stringstream ss2;
   pos->Display(ss2);
   LOG(INFO) << "position:" << std::endl << ss2.str();
@@ -398,7 +398,7 @@ TEST_F(AlphaBetaPlayerTest, Ort) {
 
   const Rack rack(tiles->ToLetterString("TORICS").value());
   auto pos = absl::make_unique<GamePosition>(
-      *layout, board, 1, 2, rack, 395, 459, 0, absl::Minutes(25), 0, *tiles);
+      *layout, board, 1, 2, rack, 395, 459, 0, 0, absl::Minutes(25), 0, *tiles);
   std::stringstream ss2;
   pos->Display(ss2);
   LOG(INFO) << "position:" << std::endl << ss2.str();
@@ -469,7 +469,7 @@ TEST_F(AlphaBetaPlayerTest, Bo) {
 
   const Rack rack(tiles->ToLetterString("BOQ").value());
   auto pos = absl::make_unique<GamePosition>(
-      *layout, board, 1, 2, rack, 395, 459, 0, absl::Minutes(25), 0, *tiles);
+      *layout, board, 1, 2, rack, 395, 459, 0, 0, absl::Minutes(25), 0, *tiles);
   std::stringstream ss2;
   pos->Display(ss2);
   LOG(INFO) << "position:" << std::endl << ss2.str();
@@ -540,7 +540,7 @@ TEST_F(AlphaBetaPlayerTest, Fillets) {
 
   const Rack rack(tiles->ToLetterString("CIS").value());
   auto pos = absl::make_unique<GamePosition>(
-      *layout, board, 1, 2, rack, 395, 459, 0, absl::Minutes(25), 0, *tiles);
+      *layout, board, 1, 2, rack, 395, 459, 0, 0, absl::Minutes(25), 0, *tiles);
   std::stringstream ss2;
   pos->Display(ss2);
   LOG(INFO) << "position:" << std::endl << ss2.str();
@@ -611,7 +611,7 @@ TEST_F(AlphaBetaPlayerTest, Pi) {
 
   const Rack rack(tiles->ToLetterString("CI").value());
   auto pos = absl::make_unique<GamePosition>(
-      *layout, board, 1, 2, rack, 395, 459, 0, absl::Minutes(25), 0, *tiles);
+      *layout, board, 1, 2, rack, 395, 459, 0, 0, absl::Minutes(25), 0, *tiles);
   std::stringstream ss2;
   pos->Display(ss2);
   LOG(INFO) << "position:" << std::endl << ss2.str();
@@ -682,7 +682,7 @@ TEST_F(AlphaBetaPlayerTest, Pic) {
 
   const Rack rack(tiles->ToLetterString("C").value());
   auto pos = absl::make_unique<GamePosition>(
-      *layout, board, 1, 2, rack, 395, 459, 0, absl::Minutes(25), 0, *tiles);
+      *layout, board, 1, 2, rack, 395, 459, 0, 0, absl::Minutes(25), 0, *tiles);
   std::stringstream ss2;
   pos->Display(ss2);
   LOG(INFO) << "position:" << std::endl << ss2.str();
@@ -754,7 +754,7 @@ TEST_F(AlphaBetaPlayerTest, Eik) {
 
   const Rack rack(tiles->ToLetterString("EIK").value());
   auto pos = absl::make_unique<GamePosition>(
-      *layout, board, 1, 2, rack, 465, 524, 0, absl::Minutes(25), 0, *tiles);
+      *layout, board, 1, 2, rack, 465, 524, 0, 0, absl::Minutes(25), 0, *tiles);
   std::stringstream ss2;
   pos->Display(ss2);
   LOG(INFO) << "position:" << std::endl << ss2.str();
@@ -826,7 +826,7 @@ TEST_F(AlphaBetaPlayerTest, Drent) {
 
   const Rack rack(tiles->ToLetterString("TRNDING").value());
   auto pos = absl::make_unique<GamePosition>(
-      *layout, board, 1, 2, rack, 381, 388, 0, absl::Minutes(25), 0, *tiles);
+      *layout, board, 1, 2, rack, 381, 388, 0, 0, absl::Minutes(25), 0, *tiles);
   std::stringstream ss2;
   pos->Display(ss2);
   LOG(INFO) << "position:" << std::endl << ss2.str();
@@ -898,11 +898,183 @@ TEST_F(AlphaBetaPlayerTest, Reverb) {
 
   const Rack rack(tiles->ToLetterString("EIBRSVW").value());
   auto pos = absl::make_unique<GamePosition>(
-      *layout, board, 1, 2, rack, 350, 502, 0, absl::Minutes(25), 0, *tiles);
+      *layout, board, 1, 2, rack, 350, 502, 0, 0, absl::Minutes(25), 0, *tiles);
   std::stringstream ss2;
   pos->Display(ss2);
   LOG(INFO) << "position:" << std::endl << ss2.str();
   auto* computer_player = static_cast<ComputerPlayer*>(player.get());
   const auto move = computer_player->ChooseBestMove(nullptr, *pos);
   ExpectMove(move, {"F1 ..VERB (score = 30)"});
-}
\ No newline at end of file
+}
+
+// With almost no time, the depth 1 search still finishes and its best move
+// is played.
+TEST_F(AlphaBetaPlayerTest, TimeBudget) {
+  Arena arena;
+  auto config = Arena::CreateMessage<q2::proto::AlphaBetaPlayerConfig>(&arena);
+  google::protobuf::TextFormat::ParseFromString(R"(
+        id: 1
+        name: "AlphaBetaPlayer"
+        nickname: "A"
+        anagram_map_file: "src/scrabble/testdata/csw21.qam"
+        board_layout_file: "src/scrabble/testdata/scrabble_board.textproto"
+        tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+        leaves_file: "src/scrabble/testdata/csw_scrabble_macondo.qlv"
+        plies: 20
+        detect_stuck_tiles: true
+        stuck_tiles_left_multiplier: 0.2
+        stuck_leave_score_multiplier: 1.0
+        stuck_leave_value_multiplier: 0.2
+        opp_stuck_score_multiplier: 2.0
+        unstuck_leave_score_weight: 0.4
+        unstuck_leave_value_weight: 0.1
+        caps_per_ply: 100
+        caps_per_ply: 50
+        caps_per_ply: 50
+        caps_per_ply: 2
+        time_budget_fraction: 0.000001
+        )",
+                                                config);
+  auto player = absl::make_unique<AlphaBetaPlayer>(*config);
+  ASSERT_NE(player, nullptr);
+
+  DataManager* dm = DataManager::GetInstance();
+  const Tiles* tiles =
+      dm->GetTiles("src/scrabble/testdata/english_scrabble_tiles.textproto");
+  EXPECT_NE(tiles, nullptr);
+
+  Board board;
+  board.SetLetters(
+      {R"(   A B C D E F G H I J K L M N O   -> olaugh     IIDGLMN   395)",
+       R"(   ------------------------------     cwac       ADINRSY   448)",
+       R"( 1|P     '       F E R N L E s S| --Speedy Player's choices---)",
+       R"( 2|A -       B O U N "       -  | best  12L MING   26 IDL)",
+       R"( 3|T W O C K E R S '   J   -    |  4.00 12L MILD   26 IGN)",
+       R"( 4|I     O E     C     O F     '|  5.00 12L DING   22 ILM)",
+       R"( 5|O     L A           T O      |  8.00 12L MIND   26 IGL)",
+       R"( 6|  "   L   " Q     P A H   "  |  13.0 12L LING   18 IDM)",
+       R"( 7|    ' I     A   ' H   N '    |  27.0 12L DIG    16 ILMN)",
+       R"( 8|I G A D     T A X I   S O W M|  29.0 12L LIND   18 IGM)",
+       R"( 9|  A Y E     ' T I Z     '    |  39.0 O7  M(M)   6  IIDGLN)",
+       R"(10|  N E R V U R E   "       "  |  40.0 O8  (M)M   6  IIDGLN)",
+       R"(11|        - R E s T I V E      |  46.0 O6  LI(M)N 6  IDGM)",
+       R"(12|B O U T A D E '       -     '| --Tracking------------------)",
+       R"(13|E U G E     '   '       -    | ADINRSY  7)",
+       R"(14|  -       "       "       -  |)",
+       R"(15|=     '       =       '     =|)",
+       R"(   ------------------------------)"},
+      *tiles);
+
+  const BoardLayout* layout =
+      dm->GetBoardLayout("src/scrabble/testdata/scrabble_board.textproto");
+  std::stringstream ss1;
+  layout->DisplayBoard(board, *tiles, ss1);
+  LOG(INFO) << "board:" << std::endl << ss1.str();
+
+  const Rack rack(tiles->ToLetterString("MILDING").value());
+  auto pos = absl::make_unique<GamePosition>(
+      *layout, board, 1, 2, rack, 395, 448, 0, 0, absl::Minutes(25), 0, *tiles);
+  std::stringstream ss2;
+  pos->Display(ss2);
+  LOG(INFO) << "position:" << std::endl << ss2.str();
+  const auto move = player->ChooseBestMove(nullptr, *pos);
+  // The deadline passes during the first iteration, which finishes anyway,
+  // and the search stops well short of the full 20 plies.
+  EXPECT_GE(player->CompletedDepth(), 1);
+  EXPECT_LT(player->CompletedDepth(), 20);
+
+  // The move played is one of the rack's legal moves.
+  MoveFinder move_finder(
+      *dm->GetAnagramMap("src/scrabble/testdata/csw21.qam"), *layout, *tiles,
+      *dm->GetLeaves("src/scrabble/testdata/csw_scrabble_macondo.qlv"));
+  const Bag empty_bag(*tiles, {});
+  move_finder.FindMoves(rack, board, empty_bag, MoveFinder::RecordAll, true);
+  std::vector<std::string> legal_moves;
+  for (const Move& legal_move : move_finder.Moves()) {
+    std::stringstream ss;
+    legal_move.Display(*tiles, ss);
+    legal_moves.push_back(ss.str());
+  }
+  EXPECT_EQ(move.GetAction(), Move::Place);
+  ExpectMoveAmong(move, legal_moves);
+}
+
+// Helper threads share the transposition table, and the search finds a line
+// as good as a single thread's.
+TEST_F(AlphaBetaPlayerTest, SearchThreads) {
+  Arena arena;
+  auto config = Arena::CreateMessage<q2::proto::AlphaBetaPlayerConfig>(&arena);
+  google::protobuf::TextFormat::ParseFromString(R"(
+        id: 1
+        name: "AlphaBetaPlayer"
+        nickname: "A"
+        anagram_map_file: "src/scrabble/testdata/csw21.qam"
+        board_layout_file: "src/scrabble/testdata/scrabble_board.textproto"
+        tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+        leaves_file: "src/scrabble/testdata/csw_scrabble_macondo.qlv"
+        plies: 20
+        detect_stuck_tiles: true
+        stuck_tiles_left_multiplier: 0.2
+        stuck_leave_score_multiplier: 1.0
+        stuck_leave_value_multiplier: 0.2
+        opp_stuck_score_multiplier: 2.0
+        unstuck_leave_score_weight: 0.4
+        unstuck_leave_value_weight: 0.1
+        caps_per_ply: 100
+        caps_per_ply: 50
+        caps_per_ply: 50
+        caps_per_ply: 2
+        )",
+                                                config);
+  auto serial_player = absl::make_unique<AlphaBetaPlayer>(*config);
+  ASSERT_NE(serial_player, nullptr);
+  config->set_search_threads(2);
+  auto player = absl::make_unique<AlphaBetaPlayer>(*config);
+  ASSERT_NE(player, nullptr);
+
+  DataManager* dm = DataManager::GetInstance();
+  const Tiles* tiles =
+      dm->GetTiles("src/scrabble/testdata/english_scrabble_tiles.textproto");
+  EXPECT_NE(tiles, nullptr);
+
+  Board board;
+  board.SetLetters(
+      {R"(   A B C D E F G H I J K L M N O   -> olaugh     IIDGLMN   395)",
+       R"(   ------------------------------     cwac       ADINRSY   448)",
+       R"( 1|P     '       F E R N L E s S| --Speedy Player's choices---)",
+       R"( 2|A -       B O U N "       -  | best  12L MING   26 IDL)",
+       R"( 3|T W O C K E R S '   J   -    |  4.00 12L MILD   26 IGN)",
+       R"( 4|I     O E     C     O F     '|  5.00 12L DING   22 ILM)",
+       R"( 5|O     L A           T O      |  8.00 12L MIND   26 IGL)",
+       R"( 6|  "   L   " Q     P A H   "  |  13.0 12L LING   18 IDM)",
+       R"( 7|    ' I     A   ' H   N '    |  27.0 12L DIG    16 ILMN)",
+       R"( 8|I G A D     T A X I   S O W M|  29.0 12L LIND   18 IGM)",
+       R"( 9|  A Y E     ' T I Z     '    |  39.0 O7  M(M)   6  IIDGLN)",
+       R"(10|  N E R V U R E   "       "  |  40.0 O8  (M)M   6  IIDGLN)",
+       R"(11|        - R E s T I V E      |  46.0 O6  LI(M)N 6  IDGM)",
+       R"(12|B O U T A D E '       -     '| --Tracking------------------)",
+       R"(13|E U G E     '   '       -    | ADINRSY  7)",
+       R"(14|  -       "       "       -  |)",
+       R"(15|=     '       =       '     =|)",
+       R"(   ------------------------------)"},
+      *tiles);
+
+  const BoardLayout* layout =
+      dm->GetBoardLayout("src/scrabble/testdata/scrabble_board.textproto");
+  std::stringstream ss1;
+  layout->DisplayBoard(board, *tiles, ss1);
+  LOG(INFO) << "board:" << std::endl << ss1.str();
+
+  const Rack rack(tiles->ToLetterString("MILDING").value());
+  auto pos = absl::make_unique<GamePosition>(
+      *layout, board, 1, 2, rack, 395, 448, 0, 0, absl::Minutes(25), 0, *tiles);
+  std::stringstream ss2;
+  pos->Display(ss2);
+  LOG(INFO) << "position:" << std::endl << ss2.str();
+  serial_player->ChooseBestMove(nullptr, *pos);
+  const auto move = player->ChooseBestMove(nullptr, *pos);
+  // Which of several equally good moves is found first depends on how the
+  // threads are scheduled, but the value of the best line doesn't.
+  EXPECT_EQ(move.GetAction(), Move::Place);
+  EXPECT_FLOAT_EQ(player->BestLineValue(), serial_player->BestLineValue());
+}
@@ -84,6 +84,10 @@ std::unique_ptr<ComputerPlayer> ComponentFactory::CreatePlayerFromConfig(
       return ComponentFactory::GetInstance()->CreateComputerPlayer(
           config.simming_player_config());
       break;
+    case q2::proto::ComputerPlayerConfig::kPreendgamePlayerConfig:
+      return ComponentFactory::GetInstance()->CreateComputerPlayer(
+          config.preendgame_player_config());
+      break;
     case q2::proto::ComputerPlayerConfig::PLAYER_NOT_SET:
       LOG(ERROR) << "No player type specified for player "
                  << config.DebugString();
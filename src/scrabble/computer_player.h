@@ -6,12 +6,21 @@
 #include "src/scrabble/move.h"
 #include "src/scrabble/player.h"
 
+struct CrossesAndScores;
+
 class ComputerPlayer : public Player {
  public:
   ComputerPlayer(std::string name, std::string nickname, int id)
       : Player(name, nickname, Player::Computer, id) {}
   virtual ~ComputerPlayer() = 0;
   void SetStartOfTurnTime();
+  absl::Time StartOfTurnTime() const { return start_of_turn_time_; }
+
+  // Called after ResetGameState() when the game starts from a board that
+  // already has tiles, with that board's crosses and scores. Players that
+  // cache crosses can copy these rather than rescanning the board.
+  virtual void SetRootCrossesAndScores(
+      const CrossesAndScores& crosses_and_scores) {}
   
  private:
   absl::Time start_of_turn_time_;
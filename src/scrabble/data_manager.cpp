@@ -26,6 +26,13 @@ void DataManager::LoadData(const q2::proto::DataCollection& data_collection) {
         AnagramMap::CreateFromBinaryFile(*tiles, spec.anagram_map_filename());
     anagram_maps_.emplace(spec.anagram_map_filename(), std::move(anagram_map));
   }
+  for (const std::string& filename : data_collection.rack_table_files()) {
+    auto rack_table = RackTable::CreateFromOrtFile(filename);
+    if (rack_table == nullptr) {
+      LOG(FATAL) << "Could not load rack table " << filename;
+    }
+    rack_tables_.emplace(filename, std::move(rack_table));
+  }
 }
 
 const Tiles* DataManager::GetTiles(const std::string& filename) {
@@ -59,4 +66,12 @@ const Leaves* DataManager::GetLeaves(const std::string& filename) {
     return it->second.get();
   }
   return nullptr;
-}
\ No newline at end of file
+}
+
+const RackTable* DataManager::GetRackTable(const std::string& filename) {
+  const auto it = rack_tables_.find(filename);
+  if (it != rack_tables_.end()) {
+    return it->second.get();
+  }
+  return nullptr;
+}
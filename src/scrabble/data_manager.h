@@ -7,6 +7,7 @@
 
 #include "src/anagram/anagram_map.h"
 #include "src/leaves/leaves.h"
+#include "src/rack_table/rack_table.h"
 #include "src/scrabble/board_layout.h"
 #include "src/scrabble/computer_players.pb.h"
 #include "src/scrabble/tiles.h"
@@ -22,6 +23,7 @@ class DataManager {
   const BoardLayout* GetBoardLayout(const std::string& filename);
   const Tiles* GetTiles(const std::string& filename);
   const Leaves* GetLeaves(const std::string& filename);
+  const RackTable* GetRackTable(const std::string& filename);
 
  private:
   DataManager() = default;
@@ -29,6 +31,7 @@ class DataManager {
   std::unordered_map<std::string, std::unique_ptr<BoardLayout>> board_layouts_;
   std::unordered_map<std::string, std::unique_ptr<Tiles>> tiles_;
   std::unordered_map<std::string, std::unique_ptr<Leaves>> leaves_;
+  std::unordered_map<std::string, std::unique_ptr<RackTable>> rack_tables_;
 };
 
 #endif  // SRC_SCRABBLE_DATA_MANAGER_H
@@ -0,0 +1,114 @@
+#include "src/scrabble/endgame_move_pool.h"
+
+#include "glog/logging.h"
+
+constexpr uint64_t EndgameMovePool::kGuardBits;
+
+EndgameMovePool::EndgameMovePool(const Tiles& tiles, const Board& board,
+                                 const std::vector<Move>& on_moves,
+                                 const std::vector<Move>& off_moves)
+    : occupancy_(Occupancy(board)) {
+  on_plays_.reserve(on_moves.size());
+  for (const auto& move : on_moves) {
+    on_plays_.push_back(MakePlay(tiles, board, move));
+  }
+  off_plays_.reserve(off_moves.size());
+  for (const auto& move : off_moves) {
+    off_plays_.push_back(MakePlay(tiles, board, move));
+  }
+}
+
+EndgameMovePool::SquareMask EndgameMovePool::Occupancy(const Board& board) {
+  SquareMask occupancy;
+  for (int row = 0; row < 15; ++row) {
+    for (int col = 0; col < 15; ++col) {
+      if (board.At(row, col)) {
+        occupancy.set(Square(row, col));
+      }
+    }
+  }
+  return occupancy;
+}
+
+EndgameMovePool::LetterCounts EndgameMovePool::Counts(
+    const Tiles& tiles, const LetterString& letters) {
+  LetterCounts counts = {0, 0};
+  for (Letter letter : letters) {
+    if (!letter) {
+      continue;
+    }
+    if (letter > tiles.BlankIndex()) {
+      letter = tiles.BlankIndex();
+    }
+    CHECK_LT(letter, 32);
+    uint64_t* word = (letter < 16) ? &counts.low : &counts.high;
+    const int shift = 4 * (letter % 16);
+    CHECK_LT((*word >> shift) & 0xf, 7);
+    *word += 1ULL << shift;
+  }
+  return counts;
+}
+
+void EndgameMovePool::ToLetters(const LetterCounts& counts,
+                                LetterString* letters) {
+  letters->clear();
+  for (int letter = 0; letter < 32; ++letter) {
+    const uint64_t word = (letter < 16) ? counts.low : counts.high;
+    const int count = (word >> (4 * (letter % 16))) & 0xf;
+    for (int i = 0; i < count; ++i) {
+      letters->push_back(letter);
+    }
+  }
+}
+
+EndgameMovePool::Play EndgameMovePool::MakePlay(const Tiles& tiles,
+                                                const Board& board,
+                                                const Move& move) {
+  Play play;
+  play.move = &move;
+  play.counts = Counts(tiles, move.Letters());
+  play.tile_score = 0;
+  for (const Letter letter : move.Letters()) {
+    if (letter && letter < tiles.BlankIndex()) {
+      play.tile_score += tiles.Score(letter);
+    }
+  }
+  if (move.GetAction() != Move::Place) {
+    return play;
+  }
+  const int row_step = (move.Direction() == Move::Down) ? 1 : 0;
+  const int col_step = (move.Direction() == Move::Across) ? 1 : 0;
+  auto in_bounds = [](int row, int col) {
+    return row >= 0 && row < 15 && col >= 0 && col < 15;
+  };
+  int row = move.StartRow();
+  int col = move.StartCol();
+  if (in_bounds(row - row_step, col - col_step)) {
+    play.blockers.set(Square(row - row_step, col - col_step));
+  }
+  for (const Letter letter : move.Letters()) {
+    if (letter) {
+      play.squares.set(Square(row, col));
+      // Perpendicular to the play, past any tiles already there.
+      for (const int sign : {-1, 1}) {
+        int hook_row = row + sign * col_step;
+        int hook_col = col + sign * row_step;
+        while (in_bounds(hook_row, hook_col) &&
+               board.At(hook_row, hook_col)) {
+          hook_row += sign * col_step;
+          hook_col += sign * row_step;
+        }
+        if (in_bounds(hook_row, hook_col)) {
+          play.hook_squares.set(Square(hook_row, hook_col));
+        }
+      }
+    }
+    row += row_step;
+    col += col_step;
+  }
+  if (in_bounds(row, col)) {
+    play.blockers.set(Square(row, col));
+  }
+  play.blockers |= play.squares;
+  return play;
+}
@@ -0,0 +1,105 @@
+#ifndef SRC_SCRABBLE_ENDGAME_MOVE_POOL_H
+#define SRC_SCRABBLE_ENDGAME_MOVE_POOL_H
+
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+#include "src/scrabble/board.h"
+#include "src/scrabble/move.h"
+#include "src/scrabble/strings.h"
+#include "src/scrabble/tiles.h"
+
+// The plays found for both racks in an endgame position, each with what's
+// needed to tell with a few bitwise operations whether it can still be
+// played after more moves, instead of walking the board and recounting the
+// rack for every play at every node.
+//
+// Boards only fill up during an endgame, so relative to the position the
+// pool was built for, a play is blocked once a tile lands on one of its
+// squares or just before or after it, and its cross-checks can only have
+// changed once a tile lands at the end of the perpendicular run through one
+// of its squares. Only then do the hook tables need to be consulted again.
+// Plays that become possible only because of later moves aren't in the pool.
+class EndgameMovePool {
+ public:
+  using SquareMask = std::bitset<225>;
+  // One 4-bit field per letter (designated blanks count as the blank), with
+  // counts of at most 7, so one rack's counts can be compared with another's
+  // a word at a time.
+  struct LetterCounts {
+    uint64_t low;
+    uint64_t high;
+  };
+  struct Play {
+    // Not owned.
+    const Move* move;
+    // Squares its tiles go on.
+    SquareMask squares;
+    // Those and the squares just before and after it.
+    SquareMask blockers;
+    // Empty squares which would extend the perpendicular words through its
+    // squares if filled.
+    SquareMask hook_squares;
+    LetterCounts counts;
+    // Sum of the scores of the tiles it places (nothing for blanks).
+    int tile_score;
+  };
+
+  // Moves must outlive the pool, and must be legal on board. on_moves are
+  // for the player to move and off_moves for their opponent.
+  EndgameMovePool(const Tiles& tiles, const Board& board,
+                  const std::vector<Move>& on_moves,
+                  const std::vector<Move>& off_moves);
+
+  // In the order of the moves passed in.
+  const std::vector<Play>& OnPlays() const { return on_plays_; }
+  const std::vector<Play>& OffPlays() const { return off_plays_; }
+
+  // Occupied squares of the board the pool was built for.
+  const SquareMask& Occupancy() const { return occupancy_; }
+
+  static SquareMask Occupancy(const Board& board);
+  static int Square(int row, int col) { return row * 15 + col; }
+  static LetterCounts Counts(const Tiles& tiles, const LetterString& letters);
+  // Counts of letters in sorted order, as in a Rack.
+  static void ToLetters(const LetterCounts& counts, LetterString* letters);
+  // counts must be a subset of superset.
+  static LetterCounts Difference(const LetterCounts& superset,
+                                 const LetterCounts& counts) {
+    return {superset.low - counts.low, superset.high - counts.high};
+  }
+  static bool Equal(const LetterCounts& a, const LetterCounts& b) {
+    return a.low == b.low && a.high == b.high;
+  }
+  static bool IsSubset(const LetterCounts& counts,
+                       const LetterCounts& superset) {
+    return (((superset.low | kGuardBits) - counts.low) & kGuardBits) ==
+               kGuardBits &&
+           (((superset.high | kGuardBits) - counts.high) & kGuardBits) ==
+               kGuardBits;
+  }
+
+  // Whether a tile has been placed on or next to play in line, given the
+  // occupancy of a board reached from the pool's.
+  static bool IsBlocked(const Play& play, const SquareMask& occupancy) {
+    return (play.blockers & occupancy).any();
+  }
+  // Whether play's cross-checks may differ from those of the pool's board.
+  static bool HooksMayHaveChanged(const Play& play,
+                                  const SquareMask& occupancy) {
+    return (play.hook_squares & occupancy).any();
+  }
+
+ private:
+  static constexpr uint64_t kGuardBits = 0x8888888888888888ULL;
+
+  static Play MakePlay(const Tiles& tiles, const Board& board,
+                       const Move& move);
+
+  SquareMask occupancy_;
+  std::vector<Play> on_plays_;
+  std::vector<Play> off_plays_;
+};
+
+#endif  // SRC_SCRABBLE_ENDGAME_MOVE_POOL_H
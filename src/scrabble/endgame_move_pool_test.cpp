@@ -0,0 +1,99 @@
+#include "src/scrabble/endgame_move_pool.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/scrabble/board.h"
+#include "src/scrabble/move.h"
+#include "src/scrabble/tiles.h"
+
+class EndgameMovePoolTest : public testing::Test {
+ protected:
+  EndgameMovePoolTest()
+      : tiles_("src/scrabble/testdata/english_scrabble_tiles.textproto") {}
+
+  Move ParseMove(const std::string& s) {
+    return Move::Parse(s, tiles_).value();
+  }
+
+  EndgameMovePool::LetterCounts Counts(const std::string& s) {
+    return EndgameMovePool::Counts(tiles_, tiles_.ToLetterString(s).value());
+  }
+
+  Tiles tiles_;
+};
+
+TEST_F(EndgameMovePoolTest, IsSubset) {
+  const auto rack = Counts("AEIRST?");
+  EXPECT_TRUE(EndgameMovePool::IsSubset(Counts("RATES"), rack));
+  EXPECT_TRUE(EndgameMovePool::IsSubset(Counts("AEIRST?"), rack));
+  EXPECT_TRUE(EndgameMovePool::IsSubset(Counts(""), rack));
+  // A designated blank uses the blank.
+  EXPECT_TRUE(EndgameMovePool::IsSubset(Counts("RaTES"), rack));
+  EXPECT_FALSE(EndgameMovePool::IsSubset(Counts("RaTEs"), rack));
+  EXPECT_FALSE(EndgameMovePool::IsSubset(Counts("RATTLE"), rack));
+  EXPECT_FALSE(EndgameMovePool::IsSubset(Counts("AA"), rack));
+
+  const auto repeated = Counts("EEEEEEE");
+  EXPECT_TRUE(EndgameMovePool::IsSubset(Counts("EEEEEEE"), repeated));
+  EXPECT_FALSE(EndgameMovePool::IsSubset(Counts("EEEEEEE"), Counts("EEEEEE")));
+  EXPECT_FALSE(EndgameMovePool::IsSubset(Counts("Z"), repeated));
+}
+
+TEST_F(EndgameMovePoolTest, Difference) {
+  const auto leave = EndgameMovePool::Difference(Counts("AEIRST?"),
+                                                 Counts("RaTES"));
+  LetterString letters;
+  EndgameMovePool::ToLetters(leave, &letters);
+  EXPECT_EQ(letters, tiles_.ToLetterString("AI").value());
+  EndgameMovePool::ToLetters(Counts("TEA?TE"), &letters);
+  EXPECT_EQ(letters, tiles_.ToLetterString("AEETT?").value());
+}
+
+TEST_F(EndgameMovePoolTest, BlockersAndHookSquares) {
+  Board board;
+  board.UnsafePlaceMove(ParseMove("8D QUACK"));
+  const std::vector<Move> on_moves = {ParseMove("9C DO"),
+                                      Move(Move::Exchange, {}, 0)};
+  const std::vector<Move> off_moves = {ParseMove("H8 .IT")};
+  const EndgameMovePool pool(tiles_, board, on_moves, off_moves);
+  EXPECT_EQ(pool.Occupancy().count(), 5);
+  ASSERT_EQ(pool.OnPlays().size(), 2);
+  ASSERT_EQ(pool.OffPlays().size(), 1);
+
+  const auto& play = pool.OnPlays()[0];
+  EXPECT_EQ(play.move, &on_moves[0]);
+  EXPECT_EQ(play.tile_score, 3);
+  EXPECT_EQ(play.squares.count(), 2);
+  EXPECT_TRUE(play.squares.test(EndgameMovePool::Square(8, 2)));
+  EXPECT_TRUE(play.squares.test(EndgameMovePool::Square(8, 3)));
+  EXPECT_EQ(play.blockers.count(), 4);
+  EXPECT_TRUE(play.blockers.test(EndgameMovePool::Square(8, 1)));
+  EXPECT_TRUE(play.blockers.test(EndgameMovePool::Square(8, 4)));
+  // Above D and below both tiles, and above the Q that O is played under.
+  EXPECT_EQ(play.hook_squares.count(), 4);
+  EXPECT_TRUE(play.hook_squares.test(EndgameMovePool::Square(7, 2)));
+  EXPECT_TRUE(play.hook_squares.test(EndgameMovePool::Square(6, 3)));
+  EXPECT_TRUE(play.hook_squares.test(EndgameMovePool::Square(9, 2)));
+  EXPECT_TRUE(play.hook_squares.test(EndgameMovePool::Square(9, 3)));
+
+  auto occupancy = pool.Occupancy();
+  EXPECT_FALSE(EndgameMovePool::IsBlocked(play, occupancy));
+  EXPECT_FALSE(EndgameMovePool::HooksMayHaveChanged(play, occupancy));
+  occupancy.set(EndgameMovePool::Square(6, 3));
+  EXPECT_FALSE(EndgameMovePool::IsBlocked(play, occupancy));
+  EXPECT_TRUE(EndgameMovePool::HooksMayHaveChanged(play, occupancy));
+  occupancy.set(EndgameMovePool::Square(8, 4));
+  EXPECT_TRUE(EndgameMovePool::IsBlocked(play, occupancy));
+
+  // Passing is never blocked.
+  const auto& pass = pool.OnPlays()[1];
+  EXPECT_TRUE(pass.blockers.none());
+  EXPECT_TRUE(pass.hook_squares.none());
+
+  // Only the squares a play through a tile places on.
+  const auto& kit = pool.OffPlays()[0];
+  EXPECT_EQ(kit.squares.count(), 2);
+  EXPECT_FALSE(kit.squares.test(EndgameMovePool::Square(7, 7)));
+  EXPECT_TRUE(kit.blockers.test(EndgameMovePool::Square(6, 7)));
+  EXPECT_TRUE(kit.blockers.test(EndgameMovePool::Square(10, 7)));
+}
@@ -1,5 +1,12 @@
 #include "src/scrabble/endgame_player.h"
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "absl/types/optional.h"
+#include "src/scrabble/endgame_move_pool.h"
 #include "src/scrabble/move_finder.h"
 #include "src/scrabble/rack.h"
 
@@ -8,87 +15,93 @@ Move EndgamePlayer::ChooseBestMove(
     const GamePosition& pos) {
   // LOG(INFO) << "EndgamePlayer::ChooseBestMove";
   SetStartOfTurnTime();
-  move_finder_->FindMoves(pos.GetRack(), pos.GetBoard(),
-                          pos.GetUnseenToPlayer(), MoveFinder::RecordAll, true);
-  const auto on_moves_const = move_finder_->Moves();
+  MoveFinder* move_finder = search_threads_[0]->move_finder.get();
+  move_finder->FindMoves(pos.GetRack(), pos.GetBoard(), pos.NumUnseen(),
+                         MoveFinder::RecordAll, true);
+  const auto on_moves_const = move_finder->Moves();
   // LOG(INFO) << "on_moves_const.size(): " << on_moves_const.size();
+  const GamePosition off_pos = pos.SwapRacks();
+  move_finder->FindMoves(off_pos.GetRack(), off_pos.GetBoard(),
+                         off_pos.NumUnseen(), MoveFinder::RecordAll, true);
+  const auto off_moves_const = move_finder->Moves();
+  // LOG(INFO) << "off_moves_const.size(): " << off_moves_const.size();
+  const EndgameMovePool pool(tiles_, pos.GetBoard(), on_moves_const,
+                             off_moves_const);
   std::vector<MoveWithDelta> on_moves;
-  on_moves.reserve(on_moves_const.size());
-  for (auto& move : on_moves_const) {
-    on_moves.emplace_back(&move);
-    on_moves.back().SetEquity(move.Score());
+  on_moves.reserve(pool.OnPlays().size());
+  for (const auto& play : pool.OnPlays()) {
+    on_moves.emplace_back(&play);
+    on_moves.back().SetEquity(play.move->Score());
   }
   std::sort(on_moves.begin(), on_moves.end(),
             [](const MoveWithDelta& a, const MoveWithDelta& b) {
               return a.Score() > b.Score();
             });
-  const GamePosition off_pos = pos.SwapRacks();
-  move_finder_->FindMoves(off_pos.GetRack(), off_pos.GetBoard(),
-                          off_pos.GetUnseenToPlayer(), MoveFinder::RecordAll,
-                          true);
-  const auto off_moves_const = move_finder_->Moves();
-  // LOG(INFO) << "off_moves_const.size(): " << off_moves_const.size();
   std::vector<MoveWithDelta> off_moves;
-  off_moves.reserve(off_moves_const.size());
-  for (auto& move : off_moves_const) {
-    off_moves.emplace_back(&move);
-    off_moves.back().SetEquity(move.Score());
+  off_moves.reserve(pool.OffPlays().size());
+  for (const auto& play : pool.OffPlays()) {
+    off_moves.emplace_back(&play);
+    off_moves.back().SetEquity(play.move->Score());
   }
   std::sort(off_moves.begin(), off_moves.end(),
             [](const MoveWithDelta& a, const MoveWithDelta& b) {
               return a.Score() > b.Score();
             });
-  auto on_moves_greedy = on_moves;
-  for (auto& move : on_moves_greedy) {
-    move.SetEquity(GreedyEndgameEquity(pos, move, on_moves, off_moves));
-    // std::stringstream ss;
-    // move.Display(tiles_, ss);
-    // LOG(INFO) << "on_move: " << ss.str() << " " << move.Equity();
+  CrossesAndScores root_crosses;
+  move_finder->GetCrossesAndScores(&root_crosses);
+  for (int i = 1; i < search_threads_.size(); ++i) {
+    search_threads_[i]->move_finder->SetCrossesAndScores(root_crosses);
   }
+  CacheSubRackBonuses(pos.GetRack().Counts(), &sub_rack_bonuses_[0]);
+  CacheSubRackBonuses(pos.UnseenCounts(), &sub_rack_bonuses_[1]);
+  auto on_moves_greedy = on_moves;
+  ForEachIndex(on_moves_greedy.size(),
+               [&](int i, SearchThread* search_thread) {
+                 auto& move = on_moves_greedy[i];
+                 move.SetEquity(GreedyEndgameEquity(
+                     pos, move, on_moves, off_moves, pool, search_thread));
+               });
   // LOG(INFO) << "Sorting " << on_moves_greedy.size() << " moves";
-  MoveWithDelta* best_move = nullptr;
-  float equity_to_beat = 9999;
-  int i = 0;
-  for (auto& move : on_moves_greedy) {
-    if (++i > CapAtPly(0)) {
-      break;
-    }
-    if (num_plies_ == 1) {
+  const int num_candidates =
+      std::min<int>(CapAtPly(0), on_moves_greedy.size());
+  if (num_plies_ == 1) {
+    // Replies only have to show that a candidate is worse than the best one
+    // evaluated so far, by any thread. A candidate cut short that way gets
+    // an equity below the best, as it would have if evaluated in full, so
+    // the move chosen is the same however many threads there are.
+    std::mutex best_equity_mutex;
+    absl::optional<float> best_equity;
+    ForEachIndex(num_candidates, [&](int i, SearchThread* search_thread) {
+      auto& move = on_moves_greedy[i];
       if (move.GetMove()->Leave().size() > 0) {
-        if (best_move != nullptr) {
-          equity_to_beat = move.Score() - best_move->Equity();
-          // std::stringstream ss;
-          // best_move->GetMove()->Display(tiles_, ss);
-          // LOG(INFO) << "best_move: " << ss.str() << " " <<
-          // best_move->Equity(); std::stringstream ss2;
-          // move.GetMove()->Display(tiles_, ss2);
-          // LOG(INFO) << "move: " << ss2.str();
-          // LOG(INFO) << "equity_to_beat: " << equity_to_beat;
+        float equity_to_beat = 9999;
+        {
+          std::lock_guard<std::mutex> lock(best_equity_mutex);
+          if (best_equity.has_value()) {
+            equity_to_beat = move.Score() - best_equity.value();
+          }
         }
-        move.SetEquity(EvaluateAllResponses(pos, equity_to_beat, move));
+        move.SetEquity(
+            EvaluateAllResponses(pos, equity_to_beat, move, off_moves_const,
+                                 root_crosses, search_thread));
         // std::stringstream ss;
         // move.GetMove()->Display(tiles_, ss);
         // LOG(INFO) << "evaluated replies to move giving: " << ss.str() << " "
         //           << move.Equity();
       }
-    }
+      std::lock_guard<std::mutex> lock(best_equity_mutex);
+      if (!best_equity.has_value() || move.Equity() > best_equity.value()) {
+        best_equity = move.Equity();
+      }
+    });
+  }
+  MoveWithDelta* best_move = nullptr;
+  for (int i = 0; i < num_candidates; ++i) {
+    auto& move = on_moves_greedy[i];
     if (best_move == nullptr || move.Equity() > best_move->Equity()) {
       best_move = &move;
     }
   }
-  /*
-  std::sort(
-      on_moves_greedy.begin(), on_moves_greedy.end(),
-      [](const Move& a, const Move& b) { return a.Equity() > b.Equity(); });
-  for (auto& move : on_moves_greedy) {
-    std::stringstream ss;
-    move.Display(tiles_, ss);
-    LOG(INFO) << ss.str() << " " << move.Equity();
-  }
-  */
-  // CHECK_GE(on_moves_greedy.size(), 1);
-  // return on_moves_greedy[0];
-
   CHECK(best_move != nullptr);
   std::stringstream ss;
   best_move->GetMove()->Display(tiles_, ss);
@@ -96,9 +109,36 @@ Move EndgamePlayer::ChooseBestMove(
   return *best_move->GetMove();
 }
 
-float EndgamePlayer::EvaluateAllResponses(GamePosition pos,
-                                          float equity_to_beat,
-                                          const MoveWithDelta& candidate_move) {
+void EndgamePlayer::ForEachIndex(
+    int n, const std::function<void(int, SearchThread*)>& fn) const {
+  const int num_threads = search_threads_.size();
+  if (num_threads == 1) {
+    for (int i = 0; i < n; ++i) {
+      fn(i, search_threads_[0].get());
+    }
+    return;
+  }
+  std::atomic<int> next_index(0);
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (int t = 0; t < num_threads; ++t) {
+    SearchThread* search_thread = search_threads_[t].get();
+    threads.emplace_back([&, search_thread]() {
+      for (int i = next_index++; i < n; i = next_index++) {
+        fn(i, search_thread);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+float EndgamePlayer::EvaluateAllResponses(
+    GamePosition pos, float equity_to_beat, const MoveWithDelta& candidate_move,
+    const std::vector<Move>& root_off_moves,
+    const CrossesAndScores& root_crosses, SearchThread* search_thread) {
+  MoveFinder* move_finder = search_thread->move_finder.get();
   // LOG(INFO) << "EvaluateAllResponses...";
   // std::stringstream move_ss;
   // candidate_move.GetMove()->Display(tiles_, move_ss);
@@ -115,31 +155,36 @@ float EndgamePlayer::EvaluateAllResponses(GamePosition pos,
   // std::stringstream pos_ss2;
   // pos.Display(pos_ss2);
   // LOG(INFO) << "pos: " << std::endl << pos_ss2.str();
-  move_finder_->FindMoves(pos.GetRack(), pos.GetBoard(),
-                          pos.GetUnseenToPlayer(), MoveFinder::RecordAll, true);
-  const auto on_moves_const = move_finder_->Moves();
+  // The player to move now had the same rack at the root, so their moves
+  // there only need updating for the candidate.
+  move_finder->SetCrossesAndScores(root_crosses);
+  move_finder->CacheCrossesAndScores(pos.GetBoard(), *candidate_move.GetMove());
+  move_finder->FindMovesAfter(pos.GetRack(), pos.GetBoard(),
+                              *candidate_move.GetMove(), root_off_moves);
+  const auto on_moves_const = move_finder->Moves();
   // LOG(INFO) << "on_moves_const.size(): " << on_moves_const.size();
+  const GamePosition off_pos = pos.SwapRacks();
+  move_finder->FindMoves(off_pos.GetRack(), off_pos.GetBoard(),
+                         off_pos.NumUnseen(), MoveFinder::RecordAll, false);
+  const auto off_moves_const = move_finder->Moves();
+  // LOG(INFO) << "off_moves_const.size(): " << off_moves_const.size();
+  const EndgameMovePool pool(tiles_, pos.GetBoard(), on_moves_const,
+                             off_moves_const);
   std::vector<MoveWithDelta> on_moves;
-  on_moves.reserve(on_moves_const.size());
-  for (auto& move : on_moves_const) {
-    on_moves.emplace_back(&move);
-    on_moves.back().SetEquity(move.Score());
+  on_moves.reserve(pool.OnPlays().size());
+  for (const auto& play : pool.OnPlays()) {
+    on_moves.emplace_back(&play);
+    on_moves.back().SetEquity(play.move->Score());
   }
   std::sort(on_moves.begin(), on_moves.end(),
             [](const MoveWithDelta& a, const MoveWithDelta& b) {
               return a.Score() > b.Score();
             });
-  const GamePosition off_pos = pos.SwapRacks();
-  move_finder_->FindMoves(off_pos.GetRack(), off_pos.GetBoard(),
-                          off_pos.GetUnseenToPlayer(), MoveFinder::RecordAll,
-                          true);
-  const auto off_moves_const = move_finder_->Moves();
-  // LOG(INFO) << "off_moves_const.size(): " << off_moves_const.size();
   std::vector<MoveWithDelta> off_moves;
-  off_moves.reserve(off_moves_const.size());
-  for (auto& move : off_moves_const) {
-    off_moves.emplace_back(&move);
-    off_moves.back().SetEquity(move.Score());
+  off_moves.reserve(pool.OffPlays().size());
+  for (const auto& play : pool.OffPlays()) {
+    off_moves.emplace_back(&play);
+    off_moves.back().SetEquity(play.move->Score());
   }
   std::sort(off_moves.begin(), off_moves.end(),
             [](const MoveWithDelta& a, const MoveWithDelta& b) {
@@ -151,7 +196,8 @@ float EndgamePlayer::EvaluateAllResponses(GamePosition pos,
     if (++i > CapAtPly(1)) {
       break;
     }
-    move.SetEquity(GreedyEndgameEquity(pos, move, on_moves, off_moves));
+    move.SetEquity(GreedyEndgameEquity(pos, move, on_moves, off_moves, pool,
+                                       search_thread));
     if (move.Equity() > (equity_to_beat + 1e-5)) {
       // std::stringstream ss;
       // move.GetMove()->Display(tiles_, ss);
@@ -197,187 +243,137 @@ float EndgamePlayer::EvaluateAllResponses(GamePosition pos,
   return candidate_move.Score() - best_move->Equity();
 }
 
-float EndgamePlayer::GreedyEndgameEquity(const GamePosition& pos,
-                                         const MoveWithDelta& move,
-                                         std::vector<MoveWithDelta> on_moves,
-                                         std::vector<MoveWithDelta> off_moves) {
+EndgamePlayer::PlayoutRack EndgamePlayer::MakePlayoutRack(
+    const std::array<int, 32>& counts) const {
+  LetterString letters;
+  for (Letter letter = tiles_.FirstLetter(); letter <= tiles_.BlankIndex();
+       ++letter) {
+    for (int i = 0; i < counts[letter]; ++i) {
+      letters.push_back(letter);
+    }
+  }
+  PlayoutRack rack;
+  rack.counts = EndgameMovePool::Counts(tiles_, letters);
+  rack.num_tiles = letters.size();
+  rack.deadwood = tiles_.Score(letters);
+  return rack;
+}
+
+float EndgamePlayer::GreedyEndgameEquity(
+    const GamePosition& pos, const MoveWithDelta& move,
+    const std::vector<MoveWithDelta>& on_moves,
+    const std::vector<MoveWithDelta>& off_moves, const EndgameMovePool& pool,
+    SearchThread* search_thread) {
   float net = move.Score();
   if (move.GetMove()->Leave().size() == 0) {
     // outplay
     int deadwood = 0;
-    for (const Letter& letter : pos.GetUnseenToPlayer().Letters()) {
-      deadwood += tiles_.Score(letter);
+    const auto& unseen_counts = pos.UnseenCounts();
+    for (Letter letter = tiles_.FirstLetter(); letter <= tiles_.BlankIndex();
+         ++letter) {
+      deadwood += tiles_.Score(letter) * unseen_counts[letter];
     }
     return net + deadwood * 2;
   }
 
-  GamePosition pos_copy = pos;
-  pos_copy.SetKnownOppRack(pos.GetUnseenToPlayer());
+  MoveFinder* move_finder = search_thread->move_finder.get();
+  PlayoutScratch& scratch = search_thread->scratch;
+  // Indexed by side: 0 for the player to move in pos, 1 for their opponent.
+  const std::array<const std::vector<MoveWithDelta>*, 2> moves_by_side = {
+      &on_moves, &off_moves};
+  for (int side = 0; side < 2; ++side) {
+    const int num_moves = moves_by_side[side]->size();
+    scratch.ruled_out[side].assign((num_moves + 63) / 64, 0);
+  }
+  std::array<PlayoutRack, 2> racks = {MakePlayoutRack(pos.GetRack().Counts()),
+                                      MakePlayoutRack(pos.UnseenCounts())};
+  scratch.board = pos.GetBoard();
+  const Board& board = scratch.board;
+  EndgameMovePool::SquareMask occupancy = pool.Occupancy();
+
   const MoveWithDelta* move_to_place = &move;
-  int scoreless = pos_copy.ScorelessTurns();
-  std::vector<const Move*> moves_with_crosses_applied;
+  int scoreless = pos.ScorelessTurns();
+  float result;
   for (int ply = 1;; ++ply) {
-    // std::stringstream ss;
-    // move_to_place->GetMove()->Display(tiles_, ss);
-    // LOG(INFO) << "ply: " << ply << " move: " << ss.str();
-    if (move_to_place->GetMove()->GetAction() == Move::Action::Place) {
-      // LOG(INFO) << "placing move: " << ss.str();
-      pos_copy.RemoveRackTiles(*move_to_place->GetMove());
-      pos_copy.UnsafePlaceMove(*move_to_place->GetMove());
+    // The side that played move_to_place, and the side to move now.
+    const int mover = (ply + 1) % 2;
+    const int side = ply % 2;
+    const Move& placed = *move_to_place->GetMove();
+    if (placed.GetAction() == Move::Action::Place) {
+      const EndgameMovePool::Play& play = *move_to_place->GetPlay();
+      PlayoutRack& mover_rack = racks[mover];
+      mover_rack.counts =
+          EndgameMovePool::Difference(mover_rack.counts, play.counts);
+      mover_rack.num_tiles -= placed.CachedNumTiles();
+      mover_rack.deadwood -= play.tile_score;
+      scratch.board.UnsafePlaceMove(placed);
+      occupancy |= play.squares;
     }
-    pos_copy.SwapWithKnownOppRack();
 
-    const Board& board = pos_copy.GetBoard();
-    // std::stringstream ss2;
-    // pos_copy.Display(ss2);
-    // LOG(INFO) << "pos: " << std::endl << ss2.str();
-    int opp_deadwood = 0;
-    for (const Letter& letter : pos_copy.GetKnownOppRack().Letters()) {
-      opp_deadwood += tiles_.Score(letter);
-    }
-    int own_deadwood = 0;
-    const auto& rack = pos_copy.GetRack();
-    for (const Letter& letter : rack.Letters()) {
-      own_deadwood += tiles_.Score(letter);
-    }
-    bool on_turn = ply % 2 == 0;
-    auto& moves = on_turn ? on_moves : off_moves;
-    int sign = on_turn ? 1 : -1;
-    // LOG(INFO) << "moves.size(): " << moves.size();
-    // if (ply > 1) {
-    //  RemoveMovesNotOnRack(&moves, new_pos.GetRack());
-    //}
-    // LOG(INFO) << "after removing moves with used tiles: moves.size(): "
-    //           << moves.size();
-    if (move_to_place->GetMove()->GetAction() == Move::Action::Place) {
-      // move_finder_->CacheCrossesAndScores(board);
-      move_finder_->CacheCrossesAndScores(board, *move_to_place->GetMove());
-      moves_with_crosses_applied.push_back(move_to_place->GetMove());
-    }
-    // RemoveBlockedMoves(&moves, board);
-    //  LOG(INFO) << "after removing blocked moves: moves.size(): " <<
-    //  moves.size();
-    const int size_of_outplays = pos_copy.GetRack().NumTiles();
-    // AddDeadwood(&moves, opp_deadwood * 2, size_of_outplays);
-
-    const int num_tiles = rack.NumTiles();
-    const auto rack_counts = rack.Counts();
-    uint32_t rack_bits = 0;
-    for (const Letter letter : rack.Letters()) {
-      rack_bits |= 1 << letter;
-    }
-    const uint32_t rack_mask = ~rack_bits;
-    auto counts_copy = rack_counts;
-    move_to_place = nullptr;
-    float best_bonus = -9999;
-    for (auto& move : moves) {
-      if (move.GetMove() == nullptr) {
-        continue;
-      }
-      if (ply > 1) {
-        if ((move.GetMove()->CachedNumTiles() > num_tiles) ||
-            (move.GetMove()->MoveBits() & rack_mask)) {
-          move.Nullify();
-          continue;
-        } else {
-          bool counts_copy_decremented = false;
-          if (!move.GetMove()->IsSubsetOf(tiles_, &counts_copy,
-                                          &counts_copy_decremented)) {
-            move.Nullify();
-          }
-          if (counts_copy_decremented) {
-            counts_copy = rack_counts;
-          }
-        }
-        if (move.GetMove() == nullptr) {
-          continue;
-        }
-      }
-      float bonus = 0.0;
-      if (move.GetMove()->CachedNumTiles() == size_of_outplays) {
-        bonus = opp_deadwood * 2;
-      } else if ((leave_score_weight_ > 1e-5) || (leave_value_weight_ > 1e-5)) {
-        int leave_score = own_deadwood;
-        auto leave = rack;
-        LetterString move_tiles;
-        for (const Letter& letter : move.GetMove()->Letters()) {
-          if (letter == 0) {
-            continue;
-          }
-          if (letter >= tiles_.BlankIndex()) {
-            move_tiles.push_back(tiles_.BlankIndex());
-            continue;
-          }
-          move_tiles.push_back(letter);
-          leave_score -= tiles_.Score(letter);
-        }
-
-        // LOG(INFO) << "move_tiles: " << tiles_.ToString(move_tiles).value()
-        //           << " leave: " << tiles_.ToString(leave.Letters()).value();
-
-        bonus -= leave_score * leave_score_weight_;
-        if (leave_value_weight_ > 1e-5) {
-          if (leave.Letters().size() < 7) {
-            leave.RemoveTiles(move_tiles, tiles_);
-            float leave_value =
-                leaves_.Value(tiles_.ToProduct64(leave.Letters()));
-            bonus += leave_value * leave_value_weight_;
-          }
-        }
-      }
-      if (bonus > best_bonus) {
-        best_bonus = bonus;
-      }
-      move.SetEquity(move.Score() + bonus);
-    }
-    // LOG(INFO) << "best_bonus: " << best_bonus;
-    /*
-    std::sort(moves.begin(), moves.end(),
-              [](const MoveWithDelta& a, const MoveWithDelta& b) {
-                if ((a.GetMove() == nullptr) && (b.GetMove() == nullptr)) {
-                  return &a < &b;
-                }
-                if (a.GetMove() == nullptr) {
-                  return false;
-                }
-                if (b.GetMove() == nullptr) {
-                  return true;
-                }
-                return a.Equity() > b.Equity();
-              });
-    */
-    for (auto& move : moves) {
-      if (move.GetMove() == nullptr) {
+    const PlayoutRack& rack = racks[side];
+    const int opp_deadwood = racks[mover].deadwood;
+    const int own_deadwood = rack.deadwood;
+    const int sign = (side == 0) ? 1 : -1;
+    const auto& moves = *moves_by_side[side];
+    auto& ruled_out = scratch.ruled_out[side];
+    const int num_moves = moves.size();
+    const bool use_leaves =
+        (leave_score_weight_ > 1e-5) || (leave_value_weight_ > 1e-5);
+    // Going out is worth twice the opponent's tiles, anything else at most
+    // the best leave the rack can keep.
+    const float out_bonus = opp_deadwood * 2;
+    const float max_leave_bonus =
+        use_leaves ? MaxLeaveBonus(rack) : 0.0;
+    const float max_bonus = std::max(out_bonus, max_leave_bonus);
+    int best_index = -1;
+    float best_equity = 0.0;
+    for (int i = 0; i < num_moves; ++i) {
+      uint64_t& ruled_out_word = ruled_out[i / 64];
+      const uint64_t ruled_out_bit = 1ULL << (i % 64);
+      if (ruled_out_word & ruled_out_bit) {
         continue;
       }
-      if ((move_to_place != nullptr) &&
-          (move_to_place->Equity() > move.Score() + best_bonus)) {
+      if ((best_index >= 0) && (best_equity > moves[i].Score() + max_bonus)) {
         // Moves are in descending score order, so no remaining moves can reach
         // the equity of the best move.
-        // std::stringstream ss;
-        // move_to_place->GetMove()->Display(tiles_, ss);
-        // LOG(INFO) << "move_to_place: " << ss.str() << " equity: "
-        //          << move_to_place->Equity();
-        // LOG(INFO) << "move scores are down to " << move.Score() << " so can't
-        // reach best equity anymore";
         break;
       }
-      if (move_finder_->IsBlocked(*move.GetMove(), board)) {
-        move.Nullify();
+      const EndgameMovePool::Play& play = *moves[i].GetPlay();
+      if ((best_index >= 0) &&
+          (best_equity > moves[i].Score() + max_leave_bonus) &&
+          !EndgameMovePool::Equal(play.counts, rack.counts)) {
+        // Only plays that go out can still beat the best move.
         continue;
       }
-      // std::stringstream ss;
-      // move.GetMove()->Display(tiles_, ss);
-      // LOG(INFO) << "move: " << ss.str() << " " << move.Equity();
-      CHECK_NE(move.GetMove(), nullptr);
-      if ((move_to_place == nullptr) ||
-          (move.Equity() > move_to_place->Equity())) {
-        move_to_place = &move;
+      // Every play in the pool hooks on the pool's board, so hooks only need
+      // checking (on the playout's board, rather than keeping MoveFinder's
+      // cache up to date with every play placed) once the perpendicular words
+      // through the play's squares could have changed.
+      if ((ply > 1 && !EndgameMovePool::IsSubset(play.counts, rack.counts)) ||
+          EndgameMovePool::IsBlocked(play, occupancy) ||
+          (EndgameMovePool::HooksMayHaveChanged(play, occupancy) &&
+           !move_finder->CheckHooksOnBoard(board, *play.move))) {
+        ruled_out_word |= ruled_out_bit;
+        continue;
+      }
+      float bonus = 0.0;
+      if (play.move->CachedNumTiles() == rack.num_tiles) {
+        bonus = opp_deadwood * 2;
+      } else if (use_leaves) {
+        bonus = LeaveBonus(
+            EndgameMovePool::Difference(rack.counts, play.counts),
+            own_deadwood - play.tile_score, rack.num_tiles, &scratch.leave);
+      }
+      const float equity = moves[i].Score() + bonus;
+      if ((best_index < 0) || (equity > best_equity)) {
+        best_index = i;
+        best_equity = equity;
       }
     }
 
     // At very least, we can pass.
-    CHECK_NE(move_to_place, nullptr);
+    CHECK_GE(best_index, 0);
+    move_to_place = &moves[best_index];
 
     if (move_to_place->GetMove()->GetAction() == Move::Exchange) {
       scoreless++;
@@ -385,39 +381,101 @@ float EndgamePlayer::GreedyEndgameEquity(const GamePosition& pos,
       scoreless = 0;
     }
     if (scoreless >= 2) {
-      // LOG(INFO) << "opp_deadwood: " << opp_deadwood
-      //           << " own_deadwood: " << own_deadwood;
-      // LOG(INFO) << "returning " << net + sign * (opp_deadwood -
-      // own_deadwood);
-      for (int move_index = moves_with_crosses_applied.size() - 1;
-           move_index >= 0; move_index--) {
-        // std::stringstream ss3;
-        // moves_with_crosses_applied[move_index]->Display(tiles_, ss3);
-        // LOG(INFO) << "undoing move: " << ss3.str();
-        pos_copy.UnsafeUndoMove(*moves_with_crosses_applied[move_index]);
-        move_finder_->CacheCrossesAndScores(
-            board, *moves_with_crosses_applied[move_index]);
-      }
-      return net + sign * (opp_deadwood - own_deadwood);
+      result = net + sign * (opp_deadwood - own_deadwood);
+      break;
     }
-    int tiles_played = move_to_place->GetMove()->CachedNumTiles();
+    const int tiles_played = move_to_place->GetMove()->CachedNumTiles();
     net += sign * move_to_place->Score();
-    // LOG(INFO) << "net: " << net;
-    if (tiles_played == rack.NumTiles()) {
-      // LOG(INFO) << "deadwood: " << opp_deadwood;
-      // LOG(INFO) << "returning " << net + sign * opp_deadwood * 2;
-      for (int move_index = moves_with_crosses_applied.size() - 1;
-           move_index >= 0; move_index--) {
-        pos_copy.UnsafeUndoMove(*moves_with_crosses_applied[move_index]);
-        move_finder_->CacheCrossesAndScores(
-            board, *moves_with_crosses_applied[move_index]);
+    if (tiles_played == rack.num_tiles) {
+      result = net + sign * opp_deadwood * 2;
+      break;
+    }
+  }
+  return result;
+}
+
+float EndgamePlayer::LeaveBonus(const EndgameMovePool::LetterCounts& leave,
+                                int leave_score, int rack_tiles,
+                                LetterString* letters) const {
+  float bonus = 0.0;
+  bonus -= leave_score * leave_score_weight_;
+  if ((leave_value_weight_ > 1e-5) && (rack_tiles < 7)) {
+    EndgameMovePool::ToLetters(leave, letters);
+    bonus += leaves_.Value(*letters) * leave_value_weight_;
+  }
+  return bonus;
+}
+
+void EndgamePlayer::CacheSubRackBonuses(const std::array<int, 32>& counts,
+                                        SubRackBonuses* bonuses) const {
+  bonuses->rack = MakePlayoutRack(counts).counts;
+  bonuses->letters.clear();
+  bonuses->strides.clear();
+  int num_sub_racks = 1;
+  for (Letter letter = tiles_.FirstLetter(); letter <= tiles_.BlankIndex();
+       ++letter) {
+    if (counts[letter] > 0) {
+      bonuses->letters.push_back(letter);
+      bonuses->strides.push_back(num_sub_racks);
+      num_sub_racks *= counts[letter] + 1;
+    }
+  }
+  // The empty sub-rack has no leave to keep.
+  bonuses->max_bonuses.assign(num_sub_racks, -9999);
+  bonuses->max_score_bonuses.assign(num_sub_racks, -9999);
+  std::vector<int> digits(bonuses->letters.size(), 0);
+  EndgameMovePool::LetterCounts leave = {0, 0};
+  int leave_score = 0;
+  LetterString letters;
+  for (int index = 1; index < num_sub_racks; ++index) {
+    // Counts up to the next sub-rack, keeping leave and its score in step.
+    for (int i = 0;; ++i) {
+      const Letter letter = bonuses->letters[i];
+      uint64_t* word = (letter < 16) ? &leave.low : &leave.high;
+      const uint64_t one = 1ULL << (4 * (letter % 16));
+      if (digits[i] < counts[letter]) {
+        digits[i]++;
+        *word += one;
+        leave_score += tiles_.Score(letter);
+        break;
       }
-      // std::stringstream ss;
-      // move_to_place->GetMove()->Display(tiles_, ss);
-      // LOG(INFO) << "ply: " << ply + 1 << " move: " << ss.str();
-      return net + sign * opp_deadwood * 2;
+      *word -= one * digits[i];
+      leave_score -= digits[i] * tiles_.Score(letter);
+      digits[i] = 0;
+    }
+    // The sub-rack itself as the leave, or the best leave of a sub-rack one
+    // tile smaller, which come earlier.
+    float max_bonus = LeaveBonus(leave, leave_score, 0, &letters);
+    float max_score_bonus = LeaveBonus(leave, leave_score, 7, &letters);
+    for (int i = 0; i < digits.size(); ++i) {
+      if (digits[i] > 0) {
+        const int smaller = index - bonuses->strides[i];
+        max_bonus = std::max(max_bonus, bonuses->max_bonuses[smaller]);
+        max_score_bonus =
+            std::max(max_score_bonus, bonuses->max_score_bonuses[smaller]);
+      }
+    }
+    bonuses->max_bonuses[index] = max_bonus;
+    bonuses->max_score_bonuses[index] = max_score_bonus;
+  }
+}
+
+float EndgamePlayer::MaxLeaveBonus(const PlayoutRack& rack) const {
+  for (const auto& bonuses : sub_rack_bonuses_) {
+    if (!EndgameMovePool::IsSubset(rack.counts, bonuses.rack)) {
+      continue;
+    }
+    int index = 0;
+    for (int i = 0; i < bonuses.letters.size(); ++i) {
+      const Letter letter = bonuses.letters[i];
+      const uint64_t word = (letter < 16) ? rack.counts.low : rack.counts.high;
+      index += ((word >> (4 * (letter % 16))) & 0xf) * bonuses.strides[i];
     }
+    return (rack.num_tiles < 7) ? bonuses.max_bonuses[index]
+                                : bonuses.max_score_bonuses[index];
   }
+  LOG(FATAL) << "Playout rack isn't a sub-rack of either root rack";
+  return 0.0;
 }
 
 float EndgamePlayer::StaticEndgameEquity(const GamePosition& pos,
@@ -429,8 +487,10 @@ float EndgamePlayer::StaticEndgameEquity(const GamePosition& pos,
   if (move.Leave().size() == 0) {
     // outplay
     int deadwood = 0;
-    for (const Letter& letter : pos.GetUnseenToPlayer().Letters()) {
-      deadwood += tiles_.Score(letter);
+    const auto& unseen_counts = pos.UnseenCounts();
+    for (Letter letter = tiles_.FirstLetter(); letter <= tiles_.BlankIndex();
+         ++letter) {
+      deadwood += tiles_.Score(letter) * unseen_counts[letter];
     }
     equity += deadwood * 2;
   }
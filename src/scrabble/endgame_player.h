@@ -1,14 +1,19 @@
 #ifndef SRC_SCRABBLE_ENDGAME_PLAYER_H
 #define SRC_SCRABBLE_ENDGAME_PLAYER_H
 
+#include <array>
+#include <functional>
+
 #include "absl/memory/memory.h"
 #include "src/anagram/anagram_map.h"
 #include "src/leaves/leaves.h"
+#include "src/scrabble/board.h"
 #include "src/scrabble/board_layout.h"
 #include "src/scrabble/component_factory.h"
 #include "src/scrabble/computer_player.h"
 #include "src/scrabble/computer_players.pb.h"
 #include "src/scrabble/data_manager.h"
+#include "src/scrabble/endgame_move_pool.h"
 #include "src/scrabble/game_position.h"
 #include "src/scrabble/move.h"
 #include "src/scrabble/move_finder.h"
@@ -18,10 +23,13 @@ class EndgamePlayer : public ComputerPlayer {
  public:
   class MoveWithDelta {
    public:
-    MoveWithDelta(const Move* move)
-        : move_(move), score_(move->Score()), equity_(move->Equity()) {}
+    MoveWithDelta(const EndgameMovePool::Play* play)
+        : move_(play->move),
+          play_(play),
+          score_(play->move->Score()),
+          equity_(play->move->Equity()) {}
     const Move* GetMove() const { return move_; }
-    inline void Nullify() { move_ = nullptr; }
+    const EndgameMovePool::Play* GetPlay() const { return play_; }
     inline void SetScore(int score) { score_ = score; }
     inline void SetEquity(float equity) { equity_ = equity; }
     int Score() const { return score_; }
@@ -29,6 +37,7 @@ class EndgamePlayer : public ComputerPlayer {
 
    private:
     const Move* move_;
+    const EndgameMovePool::Play* play_;
     int score_;
     float equity_;
   };
@@ -50,10 +59,20 @@ class EndgamePlayer : public ComputerPlayer {
         num_plies_(config.plies()),
         leave_score_weight_(config.leave_score_weight()),
         leave_value_weight_(config.leave_value_weight()) {
-    move_finder_ = absl::make_unique<MoveFinder>(
-        *DataManager::GetInstance()->GetAnagramMap(config.anagram_map_file()),
-        *DataManager::GetInstance()->GetBoardLayout(config.board_layout_file()),
-        tiles_, *DataManager::GetInstance()->GetLeaves(config.leaves_file()));
+    const int search_threads = std::max(1, config.search_threads());
+    for (int i = 0; i < search_threads; ++i) {
+      auto move_finder = absl::make_unique<MoveFinder>(
+          *DataManager::GetInstance()->GetAnagramMap(config.anagram_map_file()),
+          *DataManager::GetInstance()->GetBoardLayout(
+              config.board_layout_file()),
+          tiles_, *DataManager::GetInstance()->GetLeaves(config.leaves_file()));
+      move_finder->SetNumThreads(std::max(1, config.move_finder_threads()));
+      move_finder->SetRackTable(
+          DataManager::GetInstance()->GetRackTable(config.rack_table_file()));
+      auto search_thread = absl::make_unique<SearchThread>();
+      search_thread->move_finder = std::move(move_finder);
+      search_threads_.push_back(std::move(search_thread));
+    }
     for (const auto& cap_per_ply : config.caps_per_ply()) {
       caps_per_ply_.push_back(cap_per_ply);
     }
@@ -63,13 +82,77 @@ class EndgamePlayer : public ComputerPlayer {
                       const GamePosition& position) override;
 
  private:
+  // A rack during a greedy playout, as counts rather than letters.
+  struct PlayoutRack {
+    EndgameMovePool::LetterCounts counts;
+    int num_tiles;
+    int deadwood;
+  };
+
+  // Reused by every greedy playout on a thread, so that playouts don't copy
+  // the move lists or the position. For each of the lists of moves for the
+  // player to move and their opponent, a bit per move that has been ruled
+  // out earlier in the playout (racks only shrink and the board only fills
+  // up, so they stay out).
+  struct PlayoutScratch {
+    std::array<std::vector<uint64_t>, 2> ruled_out;
+    Board board;
+    LetterString leave;
+  };
+
+  // The most LeaveBonus(...) a play from each sub-rack of rack could get
+  // without going out. Sub-racks are indexed by their count of each of
+  // rack's distinct letters, as digits of radix one more than rack's count.
+  struct SubRackBonuses {
+    EndgameMovePool::LetterCounts rack;
+    std::vector<Letter> letters;
+    std::vector<int> strides;
+    // For sub-racks of fewer than 7 tiles, which use leave values.
+    std::vector<float> max_bonuses;
+    // For 7-tile racks, which don't.
+    std::vector<float> max_score_bonuses;
+  };
+
+  struct SearchThread {
+    std::unique_ptr<MoveFinder> move_finder;
+    PlayoutScratch scratch;
+  };
+
+  // Calls fn(i, search_thread) for each i in [0, n), spread over one thread
+  // per entry in search_threads_ (in order, on this thread, if there is only
+  // one). Each call gets a SearchThread no other thread is using.
+  void ForEachIndex(
+      int n, const std::function<void(int, SearchThread*)>& fn) const;
+  // pool was built for pos, with on_moves and off_moves its plays in
+  // descending score order. search_thread's cached crosses and scores are
+  // neither used nor changed.
   float GreedyEndgameEquity(const GamePosition& pos, const MoveWithDelta& move,
-                            std::vector<MoveWithDelta> on_moves,
-                            std::vector<MoveWithDelta> off_moves);
+                            const std::vector<MoveWithDelta>& on_moves,
+                            const std::vector<MoveWithDelta>& off_moves,
+                            const EndgameMovePool& pool,
+                            SearchThread* search_thread);
+  PlayoutRack MakePlayoutRack(const std::array<int, 32>& counts) const;
+  // Greedy playout bonus for a play that keeps leave, worth leave_score, from
+  // a rack of rack_tiles tiles without going out.
+  float LeaveBonus(const EndgameMovePool::LetterCounts& leave, int leave_score,
+                   int rack_tiles, LetterString* letters) const;
+  void CacheSubRackBonuses(const std::array<int, 32>& counts,
+                           SubRackBonuses* bonuses) const;
+  // The most LeaveBonus(...) any play from rack that doesn't go out could
+  // get, so playouts only need the bonuses of plays that might beat the best
+  // one found so far. rack must be a sub-rack of one of those in
+  // sub_rack_bonuses_.
+  float MaxLeaveBonus(const PlayoutRack& rack) const;
   float StaticEndgameEquity(const GamePosition& position,
                             const Move& move) const;
+  // root_off_moves are the moves of pos's opponent at the root, and
+  // root_crosses the crosses and scores of its board. search_thread's
+  // MoveFinder is left with those of the board after move.
   float EvaluateAllResponses(GamePosition pos, float equity_to_beat,
-                             const MoveWithDelta& move);
+                             const MoveWithDelta& move,
+                             const std::vector<Move>& root_off_moves,
+                             const CrossesAndScores& root_crosses,
+                             SearchThread* search_thread);
   int CapAtPly(int ply) const {
     if (caps_per_ply_.empty()) {
       return 80000;
@@ -81,11 +164,16 @@ class EndgamePlayer : public ComputerPlayer {
   }
   const Tiles& tiles_;
   const Leaves& leaves_;
-  std::unique_ptr<MoveFinder> move_finder_;
+  // The first also generates the root's moves.
+  std::vector<std::unique_ptr<SearchThread>> search_threads_;
   int num_plies_;
   float leave_score_weight_;
   float leave_value_weight_;
   std::vector<int> caps_per_ply_;
+  // For the rack and the unseen tiles of the position passed to
+  // ChooseBestMove(...). Every rack in a playout is a sub-rack of one of
+  // them.
+  std::array<SubRackBonuses, 2> sub_rack_bonuses_;
 };
 
 #endif  // SRC_SCRABBLE_ENDGAME_PLAYER_H
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include <algorithm>
+
+#include <google/protobuf/text_format.h>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/flags/usage.h"
+#include "absl/memory/memory.h"
+#include "absl/time/clock.h"
+#include "glog/logging.h"
+#include "src/scrabble/data_manager.h"
+#include "src/scrabble/endgame_move_pool.h"
+#include "src/scrabble/endgame_player.h"
+#include "src/scrabble/game_position.h"
+#include "src/scrabble/move_finder.h"
+
+ABSL_FLAG(int, num_iterations, 100, "Number of times to choose a move");
+ABSL_FLAG(int, num_repeats, 5,
+          "Number of times to time num_iterations, keeping the fastest");
+ABSL_FLAG(int, search_threads, 1, "EndgamePlayer search_threads");
+
+using ::google::protobuf::Arena;
+
+// Times EndgamePlayer's greedy pass (plies: 0, so no replies are searched):
+// every candidate move for the player to move is played out greedily to the
+// end of the game. Move generation and the EndgameMovePool for the position
+// are timed on their own, so the difference is the cost of the playouts.
+// The two are timed in turn num_repeats times, and the fastest of each kept,
+// so that noise from other work on the machine mostly drops out.
+int main(int argc, char* argv[]) {
+  absl::ParseCommandLine(argc, argv);
+
+  DataManager* dm = DataManager::GetInstance();
+  Arena arena;
+  auto spec = Arena::CreateMessage<q2::proto::DataCollection>(&arena);
+  google::protobuf::TextFormat::ParseFromString(R"(
+      tiles_files: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+      board_files: "src/scrabble/testdata/scrabble_board.textproto"
+      anagram_map_file_specs {
+          anagram_map_filename: "src/scrabble/testdata/csw21.qam"
+          tiles_filename: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+      }
+      leaves_file_specs {
+          leaves_filename: "src/scrabble/testdata/csw_scrabble_macondo.qlv"
+          tiles_filename: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+      }
+    )",
+                                                spec);
+  dm->LoadData(*spec);
+
+  auto config = Arena::CreateMessage<q2::proto::EndgamePlayerConfig>(&arena);
+  google::protobuf::TextFormat::ParseFromString(R"(
+        id: 1
+        name: "Endgame"
+        nickname: "E"
+        anagram_map_file: "src/scrabble/testdata/csw21.qam"
+        board_layout_file: "src/scrabble/testdata/scrabble_board.textproto"
+        tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+        leaves_file: "src/scrabble/testdata/csw_scrabble_macondo.qlv"
+        plies: 0
+        leave_score_weight: 1.7
+        leave_value_weight: 0.3
+        )",
+                                                config);
+  config->set_search_threads(absl::GetFlag(FLAGS_search_threads));
+  auto player = absl::make_unique<EndgamePlayer>(*config);
+
+  const Tiles* tiles =
+      dm->GetTiles("src/scrabble/testdata/english_scrabble_tiles.textproto");
+  const BoardLayout* layout =
+      dm->GetBoardLayout("src/scrabble/testdata/scrabble_board.textproto");
+  Board board;
+  board.SetLetters(
+      {R"(   A B C D E F G H I J K L M N O   )",
+       R"(   ------------------------------  )",
+       R"( 1|P     '       F E R N L E s S|  )",
+       R"( 2|A -       B O U N "       -  |  )",
+       R"( 3|T W O C K E R S '   J   -    |  )",
+       R"( 4|I     O E     C     O F     '|  )",
+       R"( 5|O     L A           T O      |  )",
+       R"( 6|  "   L   " Q     P A H   "  |  )",
+       R"( 7|    ' I     A   ' H   N '    |  )",
+       R"( 8|I G A D     T A X I   S O W M|  )",
+       R"( 9|  A Y E     ' T I Z     '    |  )",
+       R"(10|  N E R V U R E   "       "  |  )",
+       R"(11|        - R E s T I V E      |  )",
+       R"(12|B O U T A D E '       -     '|  )",
+       R"(13|E U G E     '   '       -    |  )",
+       R"(14|  -       "       "       -  |  )",
+       R"(15|=     '       =       '     =|  )",
+       R"(   ------------------------------  )"},
+      *tiles);
+  const Rack rack(tiles->ToLetterString("MILDING").value());
+  const GamePosition pos(*layout, board, 1, 2, rack, 395, 448, 0, 0,
+                         absl::Minutes(25), 0, *tiles);
+  const GamePosition off_pos = pos.SwapRacks();
+
+  const int num_iterations = absl::GetFlag(FLAGS_num_iterations);
+  MoveFinder move_finder(*dm->GetAnagramMap("src/scrabble/testdata/csw21.qam"),
+                         *layout, *tiles,
+                         *dm->GetLeaves(
+                             "src/scrabble/testdata/csw_scrabble_macondo.qlv"));
+  int num_candidates = 0;
+  // Warms up caches for both loops below.
+  player->ChooseBestMove(nullptr, pos);
+  absl::Duration move_generation = absl::InfiniteDuration();
+  absl::Duration choose = absl::InfiniteDuration();
+  for (int repeat = 0; repeat < absl::GetFlag(FLAGS_num_repeats); ++repeat) {
+    absl::Time start = absl::Now();
+    for (int i = 0; i < num_iterations; ++i) {
+      move_finder.FindMoves(pos.GetRack(), pos.GetBoard(), pos.NumUnseen(),
+                            MoveFinder::RecordAll, true);
+      const std::vector<Move> on_moves = move_finder.Moves();
+      num_candidates = on_moves.size();
+      move_finder.FindMoves(off_pos.GetRack(), off_pos.GetBoard(),
+                            off_pos.NumUnseen(), MoveFinder::RecordAll, true);
+      const std::vector<Move> off_moves = move_finder.Moves();
+      const EndgameMovePool pool(*tiles, pos.GetBoard(), on_moves, off_moves);
+    }
+    move_generation = std::min(move_generation, absl::Now() - start);
+
+    start = absl::Now();
+    for (int i = 0; i < num_iterations; ++i) {
+      player->ChooseBestMove(nullptr, pos);
+    }
+    choose = std::min(choose, absl::Now() - start);
+  }
+  const absl::Duration playouts = choose - move_generation;
+
+  LOG(INFO) << "candidates: " << num_candidates;
+  LOG(INFO) << "move generation and pool: " << move_generation / num_iterations
+            << " per position";
+  LOG(INFO) << "ChooseBestMove: " << choose / num_iterations
+            << " per position";
+  LOG(INFO) << "greedy playouts: "
+            << playouts / (num_iterations * num_candidates) << " per candidate";
+  return 0;
+}
@@ -117,12 +117,15 @@ void Game::AddNextPosition(const Move& move, absl::Duration time_elapsed) {
       scoreless_turns = positions_.back().ScorelessTurns() + 1;
     }
   }
+  const std::array<int, 32> unseen_counts =
+      positions_.back().NextUnseenCounts(move, racks_.back());
   positions_.emplace_back(layout_, board, positions_.back().OpponentPlayerId(),
                           positions_.back().OnTurnPlayerId(), racks_.back(),
                           positions_.back().OpponentScore(),
                           positions_.back().PlayerScore() + move.Score(),
                           positions_.back().PositionIndex() + 1, game_index_,
-                          time_remaining, scoreless_turns, tiles_);
+                          time_remaining, scoreless_turns, tiles_,
+                          unseen_counts);
   bags_.emplace_back(bag);
   /*
   LOG(INFO) << "Bags:";
@@ -238,30 +241,31 @@ void Game::ContinueWithComputerPlayers(int plies) {
   AdjustGameEndScores();
 }
 
+int Game::FinalScore(const Player& player) const {
+  if (positions_.back().OnTurnPlayerId() == player.Id()) {
+    return positions_.back().PlayerScore();
+  }
+  return positions_.back().OpponentScore();
+}
+
+absl::Duration Game::TimeRemaining(const Player& player) const {
+  absl::Duration remaining_time = initial_time_;
+  for (const auto& position : positions_) {
+    if (position.OnTurnPlayerId() == player.Id()) {
+      remaining_time = position.TimeRemainingStart();
+    }
+  }
+  return remaining_time;
+}
+
 void Game::WriteProto(q2::proto::GameResult* result) const {
   for (const Player* player : players_) {
     result->add_player_ids(player->Id());
-    if (positions_.back().OnTurnPlayerId() == player->Id()) {
-      result->add_player_scores(positions_.back().PlayerScore());
-    } else {
-      result->add_player_scores(positions_.back().OpponentScore());
-    }
-    absl::Duration remaining_time = initial_time_;
-    for (const auto& position : positions_) {
-      if (position.OnTurnPlayerId() == player->Id()) {
-        // std::stringstream ss;
-        // position.Display(ss);
-        // LOG(INFO) << "position: " << std::endl << ss.str();
-        remaining_time = position.TimeRemainingStart();
-      }
-    }
+    result->add_player_scores(FinalScore(*player));
+    const absl::Duration remaining_time = TimeRemaining(*player);
     result->add_micros_remaining(absl::ToInt64Microseconds(remaining_time));
     result->add_micros_used(
         absl::ToInt64Microseconds(initial_time_ - remaining_time));
-    // LOG(INFO) << "initial_time_: " << initial_time_;
-    // LOG(INFO) << "used: "
-    //           << absl::ToInt64Microseconds(initial_time_ - remaining_time)
-    //           << " remaining: " << absl::ToInt64Microseconds(remaining_time);
   }
   for (const auto& rack : racks_) {
     result->add_racks(tiles_.ToString(rack.Letters()).value());
@@ -272,4 +276,87 @@ void Game::WriteProto(q2::proto::GameResult* result) const {
   for (const auto& position : positions_) {
     position.WriteProto(result->add_game_positions());
   }
-}
\ No newline at end of file
+}
+
+namespace {
+q2::proto::Move::Action ProtoAction(const Move& move) {
+  switch (move.GetAction()) {
+    case Move::Place:
+      return q2::proto::Move::PLACE;
+    case Move::Exchange:
+      return move.Letters().empty() ? q2::proto::Move::PASS
+                                    : q2::proto::Move::EXCHANGE;
+    case Move::OppDeadwoodBonus:
+      return q2::proto::Move::OPP_DEADWOOD_BONUS;
+    case Move::OwnDeadwoodPenalty:
+      return q2::proto::Move::OWN_DEADWOOD_PENALTY;
+  }
+  return q2::proto::Move::PASS;
+}
+}  // namespace
+
+void Game::WriteRecord(const q2::proto::OutputSpec& output_spec,
+                       q2::proto::GameRecord* record) const {
+  record->set_game_index(game_index_);
+  for (const Player* player : players_) {
+    record->add_player_ids(player->Id());
+    record->add_player_scores(FinalScore(*player));
+    const absl::Duration remaining_time = TimeRemaining(*player);
+    record->add_micros_remaining(absl::ToInt64Microseconds(remaining_time));
+    record->add_micros_used(
+        absl::ToInt64Microseconds(initial_time_ - remaining_time));
+  }
+  if (output_spec.record_bags()) {
+    const auto& letters = pregame_bag_.Letters();
+    record->set_pregame_bag(std::string(letters.begin(), letters.end()));
+    for (std::size_t i = 0; i < exchange_dividend_index_; ++i) {
+      record->add_exchange_insertion_dividends(
+          exchange_insertion_dividends_[i]);
+    }
+  }
+  if (output_spec.record_racks()) {
+    for (const auto& rack : racks_) {
+      const LetterString& letters = rack.Letters();
+      record->add_racks(std::string(letters.begin(), letters.end()));
+    }
+  }
+  if (output_spec.record_game_positions()) {
+    for (const auto& position : positions_) {
+      if (!position.GetMove().has_value()) {
+        continue;
+      }
+      const Move& move = position.GetMove().value();
+      auto* compact = record->add_moves();
+      compact->set_action(ProtoAction(move));
+      if (move.GetAction() == Move::Place) {
+        compact->set_start_square(15 * move.StartRow() + move.StartCol());
+        compact->set_down(move.Direction() == Move::Down);
+      }
+      compact->set_letters(
+          std::string(move.Letters().begin(), move.Letters().end()));
+      compact->set_score(move.Score());
+    }
+  }
+  for (int i = 0; i < positions_.size(); ++i) {
+    const GamePosition& position = positions_[i];
+    if (!position.GetMove().has_value()) {
+      continue;
+    }
+    // Leaves out what AdjustGameEndScores() adds: deadwood moves, and the
+    // pass before an OppDeadwoodBonus.
+    const Move::Action action = position.GetMove()->GetAction();
+    if (action == Move::OwnDeadwoodPenalty ||
+        action == Move::OppDeadwoodBonus) {
+      continue;
+    }
+    if (i + 1 < positions_.size() && positions_[i + 1].GetMove().has_value() &&
+        positions_[i + 1].GetMove()->GetAction() == Move::OppDeadwoodBonus) {
+      continue;
+    }
+    auto* timing = record->add_move_timings();
+    timing->set_player_id(position.OnTurnPlayerId());
+    timing->set_num_unseen(position.NumUnseen());
+    timing->set_micros(absl::ToInt64Microseconds(
+        position.TimeRemainingStart() - position.TimeRemainingEnd()));
+  }
+}
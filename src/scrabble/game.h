@@ -96,8 +96,15 @@ class Game {
   const std::vector<GamePosition>& Positions() const { return positions_; }
 
   void WriteProto(q2::proto::GameResult* result) const;
+  // Writes scores and times, and whatever output_spec asks to record.
+  void WriteRecord(const q2::proto::OutputSpec& output_spec,
+                   q2::proto::GameRecord* record) const;
 
  private:
+  int FinalScore(const Player& player) const;
+  // Clock time player had left at the start of their last turn.
+  absl::Duration TimeRemaining(const Player& player) const;
+
   const BoardLayout& layout_;
 
   // In turn order.
@@ -1,5 +1,108 @@
 #include "src/scrabble/game_position.h"
 
+std::array<int, 32> GamePosition::CountUnseen(const Board& board,
+                                              const Rack& rack,
+                                              const Tiles& tiles) {
+  std::array<int, 32> counts = {0};
+  for (Letter letter = tiles.FirstLetter(); letter <= tiles.BlankIndex();
+       ++letter) {
+    counts[letter] = tiles.Count(letter);
+  }
+  for (int row = 0; row < 15; ++row) {
+    for (int col = 0; col < 15; ++col) {
+      if (Letter letter = board.At(row, col)) {
+        if (letter >= tiles.BlankIndex()) {
+          letter = tiles.BlankIndex();
+        }
+        counts[letter]--;
+      }
+    }
+  }
+  for (const Letter letter : rack.Letters()) {
+    counts[letter]--;
+  }
+  return counts;
+}
+
+int GamePosition::SumCounts(const std::array<int, 32>& counts) {
+  int sum = 0;
+  for (const int count : counts) {
+    sum += count;
+  }
+  return sum;
+}
+
+void GamePosition::AdjustUnseen(const LetterString& letters, int delta) {
+  for (Letter letter : letters) {
+    if (letter == 0) {
+      continue;
+    }
+    if (letter >= tiles_.BlankIndex()) {
+      letter = tiles_.BlankIndex();
+    }
+    unseen_counts_[letter] += delta;
+    num_unseen_ += delta;
+  }
+}
+
+Bag GamePosition::GetUnseenToPlayer() const {
+  std::vector<Letter> letters;
+  letters.reserve(num_unseen_);
+  for (Letter letter = tiles_.FirstLetter(); letter <= tiles_.BlankIndex();
+       ++letter) {
+    CHECK_GE(unseen_counts_[letter], 0)
+        << "negative count of letter: "
+        << tiles_.NumberToChar(letter).value();
+    letters.insert(letters.end(), unseen_counts_[letter], letter);
+  }
+  return Bag(tiles_, letters);
+}
+
+std::array<int, 32> GamePosition::NextUnseenCounts(
+    const Move& move, const Rack& next_rack) const {
+  std::array<int, 32> counts = unseen_counts_;
+  for (const Letter letter : rack_.Letters()) {
+    counts[letter]++;
+  }
+  if (move.GetAction() == Move::Place) {
+    for (Letter letter : move.Letters()) {
+      if (letter == 0) {
+        continue;
+      }
+      if (letter >= tiles_.BlankIndex()) {
+        letter = tiles_.BlankIndex();
+      }
+      counts[letter]--;
+    }
+  }
+  for (const Letter letter : next_rack.Letters()) {
+    counts[letter]--;
+  }
+  return counts;
+}
+
+std::vector<Letter> GamePosition::SeenByPlayer() const {
+  std::vector<Letter> seen;
+  for (Letter letter = tiles_.FirstLetter(); letter <= tiles_.BlankIndex();
+       ++letter) {
+    seen.insert(seen.end(), tiles_.Count(letter) - unseen_counts_[letter],
+                letter);
+  }
+  return seen;
+}
+
+void GamePosition::SetBoard(const Board& board) {
+  board_ = board;
+  unseen_counts_ = CountUnseen(board_, rack_, tiles_);
+  num_unseen_ = SumCounts(unseen_counts_);
+}
+
+void GamePosition::SwapWithKnownOppRack() {
+  AdjustUnseen(rack_.Letters(), 1);
+  AdjustUnseen(known_opp_rack_.Letters(), -1);
+  std::swap(rack_, known_opp_rack_);
+}
+
 void GamePosition::Display(std::ostream& os) const {
   const Bag bag(tiles_);
   Display(os, bag);
@@ -87,14 +190,21 @@ void GamePosition::WriteProto(q2::proto::GamePosition* proto) const {
 
 GamePosition GamePosition::SwapRacks() const {
   LOG(INFO) << "GamePosition::SwapRacks()";
-  const auto unseen = GetUnseenToPlayer();
-  CHECK_LE(unseen.Size(), 7);
+  CHECK_LE(num_unseen_, 7);
   LetterString rack;
-  for (const auto& letter : unseen.Letters()) {
-    rack.push_back(letter);
+  for (Letter letter = tiles_.FirstLetter(); letter <= tiles_.BlankIndex();
+       ++letter) {
+    for (int i = 0; i < unseen_counts_[letter]; ++i) {
+      rack.push_back(letter);
+    }
+  }
+  // What the opponent can't see is our rack.
+  std::array<int, 32> opp_unseen_counts = {0};
+  for (const Letter letter : rack_.Letters()) {
+    opp_unseen_counts[letter]++;
   }
   return GamePosition(layout_, board_, opponent_player_id_, on_turn_player_id_,
                       rack, opponent_score_, player_score_, position_index_,
                       game_index_, time_remaining_start_, scoreless_turns_,
-                      tiles_);
+                      tiles_, opp_unseen_counts);
 }
\ No newline at end of file
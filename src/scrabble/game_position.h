@@ -1,6 +1,8 @@
 #ifndef SRC_SCRABBLE_GAME_POSITION_H
 #define SRC_SCRABBLE_GAME_POSITION_H
 
+#include <array>
+
 #include "absl/time/time.h"
 #include "src/scrabble/bag.h"
 #include "src/scrabble/board.h"
@@ -27,7 +29,33 @@ class GamePosition {
         game_index_(game_index),
         time_remaining_start_(time_remaining_start),
         scoreless_turns_(scoreless_turns),
-        tiles_(tiles) {}
+        tiles_(tiles),
+        unseen_counts_(CountUnseen(board, rack, tiles)),
+        num_unseen_(SumCounts(unseen_counts_)) {}
+
+  // As above, but with the unseen counts already known (see
+  // Game::AddNextPosition), so the board is not scanned.
+  GamePosition(const BoardLayout& layout, const Board& board,
+               int on_turn_player_id, int opponent_player_id, const Rack& rack,
+               int player_score, int opponent_score, int position_index,
+               int game_index, absl::Duration time_remaining_start,
+               int scoreless_turns, const Tiles& tiles,
+               const std::array<int, 32>& unseen_counts)
+      : layout_(layout),
+        board_(board),
+        on_turn_player_id_(on_turn_player_id),
+        opponent_player_id_(opponent_player_id),
+        rack_(rack),
+        known_opp_rack_(Rack(LetterString())),
+        player_score_(player_score),
+        opponent_score_(opponent_score),
+        position_index_(position_index),
+        game_index_(game_index),
+        time_remaining_start_(time_remaining_start),
+        scoreless_turns_(scoreless_turns),
+        tiles_(tiles),
+        unseen_counts_(unseen_counts),
+        num_unseen_(SumCounts(unseen_counts_)) {}
 
   void CommitMove(const Move& move, const absl::Duration elapsed) {
     move_ = move;
@@ -39,30 +67,21 @@ class GamePosition {
   void Display(std::ostream& os, const Bag& initial_bag) const;
   const Board& GetBoard() const { return board_; }
   const Rack& GetRack() const { return rack_; }
-  Bag GetUnseenToPlayer() const {
-    Bag bag(tiles_);
-    return bag.UnseenToPlayer(board_, rack_);
-  }
+  // Tiles not on the board or the on-turn player's rack, by letter (blanks
+  // counted at tiles.BlankIndex()). Kept up to date as the board and racks
+  // change, so reading these never scans the board.
+  const std::array<int, 32>& UnseenCounts() const { return unseen_counts_; }
+  int NumUnseen() const { return num_unseen_; }
+  Bag GetUnseenToPlayer() const;
+  // Unseen counts for the opponent after move is played from this position
+  // and they are on turn holding next_rack: these, plus rack_, less the
+  // tiles placed and next_rack. Draws from the bag cancel out.
+  std::array<int, 32> NextUnseenCounts(const Move& move,
+                                       const Rack& next_rack) const;
   Bag GetUnseenToPlayer(const Bag& bag) const {
     return bag.UnseenToPlayer(board_, rack_);
   }
-  std::vector<Letter> SeenByPlayer() const {
-    std::vector<Letter> seen;
-    for (Letter letter : rack_.Letters()) {
-      seen.push_back(letter);
-    }
-    for (int row = 0; row < 15; ++row) {
-      for (int col = 0; col < 15; ++col) {
-        if (Letter letter = board_.At(row, col)) {
-          if (letter >= tiles_.BlankIndex()) {
-            letter = tiles_.BlankIndex();
-          }
-          seen.push_back(letter);
-        }
-      }
-    }
-    return seen;
-  }
+  std::vector<Letter> SeenByPlayer() const;
 
   const absl::optional<Move>& GetMove() const { return move_; }
   bool IsScorelessTurn() const;
@@ -81,15 +100,15 @@ class GamePosition {
     if (scoreless_turns_ >= 6) {
       return true;
     }
-    if (GetUnseenToPlayer().Size() == 0) {
+    if (num_unseen_ == 0) {
       return true;
     }
     return false;
   }
   void WriteProto(q2::proto::GamePosition* proto) const;
   GamePosition SwapRacks() const;
-  void SetBoard(const Board& board) { board_ = board; }
-  void SwapWithKnownOppRack() { std::swap(rack_, known_opp_rack_); }
+  void SetBoard(const Board& board);
+  void SwapWithKnownOppRack();
   const Rack& GetKnownOppRack() const { return known_opp_rack_; }
   void SetKnownOppRack(const Bag& bag) {
     known_opp_rack_.Clear();
@@ -98,13 +117,32 @@ class GamePosition {
     }
   }
   void SetKnownOppRack(const Rack& rack) { known_opp_rack_ = rack.Letters(); }
-  void UnsafePlaceMove(const Move& move) { board_.UnsafePlaceMove(move); }
-  void UnsafeUndoMove(const Move& move) { board_.UnsafeUndoMove(move); }
+  void UnsafePlaceMove(const Move& move) {
+    board_.UnsafePlaceMove(move);
+    if (move.GetAction() == Move::Place) {
+      AdjustUnseen(move.Letters(), -1);
+    }
+  }
+  void UnsafeUndoMove(const Move& move) {
+    board_.UnsafeUndoMove(move);
+    if (move.GetAction() == Move::Place) {
+      AdjustUnseen(move.Letters(), 1);
+    }
+  }
   void RemoveRackTiles(const Move& move) {
     rack_.RemoveTiles(move.Letters(), tiles_);
+    AdjustUnseen(move.Letters(), 1);
   }
 
  private:
+  static std::array<int, 32> CountUnseen(const Board& board, const Rack& rack,
+                                         const Tiles& tiles);
+  static int SumCounts(const std::array<int, 32>& counts);
+
+  // Adds delta to the unseen count of each tile in letters, skipping
+  // playthrough squares.
+  void AdjustUnseen(const LetterString& letters, int delta);
+
   const BoardLayout& layout_;
   Board board_;
   int on_turn_player_id_;
@@ -139,6 +177,12 @@ class GamePosition {
   const int scoreless_turns_;
 
   const Tiles& tiles_;
+
+  // Unseen to the on-turn player: the full distribution less the board and
+  // rack_. Between UnsafePlaceMove(...) and RemoveRackTiles(...) a tile is
+  // on both, so its count can briefly go negative.
+  std::array<int, 32> unseen_counts_;
+  int num_unseen_;
 };
 
 #endif  // SRC_SCRABBLE_GAME_POSITION_H
\ No newline at end of file
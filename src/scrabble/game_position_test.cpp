@@ -166,4 +166,33 @@ TEST_F(GamePositionTest, NotScorelessTurn) {
   pos->Display(ss);
   LOG(INFO) << std::endl << ss.str();
   EXPECT_FALSE(pos->IsScorelessTurn());
-}
\ No newline at end of file
+}
+
+TEST_F(GamePositionTest, UnseenCounts) {
+  Board board;
+  Rack rack(tiles_->ToLetterString("OLAUGHS").value());
+  GamePosition pos(*layout_, board, 1, 2, rack, 0, 0, 0, 0, absl::Minutes(25),
+                   0, *tiles_);
+  EXPECT_EQ(pos.NumUnseen(), 93);
+  EXPECT_EQ(pos.UnseenCounts()[tiles_->CharToNumber('A').value()], 8);
+  EXPECT_EQ(pos.UnseenCounts()[tiles_->BlankIndex()], 2);
+
+  // Placing and removing the tiles leaves unseen unchanged; swapping in a
+  // known opponent rack adds back what's left on ours.
+  const auto goulash = Move::Parse("8F GOULASH", *tiles_);
+  pos.SetKnownOppRack(Rack(tiles_->ToLetterString("XYZ").value()));
+  pos.UnsafePlaceMove(goulash.value());
+  pos.RemoveRackTiles(goulash.value());
+  EXPECT_EQ(pos.NumUnseen(), 93);
+  pos.SwapWithKnownOppRack();
+  EXPECT_EQ(pos.NumUnseen(), 90);
+  EXPECT_EQ(pos.GetUnseenToPlayer().Size(), 90);
+  pos.SwapWithKnownOppRack();
+  pos.UnsafeUndoMove(goulash.value());
+  EXPECT_EQ(pos.NumUnseen(), 100);
+
+  // Matches a fresh scan of the board and rack.
+  const Bag expected = Bag(*tiles_).UnseenToPlayer(pos.GetBoard(),
+                                                   pos.GetRack());
+  EXPECT_EQ(pos.GetUnseenToPlayer().Letters(), expected.Letters());
+}
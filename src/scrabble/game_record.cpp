@@ -0,0 +1,81 @@
+#include "src/scrabble/game_record.h"
+
+#include "absl/memory/memory.h"
+#include "glog/logging.h"
+#include "google/protobuf/util/delimited_message_util.h"
+
+std::unique_ptr<GameRecordWriter> GameRecordWriter::Create(
+    const std::string& filename) {
+  std::unique_ptr<GameRecordWriter> writer(new GameRecordWriter(filename));
+  if (!writer->file_.is_open()) {
+    LOG(ERROR) << "Could not open file " << filename;
+    return nullptr;
+  }
+  return writer;
+}
+
+absl::Status GameRecordWriter::Write(const q2::proto::GameRecord& record) {
+  if (!google::protobuf::util::SerializeDelimitedToOstream(record, &file_)) {
+    return absl::InternalError("Could not write to file " + filename_);
+  }
+  // Flushed game by game, so a tournament cut short keeps what it played.
+  file_.flush();
+  if (!file_.good()) {
+    return absl::InternalError("Could not write to file " + filename_);
+  }
+  return absl::OkStatus();
+}
+
+std::unique_ptr<GameRecordReader> GameRecordReader::Create(
+    const std::string& filename) {
+  std::unique_ptr<GameRecordReader> reader(new GameRecordReader(filename));
+  if (!reader->file_.is_open()) {
+    LOG(ERROR) << "Could not open file " << filename;
+    return nullptr;
+  }
+  reader->input_ =
+      absl::make_unique<google::protobuf::io::IstreamInputStream>(
+          &reader->file_);
+  return reader;
+}
+
+bool GameRecordReader::Next(q2::proto::GameRecord* record) {
+  // Parsing merges into record rather than replacing it.
+  record->Clear();
+  bool clean_eof = false;
+  if (!google::protobuf::util::ParseDelimitedFromZeroCopyStream(
+          record, input_.get(), &clean_eof)) {
+    if (!clean_eof) {
+      LOG(ERROR) << "Could not parse game record";
+    }
+    return false;
+  }
+  return true;
+}
+
+Move GameRecordReader::ToMove(const q2::proto::CompactMove& compact) {
+  const LetterString letters(compact.letters().data(),
+                             compact.letters().size());
+  switch (compact.action()) {
+    case q2::proto::Move::PLACE:
+      return Move(compact.down() ? Move::Down : Move::Across,
+                  compact.start_square() / 15, compact.start_square() % 15,
+                  letters, compact.score());
+    case q2::proto::Move::OPP_DEADWOOD_BONUS:
+      return Move(Move::OppDeadwoodBonus, letters, compact.score());
+    case q2::proto::Move::OWN_DEADWOOD_PENALTY:
+      return Move(Move::OwnDeadwoodPenalty, letters, compact.score());
+    default:
+      return Move(letters);
+  }
+}
+
+Board GameRecordReader::BoardAfter(const q2::proto::GameRecord& record,
+                                   int num_moves) {
+  CHECK_LE(num_moves, record.moves_size());
+  Board board;
+  for (int i = 0; i < num_moves; ++i) {
+    board.UnsafePlaceMove(ToMove(record.moves(i)));
+  }
+  return board;
+}
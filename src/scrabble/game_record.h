@@ -0,0 +1,56 @@
+#ifndef SRC_SCRABBLE_GAME_RECORD_H
+#define SRC_SCRABBLE_GAME_RECORD_H
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "src/scrabble/board.h"
+#include "src/scrabble/computer_players.pb.h"
+#include "src/scrabble/move.h"
+
+// Appends GameRecords to a file as length-delimited protos, one game at a
+// time, so nothing accumulates in memory however many games are played.
+class GameRecordWriter {
+ public:
+  // Returns nullptr if filename can't be opened for appending.
+  static std::unique_ptr<GameRecordWriter> Create(const std::string& filename);
+
+  absl::Status Write(const q2::proto::GameRecord& record);
+
+ private:
+  explicit GameRecordWriter(const std::string& filename)
+      : filename_(filename),
+        file_(filename, std::ios::out | std::ios::app | std::ios::binary) {}
+
+  const std::string filename_;
+  std::ofstream file_;
+};
+
+// Reads back the records a GameRecordWriter wrote, in order.
+class GameRecordReader {
+ public:
+  // Returns nullptr if filename can't be opened.
+  static std::unique_ptr<GameRecordReader> Create(const std::string& filename);
+
+  // Reads the next record into record. Returns false at the end of the
+  // file, or if the rest of it can't be parsed.
+  bool Next(q2::proto::GameRecord* record);
+
+  static Move ToMove(const q2::proto::CompactMove& compact);
+
+  // The board after the first num_moves of record's moves, which must have
+  // been written with OutputSpec.record_game_positions.
+  static Board BoardAfter(const q2::proto::GameRecord& record, int num_moves);
+
+ private:
+  explicit GameRecordReader(const std::string& filename)
+      : file_(filename, std::ios::in | std::ios::binary) {}
+
+  std::ifstream file_;
+  std::unique_ptr<google::protobuf::io::IstreamInputStream> input_;
+};
+
+#endif  // SRC_SCRABBLE_GAME_RECORD_H
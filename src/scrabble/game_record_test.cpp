@@ -0,0 +1,107 @@
+#include "src/scrabble/game_record.h"
+
+#include <cstdio>
+
+#include "absl/memory/memory.h"
+#include "absl/random/random.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/anagram/anagram_map.h"
+#include "src/leaves/leaves.h"
+#include "src/scrabble/board_layout.h"
+#include "src/scrabble/game.h"
+#include "src/scrabble/static_player.h"
+#include "src/scrabble/tiles.h"
+
+std::unique_ptr<Tiles> tiles_;
+std::unique_ptr<Leaves> leaves_;
+std::unique_ptr<AnagramMap> anagram_map_;
+std::unique_ptr<BoardLayout> layout_;
+
+class GameRecordTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    tiles_ = absl::make_unique<Tiles>(
+        "src/scrabble/testdata/english_scrabble_tiles.textproto");
+    anagram_map_ = AnagramMap::CreateFromBinaryFile(
+        *tiles_, "src/scrabble/testdata/csw21.qam");
+    layout_ = absl::make_unique<BoardLayout>(
+        "src/scrabble/testdata/scrabble_board.textproto");
+    leaves_ = Leaves::CreateFromBinaryFile(
+        *tiles_, "src/scrabble/testdata/csw_scrabble_macondo.qlv");
+  }
+};
+
+TEST_F(GameRecordTest, WriteAndReplay) {
+  StaticPlayer a(1, *anagram_map_, *layout_, *tiles_, *leaves_);
+  StaticPlayer b(2, *anagram_map_, *layout_, *tiles_, *leaves_);
+  const std::vector<Player*> players = {&a, &b};
+  absl::BitGen gen;
+  const std::string filename = ::testing::TempDir() + "/game_records";
+  std::remove(filename.c_str());
+  auto writer = GameRecordWriter::Create(filename);
+  ASSERT_NE(writer, nullptr);
+
+  q2::proto::OutputSpec everything;
+  everything.set_record_bags(true);
+  everything.set_record_racks(true);
+  everything.set_record_game_positions(true);
+  const q2::proto::OutputSpec scores_only;
+  std::vector<std::unique_ptr<Game>> games;
+  for (int i = 0; i < 2; ++i) {
+    Bag bag(*tiles_);
+    bag.Shuffle(gen);
+    std::vector<uint16_t> dividends;
+    for (int j = 0; j < 1000; ++j) {
+      dividends.push_back(absl::Uniform<uint16_t>(gen, 0, 65535));
+    }
+    games.push_back(absl::make_unique<Game>(*layout_, players, *tiles_,
+                                            absl::Minutes(25), i));
+    games.back()->CreateInitialPosition(bag, dividends);
+    games.back()->FinishWithComputerPlayers();
+    q2::proto::GameRecord record;
+    games.back()->WriteRecord((i == 0) ? everything : scores_only, &record);
+    ASSERT_TRUE(writer->Write(record).ok());
+  }
+  writer.reset();
+
+  auto reader = GameRecordReader::Create(filename);
+  ASSERT_NE(reader, nullptr);
+  q2::proto::GameRecord record;
+  ASSERT_TRUE(reader->Next(&record));
+  const Game& game = *games[0];
+  EXPECT_EQ(record.game_index(), 0);
+  const GamePosition& last = game.Positions().back();
+  const bool first_on_turn = last.OnTurnPlayerId() == 1;
+  EXPECT_EQ(record.player_scores(0),
+            first_on_turn ? last.PlayerScore() : last.OpponentScore());
+  EXPECT_EQ(record.player_scores(1),
+            first_on_turn ? last.OpponentScore() : last.PlayerScore());
+  EXPECT_EQ(record.pregame_bag().size(), 100);
+  ASSERT_GE(record.racks_size(), 2);
+  EXPECT_EQ(record.racks(0).size(), 7);
+  const auto& positions = game.Positions();
+  ASSERT_GE(record.moves_size(), positions.size() - 1);
+  for (int i = 0; i < positions.size(); ++i) {
+    const Board board = GameRecordReader::BoardAfter(record, i);
+    for (int row = 0; row < 15; ++row) {
+      for (int col = 0; col < 15; ++col) {
+        ASSERT_EQ(board.At(row, col), positions[i].GetBoard().At(row, col))
+            << "position " << i << " row " << row << " col " << col;
+      }
+    }
+    if (i < record.moves_size() && positions[i].GetMove().has_value()) {
+      EXPECT_EQ(GameRecordReader::ToMove(record.moves(i)).Score(),
+                positions[i].GetMove()->Score());
+    }
+  }
+
+  ASSERT_TRUE(reader->Next(&record));
+  EXPECT_EQ(record.game_index(), 1);
+  EXPECT_EQ(record.player_scores_size(), 2);
+  EXPECT_TRUE(record.pregame_bag().empty());
+  EXPECT_EQ(record.racks_size(), 0);
+  EXPECT_EQ(record.moves_size(), 0);
+  EXPECT_FALSE(reader->Next(&record));
+}
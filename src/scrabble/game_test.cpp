@@ -273,6 +273,22 @@ TEST_F(GameTest, StaticPlayerPlays) {
   }
 }
 
+TEST_F(GameTest, UnseenCountsMatchBoardScan) {
+  StaticPlayer a(1, *anagram_map_, *layout_, *tiles_, *leaves_);
+  StaticPlayer b(2, *anagram_map_, *layout_, *tiles_, *leaves_);
+  std::vector<Player*> players = {&a, &b};
+  Game game(*layout_, players, *tiles_, absl::Minutes(25), 0);
+  game.CreateInitialPosition();
+  game.FinishWithComputerPlayers();
+  const Bag full_bag(*tiles_);
+  for (const auto& position : game.Positions()) {
+    const Bag expected =
+        full_bag.UnseenToPlayer(position.GetBoard(), position.GetRack());
+    EXPECT_EQ(position.NumUnseen(), expected.Size());
+    EXPECT_EQ(position.GetUnseenToPlayer().Letters(), expected.Letters());
+  }
+}
+
 TEST_F(GameTest, FinishSimmedGame) {
   Board board;
   Rack rack(tiles_->ToLetterString("QUACKUM").value());
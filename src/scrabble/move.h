@@ -153,6 +153,7 @@ class Move {
   }
 
   void SetEquity(float equity) { equity_ = equity; }
+  bool HasEquity() const { return equity_.has_value(); }
 
   double Equity() const {
     CHECK(equity_.has_value()) << " GetAction(): " << GetAction() << " Score: " << Score();
@@ -1,12 +1,19 @@
 #include "src/scrabble/move_finder.h"
 
+#include <algorithm>
+#include <atomic>
+#include <bitset>
 #include <queue>
 #include <range/v3/all.hpp>
+#include <thread>
 
 #include "absl/numeric/bits.h"
 #include "absl/strings/str_join.h"
 #include "glog/logging.h"
 
+constexpr int MoveFinder::kMaxAffectedSquares;
+constexpr int MoveFinder::kNoLimit;
+
 void MoveFinder::CacheSubsets(const Rack& rack) {
   subsets_ = rack.Subsets(tiles_);
 }
@@ -24,7 +31,7 @@ std::vector<Move> MoveFinder::FindExchanges(
       move.SetLeave(rp.LeftLetters());
       move.SetLeaveValue(rp.LeaveValue());
       move.SetEquity(rp.LeaveValue());
-      if (record_mode == RecordAll) {
+      if (record_mode != RecordBest) {
         moves.push_back(move);
       } else {
         if (moves.size() == 0) {
@@ -276,6 +283,30 @@ int MoveFinder::ThroughScore(const Board& board, Move::Dir direction,
   return ret;
 }
 
+int MoveFinder::NumThroughTiles(const Board& board, Move::Dir direction,
+                                int start_row, int start_col,
+                                int num_tiles) const {
+  int ret = 0;
+  int row = start_row;
+  int col = start_col;
+  int num_rack_tiles = 0;
+  const int row_increment = direction == Move::Across ? 0 : 1;
+  const int col_increment = direction == Move::Across ? 1 : 0;
+  while (row < 15 && col < 15) {
+    if (board.At(row, col)) {
+      ret++;
+    } else {
+      if (num_rack_tiles == num_tiles) {
+        return ret;
+      }
+      num_rack_tiles++;
+    }
+    row += row_increment;
+    col += col_increment;
+  }
+  return ret;
+}
+
 int MoveFinder::WordScore(const Board& board, const Move& move,
                           int word_multiplier) {
   int word = 0;
@@ -308,13 +339,30 @@ void MoveFinder::CacheRackPartitions(const Rack& rack) {
   // LOG(INFO) << "CacheRackPartitions(...)";
   const int rack_blanks = rack.NumBlanks(tiles_);
   const auto rack_counts = rack.Counts();
+  if (rack_table_ != nullptr) {
+    rack_word_sizes_ = rack_table_->WordSizes(rack.Letters());
+  }
   for (int i = 0; i <= 7; i++) {
     rack_partitions_[i].clear();
     best_leave_at_size_[i] = -999999;
     rack_word_of_length_[i] = false;
   }
+  // Hash map iteration order depends on where the map was allocated, so walk
+  // the subsets in a fixed order. Moves of equal equity are then found, and
+  // ties broken, the same way for the same rack whatever this MoveFinder did
+  // before, which keeps rollouts on different threads reproducible.
+  ordered_subsets_.clear();
+  for (const auto& subset : subsets_) {
+    ordered_subsets_.push_back(&subset);
+  }
+  std::sort(ordered_subsets_.begin(), ordered_subsets_.end(),
+            [](const std::pair<const uint64_t, LetterString>* a,
+               const std::pair<const uint64_t, LetterString>* b) {
+              return a->first < b->first;
+            });
   for (int blanks = 0; blanks <= rack_blanks; ++blanks) {
-    for (const auto& subset : subsets_) {
+    for (const auto* subset_ptr : ordered_subsets_) {
+      const auto& subset = *subset_ptr;
       AnagramMapIterator word_iterator;
       const uint64_t used_product = static_cast<uint64_t>(subset.first);
       LetterString used_letters = subset.second;
@@ -344,21 +392,23 @@ void MoveFinder::CacheRackPartitions(const Rack& rack) {
           leave_counts[letter]--;
         }
       }
-      uint64_t leave_product = 1;
       LetterString leave;
       for (Letter letter = tiles_.FirstLetter(); letter <= tiles_.BlankIndex();
            ++letter) {
         for (int i = 0; i < leave_counts[letter]; ++i) {
           leave.push_back(letter);
-          leave_product *= tiles_.Prime(letter);
         }
       }
       const int leave_size = leave.size();
       const float leave_value =
-          (leave_size > 6) ? -999999 : leaves_.Value(leave_product);
+          (leave_size > 6) ? -999999 : leaves_.Value(leave);
       rack_partitions_[size].emplace_back(used_product, blanks, used_letters,
                                           leave, leave_value, bits,
                                           word_iterator);
+      if (rack_table_ != nullptr) {
+        rack_partitions_[size].back().SetWordSizes(
+            rack_table_->WordSizes(used_letters));
+      }
       if (leave_value > best_leave_at_size_[leave_size]) {
         best_leave_at_size_[leave_size] = leave_value;
       }
@@ -366,6 +416,42 @@ void MoveFinder::CacheRackPartitions(const Rack& rack) {
   }
 }
 
+namespace {
+// Below this many spots per thread, spawning workers costs more than it saves.
+constexpr int kMinSpotsPerThread = 16;
+
+// Heap ordering for RecordBestK: the lowest equity move sits at the front.
+bool HigherEquity(const Move& a, const Move& b) {
+  return a.Equity() > b.Equity();
+}
+}  // namespace
+
+void MoveFinder::RecordBestKMove(Move&& move, std::vector<Move>* moves) const {
+  if (best_k_ == kNoLimit) {
+    moves->push_back(std::move(move));
+    return;
+  }
+  if (moves->size() < static_cast<size_t>(best_k_)) {
+    moves->push_back(std::move(move));
+    std::push_heap(moves->begin(), moves->end(), HigherEquity);
+    return;
+  }
+  if (move.Equity() < moves->front().Equity() + 1e-5) {
+    return;
+  }
+  std::pop_heap(moves->begin(), moves->end(), HigherEquity);
+  moves->back() = std::move(move);
+  std::push_heap(moves->begin(), moves->end(), HigherEquity);
+}
+
+void MoveFinder::SortBestK() {
+  if (best_k_ == kNoLimit) {
+    std::sort(moves_.begin(), moves_.end(), HigherEquity);
+  } else {
+    std::sort_heap(moves_.begin(), moves_.end(), HigherEquity);
+  }
+}
+
 std::vector<Move> MoveFinder::FindWords(const Rack& rack, const Board& board,
                                         const Spot& spot,
                                         MoveFinder::RecordMode record_mode,
@@ -378,6 +464,15 @@ std::vector<Move> MoveFinder::FindWords(const Rack& rack, const Board& board,
 void MoveFinder::FindWords(const Rack& rack, const Board& board,
                            const Spot& spot, MoveFinder::RecordMode record_mode,
                            float best_equity, std::vector<Move>* moves) {
+  FindWords(rack, board, spot, record_mode, best_equity, moves,
+            &blankified_words_, &playable_bits_);
+}
+
+void MoveFinder::FindWords(const Rack& rack, const Board& board,
+                           const Spot& spot, MoveFinder::RecordMode record_mode,
+                           float best_equity, std::vector<Move>* moves,
+                           std::vector<LetterString>* blankified_words,
+                           uint32_t* playable_bits) {
   const auto direction = spot.Direction();
   const int start_row = spot.StartRow();
   const int start_col = spot.StartCol();
@@ -404,6 +499,11 @@ void MoveFinder::FindWords(const Rack& rack, const Board& board,
       //           << tiles_.ToString(partition.UsedLetters()).value();
       continue;
     }
+    if ((rack_table_ != nullptr) && (through_product != 1) &&
+        (RackTable::MaxTilesPlayed(partition.WordSizes(),
+                                   spot.NumThroughTiles()) < num_tiles)) {
+      continue;
+    }
     // LOG(INFO) << "num_blanks: " << static_cast<int>(num_blanks);
     const absl::uint128 product = partition.UsedProduct();
     const auto& letters = partition.UsedLetters();
@@ -426,6 +526,10 @@ void MoveFinder::FindWords(const Rack& rack, const Board& board,
         // LOG(INFO) << "...skipping partition";
         continue;
       }
+    } else if (record_mode == MoveFinder::RecordBestK) {
+      if (leave_value + spot.MaxScore() < BestKThreshold(*moves) + 1e-5) {
+        continue;
+      }
     }
     partitions_used++;
     /*
@@ -469,6 +573,10 @@ void MoveFinder::FindWords(const Rack& rack, const Board& board,
           move.Equity() < best_equity + 1e-5) {
         continue;
       }
+      if (record_mode == RecordMode::RecordBestK &&
+          move.Equity() < BestKThreshold(*moves) + 1e-5) {
+        continue;
+      }
 
       if (CheckHooks(board, move)) {
         if (num_blanks == 0) {
@@ -490,13 +598,17 @@ void MoveFinder::FindWords(const Rack& rack, const Board& board,
             move.SetCachedNumTiles(num_tiles);
             move.SetNumBlanks(num_blanks);
             move.SetMoveBits(move_bits);
-            playable_bits_ |= move_bits;
-            moves->push_back(std::move(move));
+            *playable_bits |= move_bits;
+            if (record_mode == RecordMode::RecordBestK) {
+              RecordBestKMove(std::move(move), moves);
+            } else {
+              moves->push_back(std::move(move));
+            }
           }
         } else {
-          Blankify(letters, played_tiles, &blankified_words_);
+          Blankify(letters, played_tiles, blankified_words);
           // LOG(INFO) << "blankified";
-          for (auto& blank_word : blankified_words_) {
+          for (auto& blank_word : *blankified_words) {
             Move blank_move(direction, start_row, start_col,
                             std::move(blank_word));
             /*
@@ -533,8 +645,12 @@ LOG(INFO) << " move " << ss.str();
               blank_move.SetCachedNumTiles(num_tiles);
               blank_move.SetNumBlanks(num_blanks);
               blank_move.SetMoveBits(move_bits);
-              playable_bits_ |= move_bits;
-              moves->push_back(std::move(blank_move));
+              *playable_bits |= move_bits;
+              if (record_mode == RecordMode::RecordBestK) {
+                RecordBestKMove(std::move(blank_move), moves);
+              } else {
+                moves->push_back(std::move(blank_move));
+              }
             }
           }
         }
@@ -595,10 +711,69 @@ void MoveFinder::CacheCrossesAndScores(const Board& board, const Move& move) {
     LOG(INFO) << "touching: " << touching;
   }
   */
+  std::array<AffectedSquare, kMaxAffectedSquares> squares;
+  const int num_squares = CrossesAffectedBy(board, move, &squares);
+  for (int i = 0; i < num_squares; ++i) {
+    const auto& square = squares[i];
+    CacheCrossesAndScores(board, square.row, square.col, square.across,
+                          square.down);
+  }
+  /*
+  LOG(INFO) << "across touching?";
+  for (int row = 0; row < 15; row++) {
+    std::string touching;
+    for (int col = 0; col < 15; col++) {
+      if (hook_table_[0][row][col] != kNotTouching) {
+        if (hook_table_[0][row][col] == 0) {
+          touching += "∅";
+        }
+        for (int i = 1; i < 26; ++i) {
+          if (hook_table_[0][row][col] & (1 << i)) {
+            touching += 'A' + i - 1;
+            break;
+          }
+        }
+      } else {
+        touching += ".";
+      }
+    }
+    LOG(INFO) << touching;
+  }
+  LOG(INFO) << "down touching?";
+  for (int row = 0; row < 15; row++) {
+    std::string touching;
+    for (int col = 0; col < 15; col++) {
+      if (hook_table_[1][row][col] != kNotTouching) {
+        if (hook_table_[1][row][col] == 0) {
+          touching += "∅";
+        }
+        for (int i = 1; i < 26; ++i) {
+          if (hook_table_[1][row][col] & (1 << i)) {
+            touching += 'A' + i - 1;
+            break;
+          }
+        }
+      } else {
+        touching += ".";
+      }
+    }
+    LOG(INFO) << touching;
+  }
+  */
+}
+
+int MoveFinder::CrossesAffectedBy(
+    const Board& board, const Move& move,
+    std::array<AffectedSquare, kMaxAffectedSquares>* squares) const {
   if (move.GetAction() != Move::Place) {
-    return;
+    return 0;
   }
-  // LOG(INFO) << "caching for move: " << ss.str();
+  int num_squares = 0;
+  const auto add_square = [squares, &num_squares](int row, int col,
+                                                  bool across, bool down) {
+    (*squares)[num_squares++] = {row, col, across, down};
+  };
+  const bool move_across = move.Direction() == Move::Across;
   int row = move.StartRow();
   int col = move.StartCol();
   int prevrow = row;
@@ -619,9 +794,7 @@ void MoveFinder::CacheCrossesAndScores(const Board& board, const Move& move) {
                  << " at " << prevrow << ", " << prevcol;
     }
     CHECK_EQ(board.At(prevrow, prevcol), 0);
-    CacheCrossesAndScores(board, prevrow, prevcol,
-                          move.Direction() == Move::Down,
-                          move.Direction() == Move::Across);
+    add_square(prevrow, prevcol, !move_across, move_across);
   }
   for (const auto letter : move.Letters()) {
     if (letter != 0) {
@@ -630,34 +803,26 @@ void MoveFinder::CacheCrossesAndScores(const Board& board, const Move& move) {
         while (--before_row >= 0 && board.At(before_row, col)) {
         }
         if (before_row >= 0) {
-          CacheCrossesAndScores(board, before_row, col,
-                                move.Direction() == Move::Across,
-                                move.Direction() == Move::Down);
+          add_square(before_row, col, move_across, !move_across);
         }
         int after_row = row;
         while (++after_row < 15 && board.At(after_row, col)) {
         }
         if (after_row < 15) {
-          CacheCrossesAndScores(board, after_row, col,
-                                move.Direction() == Move::Across,
-                                move.Direction() == Move::Down);
+          add_square(after_row, col, move_across, !move_across);
         }
       } else {
         int before_col = col;
         while (--before_col >= 0 && board.At(row, before_col)) {
         }
         if (before_col >= 0) {
-          CacheCrossesAndScores(board, row, before_col,
-                                move.Direction() == Move::Across,
-                                move.Direction() == Move::Down);
+          add_square(row, before_col, move_across, !move_across);
         }
         int after_col = col;
         while (++after_col < 15 && board.At(row, after_col)) {
         }
         if (after_col < 15) {
-          CacheCrossesAndScores(board, row, after_col,
-                                move.Direction() == Move::Across,
-                                move.Direction() == Move::Down);
+          add_square(row, after_col, move_across, !move_across);
         }
       }
     }
@@ -677,51 +842,9 @@ void MoveFinder::CacheCrossesAndScores(const Board& board, const Move& move) {
                  << " at " << row << ", " << col;
     }
     CHECK_EQ(board.At(row, col), 0);
-    CacheCrossesAndScores(board, row, col, move.Direction() == Move::Down,
-                          move.Direction() == Move::Across);
-  }
-  /*
-  LOG(INFO) << "across touching?";
-  for (int row = 0; row < 15; row++) {
-    std::string touching;
-    for (int col = 0; col < 15; col++) {
-      if (hook_table_[0][row][col] != kNotTouching) {
-        if (hook_table_[0][row][col] == 0) {
-          touching += "∅";
-        }
-        for (int i = 1; i < 26; ++i) {
-          if (hook_table_[0][row][col] & (1 << i)) {
-            touching += 'A' + i - 1;
-            break;
-          }
-        }
-      } else {
-        touching += ".";
-      }
-    }
-    LOG(INFO) << touching;
-  }
-  LOG(INFO) << "down touching?";
-  for (int row = 0; row < 15; row++) {
-    std::string touching;
-    for (int col = 0; col < 15; col++) {
-      if (hook_table_[1][row][col] != kNotTouching) {
-        if (hook_table_[1][row][col] == 0) {
-          touching += "∅";
-        }
-        for (int i = 1; i < 26; ++i) {
-          if (hook_table_[1][row][col] & (1 << i)) {
-            touching += 'A' + i - 1;
-            break;
-          }
-        }
-      } else {
-        touching += ".";
-      }
-    }
-    LOG(INFO) << touching;
+    add_square(row, col, !move_across, move_across);
   }
-  */
+  return num_squares;
 }
 
 void MoveFinder::CacheCrossesAndScores(const Board& board, int row, int col,
@@ -939,6 +1062,36 @@ bool MoveFinder::CheckHooks(const Board& board, const Move& move) const {
   return true;
 }
 
+bool MoveFinder::CheckHooksOnBoard(const Board& board,
+                                   const Move& move) const {
+  int row = move.StartRow();
+  int col = move.StartCol();
+  for (Letter letter : move.Letters()) {
+    if (letter) {
+      if (letter > tiles_.BlankIndex()) {
+        letter -= tiles_.BlankIndex();
+      }
+      auto cross = CrossAt(board, move.Direction(), row, col);
+      if (cross.has_value()) {
+        for (auto& cross_letter : cross.value()) {
+          if (cross_letter >= tiles_.BlankIndex()) {
+            cross_letter -= tiles_.BlankIndex();
+          }
+        }
+        if ((anagram_map_.Hooks(cross.value()) & (1 << letter)) == 0) {
+          return false;
+        }
+      }
+    }
+    if (move.Direction() == Move::Across) {
+      col++;
+    } else {
+      row++;
+    }
+  }
+  return true;
+}
+
 void MoveFinder::FindSpots(int rack_tiles, const Board& board,
                            Move::Dir direction,
                            std::vector<MoveFinder::Spot>* spots) {
@@ -1269,6 +1422,27 @@ void MoveFinder::FindSpots(const Rack& rack, const Board& board,
   SetRackBits(rack);
   FindSpots(rack.NumTiles(), board, Move::Across, spots);
   FindSpots(rack.NumTiles(), board, Move::Down, spots);
+  FinishSpots(rack, board, spots);
+}
+
+void MoveFinder::FinishSpots(const Rack& rack, const Board& board,
+                             std::vector<Spot>* spots) {
+  if (rack_table_ != nullptr) {
+    // The rack table knows how many tiles the rack can play through each
+    // number of board tiles; drop spots asking for more.
+    spots->erase(
+        std::remove_if(spots->begin(), spots->end(),
+                       [this, &board](Spot& spot) {
+                         const int num_through = NumThroughTiles(
+                             board, spot.Direction(), spot.StartRow(),
+                             spot.StartCol(), spot.NumTiles());
+                         spot.SetNumThroughTiles(num_through);
+                         return spot.NumTiles() >
+                                RackTable::MaxTilesPlayed(rack_word_sizes_,
+                                                          num_through);
+                       }),
+        spots->end());
+  }
 
   std::array<int, 7> tile_scores{0};
   const auto& letters = rack.Letters();
@@ -1289,8 +1463,8 @@ std::vector<MoveFinder::Spot> MoveFinder::FindSpots(const Rack& rack,
   return spots;
 }
 
-void MoveFinder::FindMoves(const Rack& rack, const Board& board, const Bag& bag,
-                           RecordMode record_mode,
+void MoveFinder::FindMoves(const Rack& rack, const Board& board,
+                           int num_unseen, RecordMode record_mode,
                            bool recompute_all_crosses_and_scores) {
   // LetterString i = tiles_.ToLetterString("I").value();
   // LOG(INFO) << "leaves_.Value(I): " << leaves_.Value(tiles_.ToProduct64(i));
@@ -1316,21 +1490,28 @@ void MoveFinder::FindMoves(const Rack& rack, const Board& board, const Bag& bag,
   pass.SetNumBlanks(0);
   moves_.push_back(pass);
   playable_bits_ = 0;
-  // LOG(INFO) << "bag.CanExchangeWithUnseen(): " <<
-  // bag.CanExchangeWithUnseen();
-  if (bag.CanExchangeWithUnseen()) {
+  // Same rule as Bag::CanExchangeWithUnseen().
+  if (num_unseen >= 14) {
     const auto exchanges = FindExchanges(rack, record_mode);
     if (record_mode == MoveFinder::RecordBest) {
       if (exchanges[0].Equity() > moves_[0].Equity()) {
         moves_[0] = exchanges[0];
       }
+    } else if (record_mode == MoveFinder::RecordBestK) {
+      for (const auto& exchange : exchanges) {
+        RecordBestKMove(Move(exchange), &moves_);
+      }
     } else {
       moves_.insert(moves_.end(), exchanges.begin(), exchanges.end());
     }
   }
   spots_.clear();
   FindSpots(rack, board, &spots_);
-  if (record_mode == MoveFinder::RecordBest) {
+  const int num_threads = std::min(
+      num_threads_, static_cast<int>(spots_.size() / kMinSpotsPerThread));
+  if (num_threads > 1) {
+    FindWordsInParallel(rack, board, record_mode, num_threads);
+  } else if (record_mode == MoveFinder::RecordBest) {
     spot_ptrs_.clear();
     float best_equity = moves_[0].Equity();
     for (auto& spot : spots_) {
@@ -1378,6 +1559,24 @@ void MoveFinder::FindMoves(const Rack& rack, const Board& board, const Bag& bag,
       best_equity = moves_[0].Equity();
     }
     */
+  } else if (record_mode == MoveFinder::RecordBestK) {
+    // Same traversal as RecordBest, but the bound is the K-th best equity
+    // found so far rather than the best.
+    spot_ptrs_.clear();
+    for (auto& spot : spots_) {
+      spot_ptrs_.push_back(&spot);
+    }
+    std::sort(spot_ptrs_.begin(), spot_ptrs_.end(),
+              [](const Spot* a, const Spot* b) {
+                return a->MaxEquity() > b->MaxEquity();
+              });
+    for (const auto* spot : spot_ptrs_) {
+      if (spot->MaxEquity() < BestKThreshold(moves_) + 1e-5) {
+        break;
+      }
+      FindWords(rack, board, *spot, record_mode, 0.0, &moves_);
+    }
+    SortBestK();
   } else {
     for (const MoveFinder::Spot& spot : spots_) {
       FindWords(rack, board, spot, record_mode, 0.0, &moves_);
@@ -1385,6 +1584,251 @@ void MoveFinder::FindMoves(const Rack& rack, const Board& board, const Bag& bag,
   }
 }
 
+namespace {
+// Squares as row * 15 + col.
+typedef std::bitset<225> SquareSet;
+
+// Calls fn(row, col, is_placed) for each square of move's word, plus the
+// squares just before and after it, if on the board. is_placed is whether
+// move places a tile there.
+template <typename F>
+void ForEachSquareAround(const Move& move, const Board& board, F fn) {
+  const bool across = move.Direction() == Move::Across;
+  int row = move.StartRow();
+  int col = move.StartCol();
+  if ((across ? col : row) > 0) {
+    fn(across ? row : row - 1, across ? col - 1 : col, false);
+  }
+  int i = 0;
+  while (row < 15 && col < 15) {
+    const bool in_word = i < move.Letters().size();
+    const bool is_placed = in_word && move.Letters()[i] != 0;
+    fn(row, col, is_placed);
+    if (!in_word && !board.At(row, col)) {
+      // The square after the word.
+      break;
+    }
+    i++;
+    if (across) {
+      col++;
+    } else {
+      row++;
+    }
+  }
+}
+
+// Whether any square a move from spot could cover, or either square next to
+// it, is in squares.
+bool SpotReaches(const MoveFinder::Spot& spot, const Board& board,
+                 const SquareSet& squares) {
+  const bool across = spot.Direction() == Move::Across;
+  int row = spot.StartRow();
+  int col = spot.StartCol();
+  if ((across ? col : row) > 0 &&
+      squares[across ? row * 15 + col - 1 : (row - 1) * 15 + col]) {
+    return true;
+  }
+  int num_empty = 0;
+  while (row < 15 && col < 15) {
+    if (squares[row * 15 + col]) {
+      return true;
+    }
+    if (!board.At(row, col)) {
+      if (num_empty == spot.NumTiles()) {
+        // The square after the word.
+        break;
+      }
+      num_empty++;
+    }
+    if (across) {
+      col++;
+    } else {
+      row++;
+    }
+  }
+  return false;
+}
+}  // namespace
+
+void MoveFinder::FindMovesAfter(const Rack& rack, const Board& board,
+                                const Move& delta,
+                                const std::vector<Move>& previous_moves) {
+  CacheSubsets(rack);
+  CacheRackPartitions(rack);
+  SetRackBits(rack);
+  moves_.clear();
+  playable_bits_ = 0;
+  if (delta.GetAction() != Move::Place) {
+    moves_ = previous_moves;
+    for (const auto& move : moves_) {
+      playable_bits_ |= move.MoveBits();
+    }
+    return;
+  }
+  // Squares delta filled, and squares whose crosses it changed.
+  SquareSet filled;
+  ForEachSquareAround(delta, board, [&](int row, int col, bool is_placed) {
+    if (is_placed) {
+      filled.set(row * 15 + col);
+    }
+  });
+  SquareSet changed = filled;
+  std::array<AffectedSquare, kMaxAffectedSquares> affected;
+  const int num_affected = CrossesAffectedBy(board, delta, &affected);
+  for (int i = 0; i < num_affected; ++i) {
+    changed.set(affected[i].row * 15 + affected[i].col);
+  }
+  // A move is unaffected if it places no tiles on changed squares and its
+  // word, including the squares at either end, doesn't reach a filled one.
+  // Unaffected moves are the same on both boards, with the same score.
+  const auto affected_by_delta = [&filled, &changed, &board](const Move& move) {
+    if (move.GetAction() != Move::Place) {
+      return false;
+    }
+    bool affected = false;
+    ForEachSquareAround(move, board, [&](int row, int col, bool is_placed) {
+      const int square = row * 15 + col;
+      affected |= filled[square] || (is_placed && changed[square]);
+    });
+    return affected;
+  };
+  for (const auto& move : previous_moves) {
+    if (!affected_by_delta(move)) {
+      moves_.push_back(move);
+      playable_bits_ |= move.MoveBits();
+    }
+  }
+  // Every affected move comes from a spot that reaches a changed square.
+  spots_.clear();
+  FindSpots(rack.NumTiles(), board, Move::Across, &spots_);
+  FindSpots(rack.NumTiles(), board, Move::Down, &spots_);
+  spots_.erase(std::remove_if(spots_.begin(), spots_.end(),
+                              [&board, &changed](const Spot& spot) {
+                                return !SpotReaches(spot, board, changed);
+                              }),
+               spots_.end());
+  FinishSpots(rack, board, &spots_);
+  const size_t num_unaffected = moves_.size();
+  for (const auto& spot : spots_) {
+    FindWords(rack, board, spot, RecordAll, 0.0, &moves_);
+  }
+  // Spots can also find unaffected moves, which were already kept.
+  moves_.erase(std::remove_if(moves_.begin() + num_unaffected, moves_.end(),
+                              [&affected_by_delta](const Move& move) {
+                                return !affected_by_delta(move);
+                              }),
+               moves_.end());
+}
+
+void MoveFinder::FindWordsInParallel(const Rack& rack, const Board& board,
+                                     RecordMode record_mode, int num_threads) {
+  // HasWord(...) caches its lookup in the partition, so do every lookup before
+  // the workers start sharing rack_partitions_.
+  for (int num_tiles = 1; num_tiles <= 7; ++num_tiles) {
+    for (auto& partition : rack_partitions_[num_tiles]) {
+      HasWord(&partition);
+    }
+  }
+  spot_ptrs_.clear();
+  for (const auto& spot : spots_) {
+    spot_ptrs_.push_back(&spot);
+  }
+  if (record_mode != MoveFinder::RecordAll) {
+    std::sort(spot_ptrs_.begin(), spot_ptrs_.end(),
+              [](const Spot* a, const Spot* b) {
+                return a->MaxEquity() > b->MaxEquity();
+              });
+  }
+
+  struct WorkerScratch {
+    std::vector<Move> moves;
+    std::vector<LetterString> blankified_words;
+    uint32_t playable_bits = 0;
+  };
+  std::vector<WorkerScratch> scratches(num_threads);
+  if (record_mode == MoveFinder::RecordBest) {
+    for (auto& scratch : scratches) {
+      scratch.moves.push_back(moves_[0]);
+    }
+  }
+  std::atomic<float> shared_best_equity(moves_[0].Equity());
+  std::atomic<size_t> next_spot(0);
+
+  auto worker = [&](int thread_index) {
+    auto& scratch = scratches[thread_index];
+    if (record_mode == MoveFinder::RecordAll) {
+      // Contiguous ranges keep the merged moves in the serial order.
+      const size_t begin = spot_ptrs_.size() * thread_index / num_threads;
+      const size_t end = spot_ptrs_.size() * (thread_index + 1) / num_threads;
+      for (size_t i = begin; i < end; ++i) {
+        FindWords(rack, board, *spot_ptrs_[i], record_mode, 0.0,
+                  &scratch.moves, &scratch.blankified_words,
+                  &scratch.playable_bits);
+      }
+      return;
+    }
+    // Spots are sorted by MaxEquity, so workers take them in that order and
+    // each stops at the first one that can't beat its bound.
+    for (;;) {
+      const size_t i = next_spot.fetch_add(1);
+      if (i >= spot_ptrs_.size()) {
+        return;
+      }
+      const Spot* spot = spot_ptrs_[i];
+      if (record_mode == MoveFinder::RecordBest) {
+        const float best_equity =
+            std::max(shared_best_equity.load(),
+                     static_cast<float>(scratch.moves[0].Equity()));
+        if (spot->MaxEquity() + 1e-5 < best_equity) {
+          return;
+        }
+        FindWords(rack, board, *spot, record_mode, best_equity,
+                  &scratch.moves, &scratch.blankified_words,
+                  &scratch.playable_bits);
+        const float found = scratch.moves[0].Equity();
+        float current = shared_best_equity.load();
+        while (found > current &&
+               !shared_best_equity.compare_exchange_weak(current, found)) {
+        }
+      } else {
+        if (spot->MaxEquity() < BestKThreshold(scratch.moves) + 1e-5) {
+          return;
+        }
+        FindWords(rack, board, *spot, record_mode, 0.0, &scratch.moves,
+                  &scratch.blankified_words, &scratch.playable_bits);
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (int i = 1; i < num_threads; ++i) {
+    threads.emplace_back(worker, i);
+  }
+  worker(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (auto& scratch : scratches) {
+    playable_bits_ |= scratch.playable_bits;
+    if (record_mode == MoveFinder::RecordAll) {
+      moves_.insert(moves_.end(), std::make_move_iterator(scratch.moves.begin()),
+                    std::make_move_iterator(scratch.moves.end()));
+    } else if (record_mode == MoveFinder::RecordBest) {
+      if (scratch.moves[0].Equity() > moves_[0].Equity() + 1e-5) {
+        moves_[0] = std::move(scratch.moves[0]);
+      }
+    } else {
+      for (auto& move : scratch.moves) {
+        RecordBestKMove(std::move(move), &moves_);
+      }
+    }
+  }
+  if (record_mode == MoveFinder::RecordBestK) {
+    SortBestK();
+  }
+}
+
 bool MoveFinder::IsBlocked(const Move& move, const Board& board) const {
   if (move.GetAction() != Move::Place) {
     return false;
@@ -1,8 +1,11 @@
 #ifndef SRC_SCRABBLE_MOVE_FINDER_H
 #define SRC_SCRABBLE_MOVE_FINDER_H
 
+#include <limits>
+
 #include "src/anagram/anagram_map.h"
 #include "src/leaves/leaves.h"
+#include "src/rack_table/rack_table.h"
 #include "src/scrabble/bag.h"
 #include "src/scrabble/board.h"
 #include "src/scrabble/board_layout.h"
@@ -24,6 +27,13 @@ typedef std::array<ScoreBoard, 2> ScoreTable;
 // a word to the existing plays on the board.
 const uint32_t kNotTouching = 0xffffffff;
 
+// A copy of MoveFinder's cached crosses and scores for one board, so that
+// players starting from the same board don't each have to recompute them.
+struct CrossesAndScores {
+  HookTable hook_table;
+  ScoreTable score_table;
+};
+
 class MoveFinder {
  public:
   enum RecordMode { RecordAll, RecordBest, RecordBestK };
@@ -35,6 +45,7 @@ class MoveFinder {
           start_row_(start_row),
           start_col_(start_col),
           num_tiles_(num_tiles),
+          num_through_tiles_(0),
           minimum_blanks_(0),
           required_letters_(0),
           impossible_letters_(0) {}
@@ -51,6 +62,10 @@ class MoveFinder {
     inline uint8_t StartRow() const { return start_row_; }
     inline uint8_t StartCol() const { return start_col_; }
     inline uint8_t NumTiles() const { return num_tiles_; }
+    inline uint8_t NumThroughTiles() const { return num_through_tiles_; }
+    inline void SetNumThroughTiles(uint8_t num_through_tiles) {
+      num_through_tiles_ = num_through_tiles;
+    }
     inline uint8_t WordMultiplier() const { return word_multiplier_; }
     inline uint16_t ExtraScore() const { return extra_score_; }
     inline uint16_t MaxScore() const { return max_score_; }
@@ -110,6 +125,8 @@ class MoveFinder {
     uint8_t start_row_;
     uint8_t start_col_;
     uint8_t num_tiles_;
+    // Only set when a rack table is in use.
+    uint8_t num_through_tiles_;
     uint8_t word_multiplier_;
 
     // extra_score = through score + hook sum + bingo bonus
@@ -142,7 +159,8 @@ class MoveFinder {
           leave_value_(leave_value),
           has_word_status_(kHasWord),
           word_iterator_(word_iterator),
-          bits_(bits) {}
+          bits_(bits),
+          word_sizes_(RackTable::kUnknownWordSizes) {}
     uint64_t UsedProduct() const { return used_product_; }
     uint8_t NumBlanks() const { return num_blanks_; }
     const LetterString& UsedLetters() const { return used_letters_; }
@@ -158,6 +176,8 @@ class MoveFinder {
     }
     const AnagramMapIterator& WordIterator() const { return word_iterator_; }
     uint32_t Bits() const { return bits_; }
+    uint32_t WordSizes() const { return word_sizes_; }
+    void SetWordSizes(uint32_t word_sizes) { word_sizes_ = word_sizes; }
 
    private:
     // Prime product of the letters in used_letters_, not including blanks.
@@ -170,6 +190,9 @@ class MoveFinder {
     enum HasWordStatus has_word_status_;
     AnagramMapIterator word_iterator_;
     uint32_t bits_;
+
+    // From the rack table, for used_letters_ with its blanks.
+    uint32_t word_sizes_;
   };
 
   MoveFinder(const AnagramMap& anagram_map, const BoardLayout& board_layout,
@@ -177,15 +200,62 @@ class MoveFinder {
       : anagram_map_(anagram_map),
         board_layout_(board_layout),
         tiles_(tiles),
-        leaves_(leaves) {
+        leaves_(leaves),
+        best_k_(1),
+        num_threads_(1),
+        rack_table_(nullptr),
+        rack_word_sizes_(RackTable::kUnknownWordSizes) {
     // LOG(INFO) << "MoveFinder constructor called";
     moves_.reserve(80000);
     ClearHookTables();
   }
 
   const std::vector<Move>& Moves() const { return moves_; }
+
+  // Number of moves kept by RecordBestK, or kNoLimit to keep them all.
+  // After FindMoves(...) in that mode, Moves() holds at most this many
+  // moves, sorted by descending equity.
+  static constexpr int kNoLimit = 0;
+  void SetBestK(int best_k) {
+    CHECK_GE(best_k, 0);
+    best_k_ = best_k;
+  }
+  int BestK() const { return best_k_; }
+
+  // Number of threads FindMoves(...) may use to search spots. With more than
+  // one, spots are divided among workers with their own scratch space and the
+  // results are merged, so Moves() has the same contents as a serial search
+  // (RecordBest may pick a different move among equal-equity ties).
+  void SetNumThreads(int num_threads) {
+    CHECK_GE(num_threads, 1);
+    num_threads_ = num_threads;
+  }
+  int NumThreads() const { return num_threads_; }
+
+  // Optional table of the longest words each rack can make through a given
+  // number of board tiles (see RackTable). When set, FindMoves(...) drops
+  // spots and rack partitions that cannot make a word. Not owned.
+  void SetRackTable(const RackTable* rack_table) { rack_table_ = rack_table; }
+
   void FindMoves(const Rack& rack, const Board& board, const Bag& bag,
+                 RecordMode record_mode, bool recompute_all_crosses_and_scores) {
+    FindMoves(rack, board, bag.Size(), record_mode,
+              recompute_all_crosses_and_scores);
+  }
+  // Only the number of unseen tiles matters (for whether exchanges are
+  // legal), so callers holding a GamePosition can pass NumUnseen().
+  void FindMoves(const Rack& rack, const Board& board, int num_unseen,
                  RecordMode record_mode, bool recompute_all_crosses_and_scores);
+  // Finds what FindMoves(rack, board, ..., RecordAll, false) would, given
+  // previous_moves, all the moves for rack on the board before delta was
+  // placed. The crosses and scores of board, with delta placed, must already
+  // be cached (as by CacheCrossesAndScores(board, delta)). Previous moves
+  // that place no tile on a square delta filled or changed the crosses of,
+  // and whose words don't reach a filled square, are kept as they are, and
+  // words are only searched for in spots that reach one of those squares.
+  // Moves() may be in a different order than FindMoves(...) would give.
+  void FindMovesAfter(const Rack& rack, const Board& board, const Move& delta,
+                      const std::vector<Move>& previous_moves);
   void CacheSubsets(const Rack& rack);
   void CacheRackPartitions(const Rack& rack);
   std::vector<Move> FindExchanges(const Rack& rack,
@@ -197,7 +267,25 @@ class MoveFinder {
 
   void CacheCrossesAndScores(const Board& board);
 
+  // Copies out or replaces all cached crosses and scores. Incremental
+  // CacheCrossesAndScores(board, move) calls can continue from a copy set
+  // here as if it had been computed by this MoveFinder.
+  void GetCrossesAndScores(CrossesAndScores* crosses_and_scores) const {
+    crosses_and_scores->hook_table = hook_table_;
+    crosses_and_scores->score_table = score_table_;
+  }
+  void SetCrossesAndScores(const CrossesAndScores& crosses_and_scores) {
+    hook_table_ = crosses_and_scores.hook_table;
+    score_table_ = crosses_and_scores.score_table;
+  }
+
   bool IsBlocked(const Move& move, const Board& board) const;
+  // Whether the cached cross-checks allow every tile the move places.
+  bool CheckHooks(const Board& board, const Move& move) const;
+  // As CheckHooks(...), but works out the cross-checks of the move's squares
+  // from board instead of the cache, so the cache needn't be kept up to date
+  // with board.
+  bool CheckHooksOnBoard(const Board& board, const Move& move) const;
 
   inline bool StuckWithTile(int* score) {
     auto rack_bits = rack_bits_;
@@ -278,6 +366,23 @@ class MoveFinder {
   FRIEND_TEST(MoveFinderTest, ThroughScore);
   FRIEND_TEST(MoveFinderTest, WordScore);
   FRIEND_TEST(MoveFinderTest, CacheCrossesAndScores);
+  FRIEND_TEST(MoveFinderTest, FindMovesWithRackTable);
+
+  // An empty square whose crosses CacheCrossesAndScores(board, move)
+  // recomputes, and in which directions.
+  struct AffectedSquare {
+    int row;
+    int col;
+    bool across;
+    bool down;
+  };
+  // One on each side of each placed tile, and one at each end.
+  static constexpr int kMaxAffectedSquares = 16;
+  // Fills in the squares whose crosses change when move is placed on board
+  // (which already has it placed) and returns how many there are.
+  int CrossesAffectedBy(
+      const Board& board, const Move& move,
+      std::array<AffectedSquare, kMaxAffectedSquares>* squares) const;
 
   void ComputeEmptyBoardSpotMaxEquity(const Rack& rack, Spot* spot);
   void ComputeSpotMaxEquity(const Rack& rack,
@@ -289,6 +394,9 @@ class MoveFinder {
 
   void FindSpots(const Rack& rack, const Board& board,
                  std::vector<Spot>* spots);
+  // Drops spots the rack table rules out and computes each spot's scores.
+  void FinishSpots(const Rack& rack, const Board& board,
+                   std::vector<Spot>* spots);
   std::vector<Spot> FindSpots(const Rack& rack, const Board& board);
 
   absl::uint128 AbsorbThroughTiles(const Board& board, Move::Dir direction,
@@ -304,6 +412,9 @@ class MoveFinder {
   int ThroughScore(const Board& board, Move::Dir direction, int start_row,
                    int start_col, int num_tiles) const;
 
+  int NumThroughTiles(const Board& board, Move::Dir direction, int start_row,
+                      int start_col, int num_tiles) const;
+
   int WordScore(const Board& board, const Move& move, int word_multiplier);
 
   // Returns true iff the word fits with the tiles already on the board.
@@ -320,8 +431,6 @@ class MoveFinder {
   // with anagram_map_.Hooks(). To use this for scoring, don't unblank.
   absl::optional<LetterString> CrossAt(const Board& board, Move::Dir play_dir,
                                        int square_row, int square_col) const;
-  bool CheckHooks(const Board& board, const Move& move) const;
-
   void Blankify(const LetterString& rack_letters, const LetterString& word,
                 std::vector<LetterString>* target) const;
 
@@ -369,8 +478,32 @@ class MoveFinder {
                  RecordMode record_mode, float best_equity,
                  std::vector<Move>* moves);
 
+  void FindWords(const Rack& rack, const Board& board, const Spot& spot,
+                 RecordMode record_mode, float best_equity,
+                 std::vector<Move>* moves,
+                 std::vector<LetterString>* blankified_words,
+                 uint32_t* playable_bits);
+
+  // Searches spots_ on up to num_threads_ threads and merges the results into
+  // moves_, which already holds the pass and any exchanges.
+  void FindWordsInParallel(const Rack& rack, const Board& board,
+                           RecordMode record_mode, int num_threads);
+
   void SetRackBits(const Rack& rack);
 
+  // RecordBestK keeps moves as a min-heap on equity, so the weakest recorded
+  // move is at the front. Until the heap is full, nothing can be pruned.
+  // With kNoLimit, moves are only appended and sorted at the end.
+  inline float BestKThreshold(const std::vector<Move>& moves) const {
+    if (best_k_ == kNoLimit || moves.size() < static_cast<size_t>(best_k_)) {
+      return -std::numeric_limits<float>::infinity();
+    }
+    return moves.front().Equity();
+  }
+  void RecordBestKMove(Move&& move, std::vector<Move>* moves) const;
+  // Sorts moves_ recorded by RecordBestK by descending equity.
+  void SortBestK();
+
   const AnagramMap& anagram_map_;
   const BoardLayout& board_layout_;
   const Tiles& tiles_;
@@ -381,6 +514,8 @@ class MoveFinder {
                       absl::optional<LetterString>>
       cross_map_;
   absl::flat_hash_map<uint64_t, LetterString> subsets_;
+  // subsets_ in ascending product order (see CacheRackPartitions).
+  std::vector<const std::pair<const uint64_t, LetterString>*> ordered_subsets_;
   HookTable hook_table_;
   ScoreTable score_table_;
   std::vector<Move> moves_;
@@ -399,6 +534,10 @@ class MoveFinder {
   int num_blanks_;
   std::vector<Spot> spots_;
   std::vector<const Spot*> spot_ptrs_;
+  int best_k_;
+  int num_threads_;
+  const RackTable* rack_table_;
+  uint32_t rack_word_sizes_;
 };
 
 inline bool operator==(const MoveFinder::Spot& a, const MoveFinder::Spot& b) {
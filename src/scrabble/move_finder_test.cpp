@@ -371,6 +371,33 @@ TEST_F(MoveFinderTest, CheckHooks) {
   EXPECT_FALSE(move_finder_->CheckHooks(board, ax.value()));
 }
 
+TEST_F(MoveFinderTest, CheckHooksOnBoard) {
+  Board board;
+  // Cached for the empty board, which CheckHooksOnBoard(...) shouldn't use.
+  move_finder_->CacheCrossesAndScores(board);
+  const auto aa = Move::Parse("8G AA", *tiles_);
+  board.UnsafePlaceMove(aa.value());
+
+  const auto hm = Move::Parse("7G HM", *tiles_);
+  EXPECT_TRUE(move_finder_->CheckHooksOnBoard(board, hm.value()));
+  const auto faan = Move::Parse("7F FAAN", *tiles_);
+  EXPECT_TRUE(move_finder_->CheckHooksOnBoard(board, faan.value()));
+  const auto qi = Move::Parse("7G QI", *tiles_);
+  EXPECT_FALSE(move_finder_->CheckHooksOnBoard(board, qi.value()));
+  EXPECT_TRUE(move_finder_->CheckHooks(board, qi.value()));
+  const auto ax = Move::Parse("7G AX", *tiles_);
+  EXPECT_FALSE(move_finder_->CheckHooksOnBoard(board, ax.value()));
+
+  // Designated blanks on the board hook as the letters they stand for.
+  const auto ab = Move::Parse("9G aB", *tiles_);
+  board.UnsafePlaceMove(ab.value());
+  // AAS and ABA, but not AAX.
+  const auto sa = Move::Parse("10G SA", *tiles_);
+  EXPECT_TRUE(move_finder_->CheckHooksOnBoard(board, sa.value()));
+  const auto xa = Move::Parse("10G XA", *tiles_);
+  EXPECT_FALSE(move_finder_->CheckHooksOnBoard(board, xa.value()));
+}
+
 TEST_F(MoveFinderTest, SevenTileOverlap) {
   Board board;
   const auto airtime = Move::Parse("8G AiRTIME", *tiles_);
@@ -1033,3 +1060,227 @@ TEST_F(MoveFinderTest, FindMissingMove) {
   const std::vector<Move>& moves = move_finder_->Moves();
   EXPECT_EQ(moves[0].Score(), 72);  // M5 mASTERy or wASTERy
 }
+
+TEST_F(MoveFinderTest, RecordBestK) {
+  Board board;
+  const auto abaters = Move::Parse("8B abATERS", *tiles_);
+  board.UnsafePlaceMove(abaters.value());
+  const auto rabattes = Move::Parse("E4 RabA.TES", *tiles_);
+  board.UnsafePlaceMove(rabattes.value());
+  const Rack rack(tiles_->ToLetterString("EIQSUV?").value());
+  move_finder_->FindMoves(rack, board, *full_bag_, MoveFinder::RecordAll,
+                          true);
+  std::vector<Move> all_moves = move_finder_->Moves();
+  std::stable_sort(
+      all_moves.begin(), all_moves.end(),
+      [](const Move& a, const Move& b) { return a.Equity() > b.Equity(); });
+
+  for (const int k : {1, 10, 100}) {
+    move_finder_->SetBestK(k);
+    move_finder_->FindMoves(rack, board, *full_bag_, MoveFinder::RecordBestK,
+                            true);
+    const std::vector<Move>& moves = move_finder_->Moves();
+    ASSERT_EQ(moves.size(), k);
+    for (int i = 0; i < k; ++i) {
+      EXPECT_NEAR(moves[i].Equity(), all_moves[i].Equity(), 1e-4);
+    }
+  }
+  // With no limit, every move is kept.
+  move_finder_->SetBestK(MoveFinder::kNoLimit);
+  move_finder_->FindMoves(rack, board, *full_bag_, MoveFinder::RecordBestK,
+                          true);
+  const std::vector<Move>& moves = move_finder_->Moves();
+  ASSERT_EQ(moves.size(), all_moves.size());
+  for (int i = 0; i < moves.size(); ++i) {
+    EXPECT_NEAR(moves[i].Equity(), all_moves[i].Equity(), 1e-4);
+  }
+  move_finder_->SetBestK(1);
+}
+
+TEST_F(MoveFinderTest, FindMovesInParallel) {
+  Board board;
+  const auto abaters = Move::Parse("8B abATERS", *tiles_);
+  board.UnsafePlaceMove(abaters.value());
+  const auto rabattes = Move::Parse("E4 RabA.TES", *tiles_);
+  board.UnsafePlaceMove(rabattes.value());
+  const auto gastreas = Move::Parse("H1 gaSTREA.", *tiles_);
+  board.UnsafePlaceMove(gastreas.value());
+  const Rack rack(tiles_->ToLetterString("EIQSUV?").value());
+  const auto by_equity = [](const Move& a, const Move& b) {
+    return a.Equity() > b.Equity();
+  };
+
+  for (const auto record_mode :
+       {MoveFinder::RecordAll, MoveFinder::RecordBest,
+        MoveFinder::RecordBestK}) {
+    move_finder_->SetBestK(20);
+    move_finder_->SetNumThreads(1);
+    move_finder_->FindMoves(rack, board, *full_bag_, record_mode, true);
+    std::vector<Move> serial_moves = move_finder_->Moves();
+    std::stable_sort(serial_moves.begin(), serial_moves.end(), by_equity);
+    move_finder_->SetNumThreads(4);
+    move_finder_->FindMoves(rack, board, *full_bag_, record_mode, true);
+    std::vector<Move> moves = move_finder_->Moves();
+    std::stable_sort(moves.begin(), moves.end(), by_equity);
+    ASSERT_EQ(moves.size(), serial_moves.size());
+    for (size_t i = 0; i < moves.size(); ++i) {
+      EXPECT_NEAR(moves[i].Equity(), serial_moves[i].Equity(), 1e-4);
+    }
+  }
+  move_finder_->SetBestK(1);
+  move_finder_->SetNumThreads(1);
+}
+
+TEST_F(MoveFinderTest, FindMovesWithRackTable) {
+  auto rack_table =
+      RackTable::CreateFromOrtFile("src/scrabble/testdata/csw21.ort");
+  ASSERT_NE(rack_table, nullptr);
+  Board board;
+  board.SetLetters(
+      {R"(   A B C D E F G H I J K L M N O  )",
+       R"(   ------------------------------ )",
+       R"( 1|=     '       =       C A G Y| )",
+       R"( 2|  -       "       " W O N -  | )",
+       R"( 3|    -       '   ' S I N D    | )",
+       R"( 4|I     -       '   U N I     '| )",
+       R"( 5|M       -         B O A      | )",
+       R"( 6|P "       "       V       "  | )",
+       R"( 7|R   '       '   ' I     '    | )",
+       R"( 8|E E K '       U N R I D     =| )",
+       R"( 9|S M I D G E O N ' A G E '    | )",
+       R"(10|s "       "   F I L L E T "  | )",
+       R"(11|E       F A V E L   U R E    | )",
+       R"(12|D     Z A X   T I     E E   '| )",
+       R"(13|  T W A Y   ' T A       T    | )",
+       R"(14|L O O S   J O E   "     H U P| )",
+       R"(15|=     '       R A N c H E R A| )"},
+      *tiles_);
+  const auto by_equity = [](const Move& a, const Move& b) {
+    return a.Equity() > b.Equity();
+  };
+  for (const std::string& letters : {"EIQSUV?", "AEIOUUV", "CDGNRTW"}) {
+    const Rack rack(LS(letters));
+    move_finder_->SetRackTable(nullptr);
+    move_finder_->CacheCrossesAndScores(board);
+    move_finder_->CacheSubsets(rack);
+    move_finder_->CacheRackPartitions(rack);
+    const int num_spots = move_finder_->FindSpots(rack, board).size();
+    move_finder_->FindMoves(rack, board, *full_bag_, MoveFinder::RecordAll,
+                            true);
+    std::vector<Move> expected = move_finder_->Moves();
+    std::stable_sort(expected.begin(), expected.end(), by_equity);
+
+    move_finder_->SetRackTable(rack_table.get());
+    move_finder_->CacheSubsets(rack);
+    move_finder_->CacheRackPartitions(rack);
+    const int num_pruned_spots = move_finder_->FindSpots(rack, board).size();
+    EXPECT_LT(num_pruned_spots, num_spots) << letters;
+    move_finder_->FindMoves(rack, board, *full_bag_, MoveFinder::RecordAll,
+                            true);
+    std::vector<Move> moves = move_finder_->Moves();
+    std::stable_sort(moves.begin(), moves.end(), by_equity);
+    ASSERT_EQ(moves.size(), expected.size()) << letters;
+    for (size_t i = 0; i < moves.size(); ++i) {
+      EXPECT_NEAR(moves[i].Equity(), expected[i].Equity(), 1e-4);
+    }
+  }
+  move_finder_->SetRackTable(nullptr);
+}
+
+TEST_F(MoveFinderTest, SetCrossesAndScores) {
+  Board board;
+  const auto move1 = Move::Parse("8D QUACK", *tiles_).value();
+  board.UnsafePlaceMove(move1);
+  const auto move2 = Move::Parse("E7 M.ZAK", *tiles_);
+  auto move_finder = absl::make_unique<MoveFinder>(*anagram_map_, *board_layout_,
+                                                   *tiles_, *leaves_);
+  move_finder->CacheCrossesAndScores(board);
+  CrossesAndScores after_move1;
+  move_finder->GetCrossesAndScores(&after_move1);
+
+  // Continue incrementally from a copy, as a rollout player would.
+  auto copy = absl::make_unique<MoveFinder>(*anagram_map_, *board_layout_, *tiles_,
+                                            *leaves_);
+  copy->SetCrossesAndScores(after_move1);
+  ASSERT_TRUE(move2.ok());
+  board.UnsafePlaceMove(move2.value());
+  copy->CacheCrossesAndScores(board, move2.value());
+  move_finder->CacheCrossesAndScores(board);
+
+  CrossesAndScores incremental;
+  CrossesAndScores rescanned;
+  copy->GetCrossesAndScores(&incremental);
+  move_finder->GetCrossesAndScores(&rescanned);
+  // Incremental updates leave stale values under the new tiles, which are
+  // never read, so only empty squares are compared.
+  for (int dir = 0; dir < 2; ++dir) {
+    for (int row = 0; row < 15; ++row) {
+      for (int col = 0; col < 15; ++col) {
+        if (board.At(row, col)) {
+          continue;
+        }
+        EXPECT_EQ(incremental.hook_table[dir][row][col],
+                  rescanned.hook_table[dir][row][col])
+            << dir << " " << row << " " << col;
+        EXPECT_EQ(incremental.score_table[dir][row][col],
+                  rescanned.score_table[dir][row][col])
+            << dir << " " << row << " " << col;
+      }
+    }
+  }
+}
+
+TEST_F(MoveFinderTest, FindMovesAfter) {
+  Board board;
+  board.SetLetters(
+      {R"(   A B C D E F G H I J K L M N O  )",
+       R"(   ------------------------------ )",
+       R"( 1|=     '       =       C A G Y| )",
+       R"( 2|  -       "       " W O N -  | )",
+       R"( 3|    -       '   ' S I N D    | )",
+       R"( 4|I     -       '   U N I     '| )",
+       R"( 5|M       -         B O A      | )",
+       R"( 6|P "       "       V       "  | )",
+       R"( 7|R   '       '   ' I     '    | )",
+       R"( 8|E E K '       U N R I D     =| )",
+       R"( 9|S M I D G E O N ' A G E '    | )",
+       R"(10|s "       "   F I L L E T "  | )",
+       R"(11|E       F A V E L   U R E    | )",
+       R"(12|D     Z A X   T I     E E   '| )",
+       R"(13|  T W A Y   ' T A       T    | )",
+       R"(14|L O O S   J O E   "     H U P| )",
+       R"(15|=     '       R A N c H E R A| )"},
+      *tiles_);
+  const auto move_strings = [this](const std::vector<Move>& moves) {
+    std::vector<std::string> ret;
+    for (const auto& move : moves) {
+      std::stringstream ss;
+      move.Display(*tiles_, ss);
+      ret.push_back(ss.str());
+    }
+    std::sort(ret.begin(), ret.end());
+    return ret;
+  };
+  move_finder_->FindMoves(Rack(LS("DEHIORS")), board, *empty_bag_,
+                          MoveFinder::RecordAll, true);
+  const std::vector<Move> replies = move_finder_->Moves();
+  for (const std::string& letters : {"EIQSUV?", "AEIOUUV", "CDGNRTW"}) {
+    const Rack rack(LS(letters));
+    move_finder_->FindMoves(rack, board, *empty_bag_, MoveFinder::RecordAll,
+                            true);
+    const std::vector<Move> previous_moves = move_finder_->Moves();
+    for (size_t i = 0; i < replies.size(); i += 7) {
+      const Move& reply = replies[i];
+      Board next_board = board;
+      next_board.UnsafePlaceMove(reply);
+      move_finder_->FindMoves(rack, next_board, *empty_bag_,
+                              MoveFinder::RecordAll, true);
+      const auto expected = move_strings(move_finder_->Moves());
+      move_finder_->FindMovesAfter(rack, next_board, reply, previous_moves);
+      std::stringstream ss;
+      reply.Display(*tiles_, ss);
+      EXPECT_EQ(move_strings(move_finder_->Moves()), expected)
+          << letters << " after " << ss.str();
+    }
+  }
+}
@@ -0,0 +1,332 @@
+#include "src/scrabble/preendgame_player.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <random>
+#include <thread>
+
+#include "glog/logging.h"
+#include "src/scrabble/tile_ordering.h"
+
+constexpr int PreendgamePlayer::kMaxBagTiles;
+constexpr int PreendgamePlayer::kDefaultPlaysConsidered;
+constexpr int PreendgamePlayer::kDefaultRestOrderings;
+constexpr int PreendgamePlayer::kMaxPlayoutsPerSplit;
+
+namespace {
+double Choose(int n, int k) {
+  double ret = 1.0;
+  for (int i = 0; i < k; ++i) {
+    ret = ret * (n - i) / (i + 1);
+  }
+  return ret;
+}
+
+void ForEachSubsetFrom(
+    const std::array<int, 32>& counts, int letter, int size,
+    double multiplicity, std::array<int, 32>* subset,
+    const std::function<void(const std::array<int, 32>&, double)>& fn) {
+  if (size == 0) {
+    fn(*subset, multiplicity);
+    return;
+  }
+  if (letter == counts.size()) {
+    return;
+  }
+  for (int n = std::min(size, counts[letter]); n >= 0; --n) {
+    (*subset)[letter] = n;
+    ForEachSubsetFrom(counts, letter + 1, size - n,
+                      multiplicity * Choose(counts[letter], n), subset, fn);
+  }
+  (*subset)[letter] = 0;
+}
+
+LetterString ToLetters(const std::array<int, 32>& counts) {
+  LetterString letters;
+  for (int letter = 0; letter < counts.size(); ++letter) {
+    for (int i = 0; i < counts[letter]; ++i) {
+      letters.push_back(letter);
+    }
+  }
+  return letters;
+}
+
+int SumCounts(const std::array<int, 32>& counts) {
+  int sum = 0;
+  for (const int count : counts) {
+    sum += count;
+  }
+  return sum;
+}
+
+// Number of distinct orderings of the tiles in counts.
+double NumOrderings(const std::array<int, 32>& counts) {
+  double ret = 1.0;
+  int num_tiles = 0;
+  for (const int count : counts) {
+    num_tiles += count;
+    ret *= Choose(num_tiles, count);
+  }
+  return ret;
+}
+
+std::array<int, 32> Difference(const std::array<int, 32>& counts,
+                               const std::array<int, 32>& subset) {
+  std::array<int, 32> ret;
+  for (int i = 0; i < counts.size(); ++i) {
+    ret[i] = counts[i] - subset[i];
+  }
+  return ret;
+}
+}  // namespace
+
+void PreendgamePlayer::ForEachSubset(
+    const std::array<int, 32>& counts, int size,
+    const std::function<void(const std::array<int, 32>&, double)>& fn) {
+  std::array<int, 32> subset = {0};
+  ForEachSubsetFrom(counts, 0, size, 1.0, &subset, fn);
+}
+
+std::vector<PreendgamePlayer::Deal> PreendgamePlayer::Deals(
+    const std::array<int, 32>& unseen, int num_drawn, int max_rest_orderings) {
+  const int num_unseen = SumCounts(unseen);
+  const int opp_rack_size = std::min(num_unseen, 7);
+  const int bag_size = num_unseen - opp_rack_size;
+  num_drawn = std::min(num_drawn, bag_size);
+  const double num_opp_racks = Choose(num_unseen, opp_rack_size);
+  const double num_draws = Choose(bag_size, num_drawn);
+  std::vector<Deal> deals;
+  int split_index = 0;
+  ForEachSubset(
+      unseen, opp_rack_size,
+      [&](const std::array<int, 32>& opp_rack, double opp_ways) {
+        const auto bag = Difference(unseen, opp_rack);
+        ForEachSubset(
+            bag, num_drawn,
+            [&](const std::array<int, 32>& draw, double draw_ways) {
+              const auto rest = Difference(bag, draw);
+              // Every ordering of the rest is equally likely, and decides
+              // what both players refill with after the candidate.
+              std::vector<LetterString> orderings;
+              LetterString ordering = ToLetters(rest);
+              if (max_rest_orderings == 0 ||
+                  NumOrderings(rest) <= max_rest_orderings) {
+                do {
+                  orderings.push_back(ordering);
+                } while (std::next_permutation(ordering.begin(),
+                                               ordering.end()));
+              } else {
+                std::seed_seq seed_seq = {
+                    static_cast<uint32_t>(split_index)};
+                std::mt19937_64 gen(seed_seq);
+                for (int i = 0; i < max_rest_orderings; ++i) {
+                  std::shuffle(ordering.begin(), ordering.end(), gen);
+                  orderings.push_back(ordering);
+                }
+              }
+              split_index++;
+              const double weight =
+                  (opp_ways / num_opp_racks) * (draw_ways / num_draws);
+              for (const auto& rest_ordering : orderings) {
+                Deal deal;
+                deal.opp_rack = ToLetters(opp_rack);
+                deal.draw = ToLetters(draw);
+                deal.rest = rest_ordering;
+                deal.weight = weight / orderings.size();
+                deals.push_back(deal);
+              }
+            });
+      });
+  return deals;
+}
+
+std::unique_ptr<PreendgamePlayer::RolloutWorker>
+PreendgamePlayer::CreateRolloutWorker(
+    const q2::proto::PreendgamePlayerConfig& config) const {
+  auto worker = absl::make_unique<RolloutWorker>();
+  std::vector<ComputerPlayer*> players;
+  for (int i = 0; i < 2; ++i) {
+    auto player =
+        ComponentFactory::CreatePlayerFromConfig(config.rollout_player());
+    CHECK(player != nullptr);
+    players.push_back(player.get());
+    worker->players.push_back(std::move(player));
+  }
+  worker->rollout = absl::make_unique<Rollout>(layout_, players, tiles_);
+  return worker;
+}
+
+uint64_t PreendgamePlayer::EndgameHash(const GamePosition& p,
+                                       bool root_player_on_turn) const {
+  // With the bag empty, every unseen tile is on the opponent's rack.
+  uint64_t hash = zobrist_.BoardHash(p.GetBoard()) ^
+                  zobrist_.RackHash(p.GetRack().Letters(), 0) ^
+                  zobrist_.RackHash(ToLetters(p.UnseenCounts()), 1);
+  if (root_player_on_turn) {
+    hash ^= zobrist_.Turn();
+  }
+  return hash;
+}
+
+float PreendgamePlayer::SpreadAfter(const GamePosition& position,
+                                    const Move& move, const Deal& deal,
+                                    Rollout* rollout) {
+  // The bag is drawn from the back: the opponent's rack, then the
+  // candidate's draw, then the rest.
+  std::vector<Letter> letters;
+  for (int i = deal.rest.size() - 1; i >= 0; --i) {
+    letters.push_back(deal.rest[i]);
+  }
+  for (const Letter letter : deal.draw) {
+    letters.push_back(letter);
+  }
+  for (const Letter letter : deal.opp_rack) {
+    letters.push_back(letter);
+  }
+  // The bag is too small for exchanges, so no dividends are needed.
+  const TileOrdering ordering(letters, {});
+  rollout->Reset(position, ordering, &root_crosses_);
+  rollout->AddNextPosition(move);
+  while (!rollout->Positions().back().IsGameOver() &&
+         rollout->Positions().back().NumUnseen() > 7) {
+    rollout->ContinueWithComputerPlayers(1);
+  }
+  const int endgame_ply = rollout->NumPlies();
+  float spread = 0.0;
+  for (int i = 1; i < endgame_ply; ++i) {
+    const int sign = (i % 2 == 0) ? 1 : -1;
+    spread += sign * rollout->Score(i);
+  }
+
+  // From here on the game depends only on the board and the racks, so
+  // endgames reached through different deals, candidates or move orders are
+  // only played out once. Positions after a scoreless turn aren't cached,
+  // since how many came before decides when the game ends.
+  const GamePosition& endgame = rollout->Positions().back();
+  const int endgame_sign = (endgame_ply % 2 == 0) ? 1 : -1;
+  const bool cacheable =
+      !endgame.IsGameOver() && endgame.ScorelessTurns() == 0;
+  uint64_t hash = 0;
+  if (cacheable) {
+    hash = EndgameHash(endgame, endgame_sign == 1);
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    const auto it = cache_.find(hash);
+    if (it != cache_.end()) {
+      return spread + endgame_sign * it->second;
+    }
+  }
+  rollout->ContinueWithComputerPlayers(std::numeric_limits<int>::max());
+  float endgame_spread = 0.0;
+  for (int i = endgame_ply; i < rollout->NumPlies(); ++i) {
+    const int sign = (i % 2 == 0) ? 1 : -1;
+    endgame_spread += sign * rollout->Score(i);
+  }
+  if (cacheable) {
+    // For the player on turn in the endgame.
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    cache_[hash] = endgame_sign * endgame_spread;
+  }
+  return spread + endgame_spread;
+}
+
+Move PreendgamePlayer::ChooseBestMove(
+    const std::vector<GamePosition>* previous_positions,
+    const GamePosition& pos) {
+  SetStartOfTurnTime();
+  move_finder_->FindMoves(pos.GetRack(), pos.GetBoard(), pos.NumUnseen(),
+                          MoveFinder::RecordBestK, true);
+  move_finder_->GetCrossesAndScores(&root_crosses_);
+  // Sorted by descending equity, and no longer than max_plays_considered_.
+  const std::vector<Move> candidates = move_finder_->Moves();
+  CHECK(!candidates.empty());
+  const int bag_size = pos.NumUnseen() - std::min(pos.NumUnseen(), 7);
+  if (bag_size > kMaxBagTiles) {
+    LOG(ERROR) << "PreendgamePlayer " << Name() << " called with " << bag_size
+               << " tiles in the bag, playing the best static move";
+    return candidates[0];
+  }
+  if (candidates.size() == 1) {
+    return candidates[0];
+  }
+
+  // Deals depend only on how many tiles a candidate draws.
+  std::array<std::vector<Deal>, 8> deals_by_num_drawn;
+  struct Item {
+    int candidate_index;
+    int deal_index;
+  };
+  std::vector<Item> items;
+  for (int c = 0; c < candidates.size(); ++c) {
+    const Move& move = candidates[c];
+    const int num_drawn =
+        (move.GetAction() == Move::Place) ? move.NumTiles() : 0;
+    auto& deals = deals_by_num_drawn[num_drawn];
+    if (deals.empty()) {
+      deals = Deals(pos.UnseenCounts(), num_drawn, max_rest_orderings_);
+    }
+    for (int d = 0; d < deals.size(); ++d) {
+      items.push_back({c, d});
+    }
+  }
+  LOG(INFO) << "PreendgamePlayer: " << candidates.size() << " candidates, "
+            << items.size() << " playouts";
+
+  std::vector<float> spreads(items.size());
+  const auto play_out = [&](int item_index, Rollout* rollout) {
+    const Item& item = items[item_index];
+    const Move& move = candidates[item.candidate_index];
+    const int num_drawn =
+        (move.GetAction() == Move::Place) ? move.NumTiles() : 0;
+    spreads[item_index] =
+        SpreadAfter(pos, move, deals_by_num_drawn[num_drawn][item.deal_index],
+                    rollout);
+  };
+  const int num_threads = rollout_workers_.size();
+  if (num_threads == 1) {
+    for (int i = 0; i < items.size(); ++i) {
+      play_out(i, rollout_workers_[0]->rollout.get());
+    }
+  } else {
+    std::atomic<int> next_item(0);
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (int t = 0; t < num_threads; ++t) {
+      Rollout* rollout = rollout_workers_[t]->rollout.get();
+      threads.emplace_back([&, rollout]() {
+        for (int i = next_item++; i < items.size(); i = next_item++) {
+          play_out(i, rollout);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+  LOG(INFO) << "PreendgamePlayer: " << cache_.size() << " distinct endgames";
+  cache_.clear();
+
+  // Added up in item order, so results don't depend on the number of
+  // threads.
+  std::vector<double> expected_spreads(candidates.size(), 0.0);
+  for (int i = 0; i < items.size(); ++i) {
+    const Item& item = items[i];
+    const Move& move = candidates[item.candidate_index];
+    const int num_drawn =
+        (move.GetAction() == Move::Place) ? move.NumTiles() : 0;
+    const Deal& deal = deals_by_num_drawn[num_drawn][item.deal_index];
+    expected_spreads[item.candidate_index] +=
+        deal.weight * (move.Score() + spreads[i]);
+  }
+  int best_index = 0;
+  for (int c = 0; c < candidates.size(); ++c) {
+    std::stringstream ss;
+    candidates[c].Display(tiles_, ss);
+    LOG(INFO) << "preendgame move: " << ss.str()
+              << " spread: " << expected_spreads[c];
+    if (expected_spreads[c] > expected_spreads[best_index]) {
+      best_index = c;
+    }
+  }
+  return candidates[best_index];
+}
@@ -0,0 +1,145 @@
+#ifndef SRC_SCRABBLE_PREENDGAME_PLAYER_H
+#define SRC_SCRABBLE_PREENDGAME_PLAYER_H
+
+#include <array>
+#include <functional>
+#include <mutex>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
+#include "src/scrabble/board_layout.h"
+#include "src/scrabble/component_factory.h"
+#include "src/scrabble/computer_player.h"
+#include "src/scrabble/computer_players.pb.h"
+#include "src/scrabble/data_manager.h"
+#include "src/scrabble/game_position.h"
+#include "src/scrabble/move.h"
+#include "src/scrabble/move_finder.h"
+#include "src/scrabble/rollout.h"
+#include "src/scrabble/zobrist.h"
+
+// Chooses moves with 1-6 tiles in the bag. Instead of simming random tile
+// orderings, every candidate is played out once for each distinct deal of
+// the unseen tiles (the opponent's rack, what the candidate draws, and the
+// order of the rest of the bag), and deals are weighted by how likely they
+// are. The rollout player decides the rest of the game for both sides, so
+// with an EndgamePlayer or AlphaBetaPlayer for empty-bag positions, every
+// deal that empties the bag is solved as an endgame.
+class PreendgamePlayer : public ComputerPlayer {
+ public:
+  static constexpr int kMaxBagTiles = 6;
+  // Used when max_plays_considered or max_rest_orderings is 0.
+  static constexpr int kDefaultPlaysConsidered = 20;
+  static constexpr int kDefaultRestOrderings = 24;
+  // Bound on max_plays_considered * max_rest_orderings, the playouts for
+  // each opponent rack and draw.
+  static constexpr int kMaxPlayoutsPerSplit = 2000;
+
+  struct Deal {
+    LetterString opp_rack;
+    LetterString draw;
+    // In the order the tiles would be drawn.
+    LetterString rest;
+    // Probability of the deal, given the tiles the player can see.
+    double weight;
+  };
+
+  static void Register() {
+    LOG(INFO) << "Registering PreendgamePlayer";
+    ComponentFactory::GetInstance()->RegisterComputerPlayer(
+        q2::proto::PreendgamePlayerConfig::descriptor(),
+        [](const google::protobuf::Message& message) {
+          return absl::make_unique<PreendgamePlayer>(
+              dynamic_cast<const q2::proto::PreendgamePlayerConfig&>(message));
+        });
+  }
+
+  explicit PreendgamePlayer(const q2::proto::PreendgamePlayerConfig& config)
+      : ComputerPlayer(config.name(), config.nickname(), config.id()),
+        layout_(*DataManager::GetInstance()->GetBoardLayout(
+            config.board_layout_file())),
+        tiles_(*DataManager::GetInstance()->GetTiles(config.tiles_file())),
+        max_plays_considered_((config.max_plays_considered() == 0)
+                                  ? kDefaultPlaysConsidered
+                                  : config.max_plays_considered()),
+        max_rest_orderings_((config.max_rest_orderings() == 0)
+                                ? kDefaultRestOrderings
+                                : config.max_rest_orderings()) {
+    CHECK_GT(max_plays_considered_, 0);
+    CHECK_GT(max_rest_orderings_, 0);
+    CHECK_LE(max_plays_considered_ * max_rest_orderings_, kMaxPlayoutsPerSplit)
+        << "PreendgamePlayer " << config.name()
+        << ": max_plays_considered * max_rest_orderings is too large";
+    move_finder_ = absl::make_unique<MoveFinder>(
+        *DataManager::GetInstance()->GetAnagramMap(config.anagram_map_file()),
+        layout_, tiles_,
+        *DataManager::GetInstance()->GetLeaves(config.leaves_file()));
+    move_finder_->SetBestK(max_plays_considered_);
+    move_finder_->SetNumThreads(std::max(1, config.move_finder_threads()));
+    move_finder_->SetRackTable(
+        DataManager::GetInstance()->GetRackTable(config.rack_table_file()));
+    const int rollout_threads = std::max(1, config.rollout_threads());
+    for (int i = 0; i < rollout_threads; ++i) {
+      rollout_workers_.push_back(CreateRolloutWorker(config));
+    }
+  }
+
+  Move ChooseBestMove(const std::vector<GamePosition>* previous_positions,
+                      const GamePosition& position) override;
+
+  // Every distinct deal of unseen (counts by letter) after a candidate that
+  // draws num_drawn tiles, with the opponent holding min(7, unseen) of them.
+  // Each opponent rack and draw comes with every distinct ordering of the
+  // rest, or with max_rest_orderings of them shuffled from a fixed seed if
+  // there are more (0 is all of them). Weights add up to 1.
+  static std::vector<Deal> Deals(const std::array<int, 32>& unseen,
+                                 int num_drawn, int max_rest_orderings);
+
+ private:
+  // Calls fn(subset, multiplicity) for each distinct multiset of size tiles
+  // from counts, where multiplicity is the number of ways of picking it out
+  // of the individual tiles.
+  static void ForEachSubset(
+      const std::array<int, 32>& counts, int size,
+      const std::function<void(const std::array<int, 32>&, double)>& fn);
+
+  struct RolloutWorker {
+    std::vector<std::unique_ptr<ComputerPlayer>> players;
+    std::unique_ptr<Rollout> rollout;
+  };
+  std::unique_ptr<RolloutWorker> CreateRolloutWorker(
+      const q2::proto::PreendgamePlayerConfig& config) const;
+
+  // Hash of p, a position with the bag empty reached in a playout, from its
+  // board, both racks and the side to move.
+  uint64_t EndgameHash(const GamePosition& p, bool root_player_on_turn) const;
+
+  // Spread of the rest of the game after move is played from position and
+  // the tiles are dealt as in deal, for the player of move. The game from
+  // the first position with the bag empty on is looked up in cache_, and
+  // added to it if it isn't there.
+  float SpreadAfter(const GamePosition& position, const Move& move,
+                    const Deal& deal, Rollout* rollout);
+
+  const BoardLayout& layout_;
+  const Tiles& tiles_;
+  int max_plays_considered_;
+  int max_rest_orderings_;
+  std::unique_ptr<MoveFinder> move_finder_;
+  const Zobrist zobrist_;
+
+  // Crosses and scores of the position passed to ChooseBestMove(...), which
+  // every rollout starts from.
+  CrossesAndScores root_crosses_;
+
+  // Spreads of the rest of the game from positions with the bag empty, for
+  // the player on turn, keyed by EndgameHash(...). Shared by every deal and
+  // candidate of the current move.
+  std::mutex cache_mutex_;
+  absl::flat_hash_map<uint64_t, float> cache_;
+
+  // One per rollout thread.
+  std::vector<std::unique_ptr<RolloutWorker>> rollout_workers_;
+};
+
+#endif  // SRC_SCRABBLE_PREENDGAME_PLAYER_H
@@ -0,0 +1,273 @@
+#include "src/scrabble/preendgame_player.h"
+
+#include <google/protobuf/text_format.h>
+
+#include "absl/memory/memory.h"
+#include "glog/logging.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/scrabble/component_factory.h"
+#include "src/scrabble/computer_player.h"
+#include "src/scrabble/computer_players.pb.h"
+#include "src/scrabble/endgame_player.h"
+#include "src/scrabble/specializing_player.h"
+#include "src/scrabble/static_player.h"
+#include "src/scrabble/unseen_tiles_predicate.h"
+
+using ::google::protobuf::Arena;
+
+class PreendgamePlayerTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    EndgamePlayer::Register();
+    PreendgamePlayer::Register();
+    SpecializingPlayer::Register();
+    StaticPlayer::Register();
+    UnseenTilesPredicate::Register();
+    DataManager* dm = DataManager::GetInstance();
+    Arena arena;
+    auto spec = Arena::CreateMessage<q2::proto::DataCollection>(&arena);
+    google::protobuf::TextFormat::ParseFromString(R"(
+      tiles_files: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+      board_files: "src/scrabble/testdata/scrabble_board.textproto"
+      anagram_map_file_specs {
+          anagram_map_filename: "src/scrabble/testdata/csw21.qam"
+          tiles_filename: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+      }
+      leaves_file_specs {
+          leaves_filename: "src/scrabble/testdata/csw_scrabble_macondo.qlv"
+          tiles_filename: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+      }
+    )",
+                                                  spec);
+    dm->LoadData(*spec);
+  }
+
+  std::array<int, 32> Counts(const std::string& letters) {
+    const Tiles* tiles = DataManager::GetInstance()->GetTiles(
+        "src/scrabble/testdata/english_scrabble_tiles.textproto");
+    std::array<int, 32> counts = {0};
+    for (const Letter letter : tiles->ToLetterString(letters).value()) {
+      counts[letter]++;
+    }
+    return counts;
+  }
+
+  std::string ToString(const LetterString& letters) {
+    const Tiles* tiles = DataManager::GetInstance()->GetTiles(
+        "src/scrabble/testdata/english_scrabble_tiles.textproto");
+    return tiles->ToString(letters).value();
+  }
+
+  void ExpectMove(const Move& move, const std::string& expected) {
+    const Tiles* tiles = DataManager::GetInstance()->GetTiles(
+        "src/scrabble/testdata/english_scrabble_tiles.textproto");
+    std::stringstream ss;
+    move.Display(*tiles, ss);
+    const auto actual = ss.str();
+    EXPECT_EQ(actual, expected);
+  }
+};
+
+TEST_F(PreendgamePlayerTest, OneInTheBag) {
+  const auto deals = PreendgamePlayer::Deals(Counts("AAABBBBB"), 1, 0);
+  ASSERT_EQ(deals.size(), 2);
+  EXPECT_EQ(ToString(deals[0].opp_rack), "AAABBBB");
+  EXPECT_EQ(ToString(deals[0].draw), "B");
+  EXPECT_EQ(ToString(deals[0].rest), "");
+  EXPECT_DOUBLE_EQ(deals[0].weight, 5.0 / 8);
+  EXPECT_EQ(ToString(deals[1].opp_rack), "AABBBBB");
+  EXPECT_EQ(ToString(deals[1].draw), "A");
+  EXPECT_DOUBLE_EQ(deals[1].weight, 3.0 / 8);
+
+  // Passing draws nothing.
+  const auto pass_deals = PreendgamePlayer::Deals(Counts("AAABBBBB"), 0, 0);
+  ASSERT_EQ(pass_deals.size(), 2);
+  EXPECT_EQ(ToString(pass_deals[0].draw), "");
+  EXPECT_EQ(ToString(pass_deals[0].rest), "B");
+}
+
+TEST_F(PreendgamePlayerTest, TwoInTheBag) {
+  // Opponent racks AAAABBB (10 ways), AAABBBB (20) and AABBBBB (6) out of
+  // 36, and drawing either tile of AB.
+  const auto deals = PreendgamePlayer::Deals(Counts("AAAABBBBB"), 1, 0);
+  ASSERT_EQ(deals.size(), 4);
+  EXPECT_EQ(ToString(deals[0].opp_rack), "AAAABBB");
+  EXPECT_EQ(ToString(deals[0].draw), "B");
+  EXPECT_EQ(ToString(deals[0].rest), "B");
+  EXPECT_DOUBLE_EQ(deals[0].weight, 10.0 / 36);
+  EXPECT_EQ(ToString(deals[1].opp_rack), "AAABBBB");
+  EXPECT_EQ(ToString(deals[1].draw), "A");
+  EXPECT_EQ(ToString(deals[1].rest), "B");
+  EXPECT_DOUBLE_EQ(deals[1].weight, 10.0 / 36);
+  EXPECT_EQ(ToString(deals[2].draw), "B");
+  EXPECT_EQ(ToString(deals[2].rest), "A");
+  EXPECT_DOUBLE_EQ(deals[2].weight, 10.0 / 36);
+  EXPECT_EQ(ToString(deals[3].opp_rack), "AABBBBB");
+  EXPECT_DOUBLE_EQ(deals[3].weight, 6.0 / 36);
+
+  // Playing out draws the whole bag.
+  const auto out_deals = PreendgamePlayer::Deals(Counts("AAAABBBBB"), 5, 0);
+  ASSERT_EQ(out_deals.size(), 3);
+  EXPECT_EQ(ToString(out_deals[1].draw), "AB");
+  EXPECT_EQ(ToString(out_deals[1].rest), "");
+}
+
+TEST_F(PreendgamePlayerTest, RestOrderings) {
+  // Opponent racks AAAAAAA (1 way), AAAAAAB (7), AAAAAAC (7) and AAAAABC
+  // (21) out of 36. After a pass the opponent refills from the front of the
+  // rest, so behind AAAAAAA they draw B or C first, each half the time.
+  const auto deals = PreendgamePlayer::Deals(Counts("AAAAAAABC"), 0, 0);
+  ASSERT_EQ(deals.size(), 7);
+  EXPECT_EQ(ToString(deals[0].opp_rack), "AAAAAAA");
+  EXPECT_EQ(ToString(deals[0].rest), "BC");
+  EXPECT_DOUBLE_EQ(deals[0].weight, 1.0 / 72);
+  EXPECT_EQ(ToString(deals[1].opp_rack), "AAAAAAA");
+  EXPECT_EQ(ToString(deals[1].rest), "CB");
+  EXPECT_DOUBLE_EQ(deals[1].weight, 1.0 / 72);
+  EXPECT_EQ(ToString(deals[2].opp_rack), "AAAAAAB");
+  EXPECT_EQ(ToString(deals[2].rest), "AC");
+  EXPECT_DOUBLE_EQ(deals[2].weight, 7.0 / 72);
+  EXPECT_EQ(ToString(deals[3].rest), "CA");
+  EXPECT_DOUBLE_EQ(deals[3].weight, 7.0 / 72);
+  EXPECT_EQ(ToString(deals[6].opp_rack), "AAAAABC");
+  EXPECT_EQ(ToString(deals[6].rest), "AA");
+  EXPECT_DOUBLE_EQ(deals[6].weight, 21.0 / 36);
+
+  // With fewer orderings allowed than there are, the ones kept share the
+  // weight and are the same from call to call.
+  const auto capped_deals = PreendgamePlayer::Deals(Counts("AAAAAAABC"), 0, 1);
+  ASSERT_EQ(capped_deals.size(), 4);
+  double total_weight = 0.0;
+  for (const auto& deal : capped_deals) {
+    total_weight += deal.weight;
+  }
+  EXPECT_DOUBLE_EQ(total_weight, 1.0);
+  EXPECT_DOUBLE_EQ(capped_deals[0].weight, 1.0 / 36);
+  const auto again = PreendgamePlayer::Deals(Counts("AAAAAAABC"), 0, 1);
+  for (int i = 0; i < capped_deals.size(); ++i) {
+    EXPECT_EQ(capped_deals[i].rest, again[i].rest);
+  }
+}
+
+TEST_F(PreendgamePlayerTest, Ming) {
+  // The Ming endgame from EndgamePlayerTest with the M at O8 back in the
+  // bag, so the opponent holds 7 of ADIMNRSY and column O is open. O8
+  // MILDING scores the most, but O6 comes out ahead once the rest of the
+  // game is played out.
+  Arena arena;
+  auto config =
+      Arena::CreateMessage<q2::proto::SpecializingPlayerConfig>(&arena);
+  google::protobuf::TextFormat::ParseFromString(R"(
+        id: 1
+        name: "Preendgame"
+        nickname: "P"
+        conditional_players {
+            predicate {
+                unseen_tiles_predicate_config {
+                    min_unseen_tiles: 8
+                    max_unseen_tiles: 13
+                }
+            }
+            player {
+                preendgame_player_config {
+                    id: 2
+                    name: "Preendgame"
+                    nickname: "P"
+                    anagram_map_file: "src/scrabble/testdata/csw21.qam"
+                    board_layout_file: "src/scrabble/testdata/scrabble_board.textproto"
+                    tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+                    leaves_file: "src/scrabble/testdata/csw_scrabble_macondo.qlv"
+                    max_plays_considered: 4
+                    rollout_threads: 2
+                    rollout_player {
+                        specializing_player_config {
+                            id: 3
+                            name: "Rollout"
+                            nickname: "R"
+                            conditional_players {
+                                predicate {
+                                    unseen_tiles_predicate_config {
+                                        min_unseen_tiles: 0
+                                        max_unseen_tiles: 7
+                                    }
+                                }
+                                player {
+                                    endgame_player_config {
+                                        id: 4
+                                        name: "Endgame"
+                                        nickname: "E"
+                                        anagram_map_file: "src/scrabble/testdata/csw21.qam"
+                                        board_layout_file: "src/scrabble/testdata/scrabble_board.textproto"
+                                        tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+                                        leaves_file: "src/scrabble/testdata/csw_scrabble_macondo.qlv"
+                                        plies: 1
+                                        leave_score_weight: 1.7
+                                        leave_value_weight: 0.3
+                                        caps_per_ply: 20
+                                        caps_per_ply: 20
+                                    }
+                                }
+                            }
+                            conditional_players {
+                                predicate {
+                                    unseen_tiles_predicate_config {
+                                        min_unseen_tiles: 8
+                                        max_unseen_tiles: 100
+                                    }
+                                }
+                                player {
+                                    static_player_config {
+                                        id: 5
+                                        name: "Static"
+                                        nickname: "S"
+                                        anagram_map_file: "src/scrabble/testdata/csw21.qam"
+                                        board_layout_file: "src/scrabble/testdata/scrabble_board.textproto"
+                                        tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+                                        leaves_file: "src/scrabble/testdata/csw_scrabble_macondo.qlv"
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        )",
+                                                config);
+  auto player = absl::make_unique<SpecializingPlayer>(*config);
+
+  DataManager* dm = DataManager::GetInstance();
+  const Tiles* tiles =
+      dm->GetTiles("src/scrabble/testdata/english_scrabble_tiles.textproto");
+  Board board;
+  board.SetLetters(
+      {R"(   A B C D E F G H I J K L M N O   -> olaugh     IIDGLMN   395)",
+       R"(   ------------------------------     cwac       ADINRSY   448)",
+       R"( 1|P     '       F E R N L E s S| --Speedy Player's choices---)",
+       R"( 2|A -       B O U N "       -  | best  12L MING   26 IDL)",
+       R"( 3|T W O C K E R S '   J   -    |  4.00 12L MILD   26 IGN)",
+       R"( 4|I     O E     C     O F     '|  5.00 12L DING   22 ILM)",
+       R"( 5|O     L A           T O      |  8.00 12L MIND   26 IGL)",
+       R"( 6|  "   L   " Q     P A H   "  |  13.0 12L LING   18 IDM)",
+       R"( 7|    ' I     A   ' H   N '    |  27.0 12L DIG    16 ILMN)",
+       R"( 8|I G A D     T A X I   S O W  |  29.0 12L LIND   18 IGM)",
+       R"( 9|  A Y E     ' T I Z     '    |  39.0 O7  M(M)   6  IIDGLN)",
+       R"(10|  N E R V U R E   "       "  |  40.0 O8  (M)M   6  IIDGLN)",
+       R"(11|        - R E s T I V E      |  46.0 O6  LI(M)N 6  IDGM)",
+       R"(12|B O U T A D E '       -     '| --Tracking------------------)",
+       R"(13|E U G E     '   '       -    | ADINRSY  7)",
+       R"(14|  -       "       "       -  |)",
+       R"(15|=     '       =       '     =|)",
+       R"(   ------------------------------)"},
+      *tiles);
+  const BoardLayout* layout =
+      dm->GetBoardLayout("src/scrabble/testdata/scrabble_board.textproto");
+  const Rack rack(tiles->ToLetterString("MILDING").value());
+  auto pos = absl::make_unique<GamePosition>(
+      *layout, board, 1, 2, rack, 395, 448, 0, 0, absl::Minutes(25), 0, *tiles);
+  ASSERT_EQ(pos->NumUnseen(), 8);
+  auto* computer_player = static_cast<ComputerPlayer*>(player.get());
+  const auto move = computer_player->ChooseBestMove(nullptr, *pos);
+  ExpectMove(move, "O6 MILDING (score = 110)");
+}
@@ -0,0 +1,120 @@
+#include "src/scrabble/rollout.h"
+
+#include "glog/logging.h"
+
+Rollout::Rollout(const BoardLayout& layout,
+                 const std::vector<ComputerPlayer*>& players,
+                 const Tiles& tiles)
+    : layout_(layout),
+      players_(players),
+      tiles_(tiles),
+      bag_(tiles, {}),
+      exchange_dividend_index_(0),
+      on_turn_rack_(LetterString()),
+      opp_rack_(LetterString()) {
+  CHECK_EQ(players_.size(), 2);
+  positions_.reserve(30);
+  plies_.reserve(30);
+}
+
+void Rollout::Reset(const GamePosition& root, const TileOrdering& ordering,
+                    const CrossesAndScores* root_crosses) {
+  positions_.clear();
+  plies_.clear();
+  bag_.SetLetters(ordering.Letters());
+  exchange_insertion_dividends_.assign(
+      ordering.ExchangeInsertionDividends().begin(),
+      ordering.ExchangeInsertionDividends().end());
+  exchange_dividend_index_ = 0;
+  on_turn_rack_ = root.GetRack();
+  opp_rack_.Clear();
+  bag_.CompleteRack(&opp_rack_);
+  for (auto* player : players_) {
+    player->ResetGameState();
+    if (root_crosses != nullptr) {
+      player->SetRootCrossesAndScores(*root_crosses);
+    }
+  }
+  positions_.push_back(root);
+}
+
+void Rollout::AddNextPosition(const Move& move) {
+  CHECK(!positions_.empty());
+  GamePosition& last = positions_.back();
+  last.CommitMove(move, absl::ZeroDuration());
+  plies_.push_back(
+      {move.Score(), move.HasEquity() ? static_cast<float>(move.Equity())
+                                      : static_cast<float>(move.Score())});
+  Board board = last.GetBoard();
+  if (move.GetAction() == Move::Place) {
+    board.UnsafePlaceMove(move);
+  }
+  const std::array<int, 32> unseen_counts =
+      last.NextUnseenCounts(move, opp_rack_);
+  int scoreless_turns = 0;
+  // No bag manipulation is needed for deadwood.
+  if (move.GetAction() == Move::Exchange || move.GetAction() == Move::Place) {
+    on_turn_rack_.RemoveTiles(move.Letters(), tiles_);
+    bag_.CompleteRack(&on_turn_rack_);
+    if (move.GetAction() == Move::Exchange) {
+      bag_.InsertTiles(move.Letters(), exchange_insertion_dividends_,
+                       &exchange_dividend_index_);
+    }
+    if (last.IsScorelessTurn()) {
+      scoreless_turns = last.ScorelessTurns() + 1;
+    }
+  }
+  const int on_turn_player_id = last.OpponentPlayerId();
+  const int opponent_player_id = last.OnTurnPlayerId();
+  const int player_score = last.OpponentScore();
+  const int opponent_score = last.PlayerScore() + move.Score();
+  const int position_index = last.PositionIndex() + 1;
+  const int game_index = last.GameIndex();
+  const absl::Duration time_remaining = last.TimeRemainingStart();
+  // last may be invalidated from here on.
+  positions_.emplace_back(layout_, board, on_turn_player_id,
+                          opponent_player_id, opp_rack_, player_score,
+                          opponent_score, position_index, game_index,
+                          time_remaining, scoreless_turns, tiles_,
+                          unseen_counts);
+  std::swap(on_turn_rack_, opp_rack_);
+}
+
+void Rollout::AdjustGameEndScores() {
+  CHECK(positions_.back().IsGameOver());
+  if (positions_.back().ScorelessTurns() >= 6) {
+    for (int i = 0; i < 2; i++) {
+      const LetterString letters = positions_.back().GetRack().Letters();
+      const int penalty = -1 * tiles_.Score(letters);
+      const Move move(Move::OwnDeadwoodPenalty, letters, penalty);
+      AddNextPosition(move);
+    }
+  } else {
+    // The on-turn player is stuck with tiles; they pass and the player who
+    // went out gets the bonus.
+    const LetterString letters = positions_.back().GetRack().Letters();
+    const LetterString empty;
+    const Move pass(Move::Exchange, empty, 0);
+    AddNextPosition(pass);
+    const int bonus = 2 * tiles_.Score(letters);
+    const Move move(Move::OppDeadwoodBonus, letters, bonus);
+    AddNextPosition(move);
+  }
+}
+
+void Rollout::ContinueWithComputerPlayers(int plies) {
+  CHECK(!positions_.empty());
+  CHECK_GT(plies, 0);
+  int plies_done = 0;
+  while (!positions_.back().IsGameOver()) {
+    const int player_index = positions_.back().PositionIndex() % 2;
+    const auto move =
+        players_[player_index]->ChooseBestMove(&positions_, positions_.back());
+    AddNextPosition(move);
+    plies_done++;
+    if (plies_done == plies) {
+      return;
+    }
+  }
+  AdjustGameEndScores();
+}
@@ -0,0 +1,74 @@
+#ifndef SRC_SCRABBLE_ROLLOUT_H
+#define SRC_SCRABBLE_ROLLOUT_H
+
+#include <vector>
+
+#include "src/scrabble/bag.h"
+#include "src/scrabble/board_layout.h"
+#include "src/scrabble/computer_player.h"
+#include "src/scrabble/game_position.h"
+#include "src/scrabble/move.h"
+#include "src/scrabble/move_finder.h"
+#include "src/scrabble/rack.h"
+#include "src/scrabble/tile_ordering.h"
+#include "src/scrabble/tiles.h"
+
+// A Game stripped down for sim rollouts. It is built once per simming player
+// and Reset(...) in place for each iteration, reusing its buffers. Moves are
+// chosen and applied exactly as in Game::ContinueWithComputerPlayers(...),
+// but no clock is kept, no bag or rack history is recorded, and there is no
+// per-game random generator since the ordering determines every draw.
+// Positions are still kept for the current rollout because ComputerPlayers
+// read them, but they are cleared (not freed) on Reset(...).
+class Rollout {
+ public:
+  // Players are in turn order, as in Game, and are not owned.
+  Rollout(const BoardLayout& layout,
+          const std::vector<ComputerPlayer*>& players, const Tiles& tiles);
+
+  // Starts a new rollout from root, with the bag drawn in the order of
+  // ordering (already adjusted for tiles the on-turn player can see). If
+  // given, root_crosses are the crosses and scores of root's board, and are
+  // copied into the players instead of each rescanning the board.
+  void Reset(const GamePosition& root, const TileOrdering& ordering,
+             const CrossesAndScores* root_crosses = nullptr);
+
+  void AddNextPosition(const Move& move);
+
+  // Plays up to plies more moves, adjusting scores as in
+  // Game::AdjustGameEndScores() if the game ends.
+  void ContinueWithComputerPlayers(int plies);
+
+  // Per-ply results of the moves played so far, starting at the root. Game
+  // end adjustments have no equity of their own, so it is their score.
+  int NumPlies() const { return plies_.size(); }
+  int Score(int ply) const { return plies_[ply].score; }
+  float Equity(int ply) const { return plies_[ply].equity; }
+
+  const std::vector<GamePosition>& Positions() const { return positions_; }
+
+ private:
+  struct Ply {
+    int score;
+    float equity;
+  };
+
+  void AdjustGameEndScores();
+
+  const BoardLayout& layout_;
+  const std::vector<ComputerPlayer*> players_;
+  const Tiles& tiles_;
+
+  std::vector<GamePosition> positions_;
+  std::vector<Ply> plies_;
+
+  Bag bag_;
+  std::vector<uint16_t> exchange_insertion_dividends_;
+  std::size_t exchange_dividend_index_;
+
+  // Racks of the on-turn player and their opponent in positions_.back().
+  Rack on_turn_rack_;
+  Rack opp_rack_;
+};
+
+#endif  // SRC_SCRABBLE_ROLLOUT_H
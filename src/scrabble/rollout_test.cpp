@@ -0,0 +1,143 @@
+#include "src/scrabble/rollout.h"
+
+#include "absl/memory/memory.h"
+#include "absl/random/random.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/anagram/anagram_map.h"
+#include "src/leaves/leaves.h"
+#include "src/scrabble/board_layout.h"
+#include "src/scrabble/game.h"
+#include "src/scrabble/static_player.h"
+#include "src/scrabble/tiles.h"
+
+std::unique_ptr<Tiles> tiles_;
+std::unique_ptr<Leaves> leaves_;
+std::unique_ptr<AnagramMap> anagram_map_;
+std::unique_ptr<BoardLayout> layout_;
+
+bool SameMove(const Move& a, const Move& b) {
+  if (a.GetAction() != b.GetAction() || a.Letters() != b.Letters()) {
+    return false;
+  }
+  return a.GetAction() != Move::Place ||
+         (a.StartRow() == b.StartRow() && a.StartCol() == b.StartCol() &&
+          a.Direction() == b.Direction());
+}
+
+class RolloutTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    tiles_ = absl::make_unique<Tiles>(
+        "src/scrabble/testdata/english_scrabble_tiles.textproto");
+    anagram_map_ = AnagramMap::CreateFromBinaryFile(
+        *tiles_, "src/scrabble/testdata/csw21.qam");
+    layout_ = absl::make_unique<BoardLayout>(
+        "src/scrabble/testdata/scrabble_board.textproto");
+    leaves_ = Leaves::CreateFromBinaryFile(
+        *tiles_, "src/scrabble/testdata/csw_scrabble_macondo.qlv");
+  }
+};
+
+// A reused Rollout plays the same moves as a fresh Game from each ordering.
+TEST_F(RolloutTest, MatchesGame) {
+  StaticPlayer a(1, *anagram_map_, *layout_, *tiles_, *leaves_);
+  StaticPlayer b(2, *anagram_map_, *layout_, *tiles_, *leaves_);
+  const std::vector<Player*> game_players = {&a, &b};
+  Rollout rollout(*layout_, {&a, &b}, *tiles_);
+
+  Board board;
+  const Rack rack(tiles_->ToLetterString("QUACKUM").value());
+  const GamePosition root(*layout_, board, 1, 2, rack, 0, 0, 0, 0,
+                          absl::Minutes(25), 0, *tiles_);
+  const auto quack = Move::Parse("8D QUACK", *tiles_);
+  Move move = quack.value();
+  move.SetScore(42);
+  move.SetEquity(30.5);
+
+  absl::BitGen gen;
+  const Bag full_bag(*tiles_);
+  for (const int plies : {2, 4, 200}) {
+    const TileOrdering ordering =
+        TileOrdering(*tiles_, gen, 100).Adjust(root.SeenByPlayer());
+    Game game(*layout_, root, game_players, *tiles_, ordering);
+    game.AddNextPosition(move, absl::ZeroDuration());
+    game.ContinueWithComputerPlayers(plies);
+
+    rollout.Reset(root, ordering);
+    rollout.AddNextPosition(move);
+    rollout.ContinueWithComputerPlayers(plies);
+
+    EXPECT_FLOAT_EQ(rollout.Equity(0), 30.5);
+    ASSERT_EQ(rollout.Positions().size(), rollout.NumPlies() + 1);
+    for (int i = 0; i < rollout.NumPlies(); ++i) {
+      const auto& position = rollout.Positions()[i + 1];
+      const Bag unseen =
+          full_bag.UnseenToPlayer(position.GetBoard(), position.GetRack());
+      EXPECT_EQ(position.NumUnseen(), unseen.Size()) << plies << " " << i;
+    }
+    if (plies < 200) {
+      EXPECT_EQ(rollout.NumPlies(), plies + 1);
+    } else {
+      EXPECT_TRUE(rollout.Positions().back().IsGameOver());
+    }
+
+    ASSERT_EQ(rollout.NumPlies(), game.Positions().size() - 1) << plies;
+    for (int i = 0; i < rollout.NumPlies(); ++i) {
+      const auto& game_move = game.Positions()[i].GetMove();
+      ASSERT_TRUE(game_move.has_value());
+      EXPECT_EQ(rollout.Positions()[i].GetRack().Letters(),
+                game.Positions()[i].GetRack().Letters());
+      EXPECT_TRUE(SameMove(*rollout.Positions()[i].GetMove(), *game_move))
+          << plies << " " << i;
+      EXPECT_EQ(rollout.Score(i), game_move->Score());
+      EXPECT_EQ(rollout.Positions()[i + 1].PlayerScore(),
+                game.Positions()[i + 1].PlayerScore());
+    }
+  }
+}
+
+// Players given the root's crosses play the same moves as players that scan
+// the root board themselves.
+TEST_F(RolloutTest, RootCrossesAndScores) {
+  StaticPlayer a(1, *anagram_map_, *layout_, *tiles_, *leaves_);
+  StaticPlayer b(2, *anagram_map_, *layout_, *tiles_, *leaves_);
+  StaticPlayer c(1, *anagram_map_, *layout_, *tiles_, *leaves_);
+  StaticPlayer d(2, *anagram_map_, *layout_, *tiles_, *leaves_);
+  Rollout scanning(*layout_, {&a, &b}, *tiles_);
+  Rollout seeded(*layout_, {&c, &d}, *tiles_);
+
+  Board board;
+  const Rack rack(tiles_->ToLetterString("QUACKUM").value());
+  const GamePosition start(*layout_, board, 1, 2, rack, 0, 0, 0, 0,
+                           absl::Minutes(25), 0, *tiles_);
+  absl::BitGen gen;
+  scanning.Reset(start, TileOrdering(*tiles_, gen, 100).Adjust(
+                            start.SeenByPlayer()));
+  scanning.ContinueWithComputerPlayers(6);
+  ASSERT_EQ(scanning.NumPlies(), 6);
+  const GamePosition root = scanning.Positions().back();
+  ASSERT_FALSE(root.GetBoard().IsEmpty());
+
+  MoveFinder move_finder(*anagram_map_, *layout_, *tiles_, *leaves_);
+  move_finder.CacheCrossesAndScores(root.GetBoard());
+  CrossesAndScores root_crosses;
+  move_finder.GetCrossesAndScores(&root_crosses);
+
+  for (int i = 0; i < 5; ++i) {
+    const TileOrdering ordering =
+        TileOrdering(*tiles_, gen, 100).Adjust(root.SeenByPlayer());
+    scanning.Reset(root, ordering);
+    scanning.ContinueWithComputerPlayers(200);
+    seeded.Reset(root, ordering, &root_crosses);
+    seeded.ContinueWithComputerPlayers(200);
+    ASSERT_EQ(seeded.NumPlies(), scanning.NumPlies());
+    for (int ply = 0; ply < seeded.NumPlies(); ++ply) {
+      EXPECT_TRUE(SameMove(*seeded.Positions()[ply].GetMove(),
+                           *scanning.Positions()[ply].GetMove()))
+          << i << " " << ply;
+      EXPECT_EQ(seeded.Score(ply), scanning.Score(ply));
+    }
+  }
+}
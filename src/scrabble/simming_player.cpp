@@ -1,5 +1,10 @@
 #include "src/scrabble/simming_player.h"
 
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
 #include "src/scrabble/data_manager.h"
 #include "src/scrabble/game.h"
 #include "src/scrabble/move_finder.h"
@@ -12,31 +17,10 @@ Move SimmingPlayer::ChooseBestMove(
   std::stringstream ss;
   pos.Display(ss);
   LOG(INFO) << "SimmingPlayer::ChooseBestMove: " << std::endl << ss.str();
+  // Already sorted by descending equity, and no longer than
+  // max_plays_considered_.
   auto all_moves = FindMoves(previous_positions, pos);
-  std::sort(
-      all_moves.begin(), all_moves.end(),
-      [](const Move& m1, const Move& m2) { return m1.Equity() > m2.Equity(); });
   auto candidates = InitialPrune(all_moves);
-  auto* cf = ComponentFactory::GetInstance();
-  auto* ordering_provider = cf->GetTileOrderingProvider();
-  auto orderings = ordering_provider->GetTileOrderings(
-      pos.GameIndex(), pos.PositionIndex(), 0, min_iterations_);
-  /*
-  for (const auto& ordering : orderings) {
-    std::string letters;
-    for (const auto& letter : ordering.Letters()) {
-      letters += tiles_.NumberToChar(letter).value();
-    }
-    LOG(INFO) << "ordering: " << letters;
-  }
-  */
-  const auto seen = pos.SeenByPlayer();
-  std::vector<TileOrdering> adjusted_orderings;
-  adjusted_orderings.reserve(orderings.size());
-  for (const auto& ordering : orderings) {
-    adjusted_orderings.push_back(ordering.Adjust(seen));
-  }
-
   std::sort(candidates.begin(), candidates.end(),
             [](const MoveWithResults& m1, const MoveWithResults& m2) {
               return m1.GetMove()->Equity() > m2.GetMove()->Equity();
@@ -52,7 +36,15 @@ Move SimmingPlayer::ChooseBestMove(
     LOG(INFO) << "returning sole candidate " << ss.str();
     return *candidates[0].GetMove();
   }
-  SimMoves(pos, adjusted_orderings, &candidates);
+  std::vector<MoveWithResults> dropped;
+  SimInRounds(pos, &root_crosses_, &candidates, &dropped);
+  for (auto& move : dropped) {
+    std::stringstream ss;
+    move.GetMove()->Display(tiles_, ss);
+    LOG(INFO) << "dropped move: " << ss.str()
+              << " spread: " << move.AverageSpread()
+              << " iterations: " << move.Iterations();
+  }
   const MoveWithResults* best_move = nullptr;
   std::sort(candidates.begin(), candidates.end(),
             [](const MoveWithResults& m1, const MoveWithResults& m2) {
@@ -61,7 +53,9 @@ Move SimmingPlayer::ChooseBestMove(
   for (auto& move : candidates) {
     std::stringstream ss;
     move.GetMove()->Display(tiles_, ss);
-    LOG(INFO) << "simmed move: " << ss.str() << " spread: " << move.AverageSpread();
+    LOG(INFO) << "simmed move: " << ss.str()
+              << " spread: " << move.AverageSpread()
+              << " iterations: " << move.Iterations();
     if (best_move == nullptr ||
         move.AverageSpread() > best_move->AverageSpread()) {
       best_move = &move;
@@ -77,9 +71,9 @@ std::vector<Move> SimmingPlayer::FindMoves(
   std::stringstream ss;
   pos.Display(ss);
   //LOG(INFO) << "SimmingPlayer::FindMoves: " << std::endl << ss.str();
-  move_finder_->FindMoves(pos.GetRack(), pos.GetBoard(),
-                          pos.GetUnseenToPlayer(), MoveFinder::RecordAll,
-                          true);
+  move_finder_->FindMoves(pos.GetRack(), pos.GetBoard(), pos.NumUnseen(),
+                          MoveFinder::RecordBestK, true);
+  move_finder_->GetCrossesAndScores(&root_crosses_);
   return move_finder_->Moves();
 }
 
@@ -116,49 +110,184 @@ std::vector<SimmingPlayer::MoveWithResults> SimmingPlayer::InitialPrune(
   return ret;
 }
 
-void SimmingPlayer::RecordResults(const Game& game,
-                                  MoveWithResults* move) const {
+float SimmingPlayer::MoveWithResults::SpreadStandardError() const {
+  if (iterations_ < 2) {
+    return std::numeric_limits<float>::infinity();
+  }
+  const double variance =
+      (spread_sum_of_squares_ - spread_sum_ * spread_sum_ / iterations_) /
+      (iterations_ - 1);
+  return std::sqrt(std::max(0.0, variance) / iterations_);
+}
+
+std::vector<TileOrdering> SimmingPlayer::AdjustedTileOrderings(
+    const GamePosition& pos, int start_index, int num_orderings) const {
+  auto* ordering_provider =
+      ComponentFactory::GetInstance()->GetTileOrderingProvider();
+  const auto orderings = ordering_provider->GetTileOrderings(
+      pos.GameIndex(), pos.PositionIndex(), start_index, num_orderings);
+  const auto seen = pos.SeenByPlayer();
+  std::vector<TileOrdering> adjusted_orderings;
+  adjusted_orderings.reserve(orderings.size());
+  for (const auto& ordering : orderings) {
+    adjusted_orderings.push_back(ordering.Adjust(seen));
+  }
+  return adjusted_orderings;
+}
+
+void SimmingPlayer::SimInRounds(const GamePosition& pos,
+                                const CrossesAndScores* root_crosses,
+                                std::vector<MoveWithResults>* candidates,
+                                std::vector<MoveWithResults>* dropped) const {
+  // Every candidate gets min_iterations_. Those still in contention then get
+  // more, a round at a time, up to max_iterations_.
+  int iterations = 0;
+  int round_size = min_iterations_;
+  while (true) {
+    SimMoves(pos, root_crosses,
+             AdjustedTileOrderings(pos, iterations, round_size), candidates);
+    iterations += round_size;
+    if (iterations >= max_iterations_ || iterations_per_round_ <= 0) {
+      break;
+    }
+    DropTrailingCandidates(candidates, dropped);
+    if (candidates->size() == 1) {
+      break;
+    }
+    round_size = std::min(iterations_per_round_, max_iterations_ - iterations);
+  }
+}
+
+void SimmingPlayer::DropTrailingCandidates(
+    std::vector<MoveWithResults>* candidates,
+    std::vector<MoveWithResults>* dropped) const {
+  CHECK(!candidates->empty());
+  const auto leader = std::max_element(
+      candidates->begin(), candidates->end(),
+      [](const MoveWithResults& a, const MoveWithResults& b) {
+        return a.AverageSpread() < b.AverageSpread();
+      });
+  const float leader_lower_bound =
+      leader->AverageSpread() -
+      pruning_standard_errors_ * leader->SpreadStandardError();
+  const auto trailing = [this, leader_lower_bound](const MoveWithResults& m) {
+    return m.AverageSpread() +
+               pruning_standard_errors_ * m.SpreadStandardError() <
+           leader_lower_bound;
+  };
+  // Keeps the remaining candidates in their original order.
+  const auto it =
+      std::stable_partition(candidates->begin(), candidates->end(),
+                            [&trailing](const MoveWithResults& m) {
+                              return !trailing(m);
+                            });
+  dropped->insert(dropped->end(), it, candidates->end());
+  candidates->erase(it, candidates->end());
+}
+
+std::unique_ptr<SimmingPlayer::RolloutWorker>
+SimmingPlayer::CreateRolloutWorker(
+    const q2::proto::SimmingPlayerConfig& config) const {
+  auto worker = absl::make_unique<RolloutWorker>();
+  std::vector<ComputerPlayer*> players;
+  for (int i = 0; i < 2; ++i) {
+    auto player =
+        ComponentFactory::CreatePlayerFromConfig(config.rollout_player());
+    CHECK(player != nullptr);
+    players.push_back(player.get());
+    worker->players.push_back(std::move(player));
+  }
+  worker->rollout = absl::make_unique<Rollout>(layout_, players, tiles_);
+  return worker;
+}
+
+float SimmingPlayer::Spread(const Rollout& rollout) const {
   float spread = 0.0;
-  for (int i = 0; i <= num_plies_; ++i) {
+  // A rollout that reaches the end of the game has fewer plies to count.
+  const int last_ply = std::min(num_plies_, rollout.NumPlies() - 1);
+  for (int i = 0; i <= last_ply; ++i) {
     int sign = (i % 2 == 0) ? 1 : -1;
-    const auto* pos = game.GetPosition(i);
-    CHECK(pos != nullptr);
-    const auto& move = pos->GetMove();
-    CHECK(move.has_value());
     if (i + 2 > num_plies_) {
-      spread += sign * move->Equity();
+      spread += sign * rollout.Equity(i);
     } else {
-      spread += sign * move->Score();
+      spread += sign * rollout.Score(i);
     }
   }
-  move->RecordSpread(spread);
+  return spread;
+}
+
+float SimmingPlayer::RolloutSpread(const GamePosition& position,
+                                   const CrossesAndScores* root_crosses,
+                                   const TileOrdering& ordering,
+                                   const Move& move, Rollout* rollout) const {
+  rollout->Reset(position, ordering, root_crosses);
+  rollout->AddNextPosition(move);
+  rollout->ContinueWithComputerPlayers(num_plies_);
+  return Spread(*rollout);
 }
 
 void SimmingPlayer::SimMove(const GamePosition& position,
+                            const CrossesAndScores* root_crosses,
                             const std::vector<TileOrdering>& orderings,
                             MoveWithResults* move) const {
-  std::vector<Player*> players;
-  for (int i = 0; i < 2; i++) {
-    auto& player = rollout_players_[i];
-    player->ResetGameState();
-    players.push_back(player.get());
-  }
+  Rollout* rollout = rollout_workers_[0]->rollout.get();
   move->IncrementIterations(orderings.size());
   for (const auto& ordering : orderings) {
-    Game game(layout_, position, players, tiles_, ordering);
-    game.AddNextPosition(*move->GetMove(), absl::ZeroDuration());
-    game.ContinueWithComputerPlayers(num_plies_);
-    //std::stringstream ss;
-    //game.Display(ss);
-    //LOG(INFO) << "game: " << std::endl << ss.str();
-    RecordResults(game, move);
+    move->RecordSpread(RolloutSpread(position, root_crosses, ordering,
+                                     *move->GetMove(), rollout));
   }
 }
 
 void SimmingPlayer::SimMoves(const GamePosition& position,
+                             const CrossesAndScores* root_crosses,
                              const std::vector<TileOrdering>& orderings,
                              std::vector<MoveWithResults>* moves) const {
-  for (auto& move : *moves) {
-    SimMove(position, orderings, &move);
+  const int num_threads = rollout_workers_.size();
+  if (num_threads == 1 || moves->empty() || orderings.empty()) {
+    for (auto& move : *moves) {
+      SimMove(position, root_crosses, orderings, &move);
+    }
+    return;
   }
-}
\ No newline at end of file
+  // Split each candidate's orderings into blocks, aiming for a few work items
+  // per thread. Every rollout's spread gets its own slot, and the slots are
+  // added up in ordering order at the end, so the sums match SimMove(...)
+  // exactly.
+  const int num_moves = moves->size();
+  const int num_orderings = orderings.size();
+  const int blocks_per_move =
+      std::min(num_orderings, (4 * num_threads + num_moves - 1) / num_moves);
+  const int block_size =
+      (num_orderings + blocks_per_move - 1) / blocks_per_move;
+  const int num_blocks = (num_orderings + block_size - 1) / block_size;
+  const int num_items = num_moves * num_blocks;
+  std::vector<float> spreads(num_moves * num_orderings);
+  std::atomic<int> next_item(0);
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (int t = 0; t < num_threads; ++t) {
+    Rollout* rollout = rollout_workers_[t]->rollout.get();
+    threads.emplace_back([&, rollout]() {
+      for (int item = next_item++; item < num_items; item = next_item++) {
+        const int move_index = item / num_blocks;
+        const int begin = (item % num_blocks) * block_size;
+        const int end = std::min(begin + block_size, num_orderings);
+        const Move& move = *(*moves)[move_index].GetMove();
+        for (int i = begin; i < end; ++i) {
+          spreads[move_index * num_orderings + i] = RolloutSpread(
+              position, root_crosses, orderings[i], move, rollout);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int m = 0; m < num_moves; ++m) {
+    auto& move = (*moves)[m];
+    move.IncrementIterations(num_orderings);
+    for (int i = 0; i < num_orderings; ++i) {
+      move.RecordSpread(spreads[m * num_orderings + i]);
+    }
+  }
+}
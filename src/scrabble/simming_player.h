@@ -13,6 +13,7 @@
 #include "src/scrabble/game_position.h"
 #include "src/scrabble/move.h"
 #include "src/scrabble/move_finder.h"
+#include "src/scrabble/rollout.h"
 
 class SimmingPlayer : public ComputerPlayer {
  public:
@@ -36,27 +37,32 @@ class SimmingPlayer : public ComputerPlayer {
     void IncrementIterations(int delta) { iterations_ += delta; }
     void RecordSpread(float spread) {
       spread_sum_ += spread;
-      spread_sum_of_squares_ += spread * spread;
+      spread_sum_of_squares_ += static_cast<double>(spread) * spread;
     }
     void RecordWins(float win_prob) {
       wins_sum_ += win_prob;
-      wins_sum_of_squares += win_prob * win_prob;
+      wins_sum_of_squares += static_cast<double>(win_prob) * win_prob;
     }
     float AverageSpread() const { return spread_sum_ / iterations_; }
+    // Standard error of AverageSpread(), infinite with fewer than 2
+    // iterations.
+    float SpreadStandardError() const;
     float WinProb() const { return wins_sum_ / iterations_; }
     int Iterations() const { return iterations_; }
-    float SpreadSum() const { return spread_sum_; }
-    float SpreadSumOfSquares() const { return spread_sum_of_squares_; }
-    float WinsSum() const { return wins_sum_; }
-    float WinsSumOfSquares() const { return wins_sum_of_squares; }
+    double SpreadSum() const { return spread_sum_; }
+    double SpreadSumOfSquares() const { return spread_sum_of_squares_; }
+    double WinsSum() const { return wins_sum_; }
+    double WinsSumOfSquares() const { return wins_sum_of_squares; }
 
    private:
     const Move* move_;
     int iterations_;
-    float spread_sum_;
-    float spread_sum_of_squares_;
-    float wins_sum_;
-    float wins_sum_of_squares;
+    // Doubles, since SpreadStandardError() subtracts two large sums of
+    // squares after thousands of iterations.
+    double spread_sum_;
+    double spread_sum_of_squares_;
+    double wins_sum_;
+    double wins_sum_of_squares;
   };
 
   static void Register() {
@@ -84,27 +90,42 @@ class SimmingPlayer : public ComputerPlayer {
                 ? 999999.9
                 : config.static_equity_pruning_threshold()),
         min_iterations_(config.min_iterations()),
-        max_iterations_(config.max_iterations()) {
+        max_iterations_(config.max_iterations()),
+        iterations_per_round_(config.iterations_per_round() == 0
+                                  ? config.min_iterations()
+                                  : config.iterations_per_round()),
+        pruning_standard_errors_(config.pruning_standard_errors() == 0.0
+                                     ? 2.0
+                                     : config.pruning_standard_errors()) {
     move_finder_ = absl::make_unique<MoveFinder>(
         *DataManager::GetInstance()->GetAnagramMap(config.anagram_map_file()),
         *DataManager::GetInstance()->GetBoardLayout(config.board_layout_file()),
         tiles_, *DataManager::GetInstance()->GetLeaves(config.leaves_file()));
-    for(int i = 0; i < 2; ++i) {
-      auto player = ComponentFactory::CreatePlayerFromConfig(config.rollout_player());
-      CHECK(player != nullptr);
-      rollout_players_.push_back(std::move(player));
-    }        
+    move_finder_->SetBestK((config.max_plays_considered() == 0)
+                               ? MoveFinder::kNoLimit
+                               : max_plays_considered_);
+    move_finder_->SetNumThreads(std::max(1, config.move_finder_threads()));
+    move_finder_->SetRackTable(
+        DataManager::GetInstance()->GetRackTable(config.rack_table_file()));
+    const int rollout_threads = std::max(1, config.rollout_threads());
+    for (int i = 0; i < rollout_threads; ++i) {
+      rollout_workers_.push_back(CreateRolloutWorker(config));
+    }
   }
 
   Move ChooseBestMove(const std::vector<GamePosition>* previous_position,
                       const GamePosition& position) override;
 
-  void RecordResults(const Game& game, MoveWithResults* move) const;
-
+  // root_crosses are the crosses and scores of position's board, copied
+  // into the rollout players, or nullptr for them to scan the board.
   void SimMove(const GamePosition& position,
+               const CrossesAndScores* root_crosses,
                const std::vector<TileOrdering>& orderings,
                MoveWithResults* move) const;
+  // With rollout_threads > 1, (candidate, block of orderings) pairs are
+  // shared out among the threads. Results are the same as the serial run.
   void SimMoves(const GamePosition& position,
+                const CrossesAndScores* root_crosses,
                 const std::vector<TileOrdering>& orderings,
                 std::vector<MoveWithResults>* moves) const;
 
@@ -116,6 +137,10 @@ class SimmingPlayer : public ComputerPlayer {
   FRIEND_TEST(SimmingPlayerTest, SelectWithinThreshold2);
   FRIEND_TEST(SimmingPlayerTest, SelectTopNWithinThreshold);
   FRIEND_TEST(SimmingPlayerTest, SelectTopNWithinThreshold2);
+  FRIEND_TEST(SimmingPlayerTest, RolloutThreadsMatchSerial);
+  FRIEND_TEST(SimmingPlayerTest, SimMovesOnNonEmptyBoard);
+  FRIEND_TEST(SimmingPlayerTest, DropTrailingCandidates);
+  FRIEND_TEST(SimmingPlayerTest, ChooseBestMoveInRounds);
 
   std::vector<Move> FindMoves(
       const std::vector<GamePosition>* previous_positions,
@@ -123,6 +148,41 @@ class SimmingPlayer : public ComputerPlayer {
 
   std::vector<MoveWithResults> InitialPrune(const std::vector<Move>& moves);
 
+  // Orderings [start_index, start_index + num_orderings) for pos, adjusted
+  // for the tiles its player can see.
+  std::vector<TileOrdering> AdjustedTileOrderings(const GamePosition& pos,
+                                                  int start_index,
+                                                  int num_orderings) const;
+
+  // Sims candidates for min_iterations_, then in rounds of
+  // iterations_per_round_ up to max_iterations_, moving those that fall
+  // confidently behind to dropped after each round.
+  void SimInRounds(const GamePosition& pos,
+                   const CrossesAndScores* root_crosses,
+                   std::vector<MoveWithResults>* candidates,
+                   std::vector<MoveWithResults>* dropped) const;
+
+  // Moves candidates whose spread is confidently behind the leader's to
+  // dropped. The leader is the candidate with the best average spread.
+  void DropTrailingCandidates(std::vector<MoveWithResults>* candidates,
+                              std::vector<MoveWithResults>* dropped) const;
+
+  // A pair of rollout players and the Rollout they play in. Each rollout
+  // thread has its own, so no MoveFinder is shared between threads.
+  struct RolloutWorker {
+    std::vector<std::unique_ptr<ComputerPlayer>> players;
+    std::unique_ptr<Rollout> rollout;
+  };
+  std::unique_ptr<RolloutWorker> CreateRolloutWorker(
+      const q2::proto::SimmingPlayerConfig& config) const;
+
+  // Plays move from position through ordering and returns its spread.
+  float RolloutSpread(const GamePosition& position,
+                      const CrossesAndScores* root_crosses,
+                      const TileOrdering& ordering, const Move& move,
+                      Rollout* rollout) const;
+  float Spread(const Rollout& rollout) const;
+
   const BoardLayout& layout_;
   const Tiles& tiles_;
   int positions_with_crosses_computed_ = 0;
@@ -134,8 +194,15 @@ class SimmingPlayer : public ComputerPlayer {
   float static_equity_pruning_threshold_;
   int min_iterations_;
   int max_iterations_;
+  int iterations_per_round_;
+  float pruning_standard_errors_;
+
+  // Crosses and scores of the board last passed to FindMoves(...), for
+  // ChooseBestMove(...) to pass to SimMoves(...).
+  CrossesAndScores root_crosses_;
 
-  std::vector<std::unique_ptr<ComputerPlayer>> rollout_players_;
+  // One per rollout thread. SimMove(...) uses the first.
+  std::vector<std::unique_ptr<RolloutWorker>> rollout_workers_;
 };
 
 #endif  // SRC_SCRABBLE_SIMMING_PLAYER_H
\ No newline at end of file
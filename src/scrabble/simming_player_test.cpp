@@ -2,6 +2,8 @@
 
 #include <google/protobuf/text_format.h>
 
+#include <cmath>
+
 using ::google::protobuf::Arena;
 
 #include "absl/memory/memory.h"
@@ -419,4 +421,288 @@ TEST_F(SimmingPlayerTest, ChooseBestMove) {
   std::vector<GamePosition> previous_positions;
   const auto move = player->ChooseBestMove(&previous_positions, *pos);
   ExpectMove(move, "8F GOULASH (score = 80)");
-}
\ No newline at end of file
+}
+
+TEST_F(SimmingPlayerTest, RolloutThreadsMatchSerial) {
+  Arena arena;
+  auto config = Arena::CreateMessage<q2::proto::SimmingPlayerConfig>(&arena);
+  google::protobuf::TextFormat::ParseFromString(R"(
+        id: 1
+        name: "Simmie"
+        nickname: "S"
+        anagram_map_file: "src/scrabble/testdata/csw21.qam"
+        board_layout_file: "src/scrabble/testdata/scrabble_board.textproto"
+        tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+        leaves_file: "src/scrabble/testdata/csw_scrabble_macondo.qlv"
+        plies: 2
+        max_plays_considered: 5
+        rollout_player {
+            static_player_config {
+                id: 100
+                name: "Simmie's Static Player"
+                nickname: "SimStat"
+                anagram_map_file: "src/scrabble/testdata/csw21.qam"
+                board_layout_file: "src/scrabble/testdata/scrabble_board.textproto"
+                tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+                leaves_file: "src/scrabble/testdata/csw_scrabble_macondo.qlv"
+            }
+        }
+        )",
+                                                config);
+  auto serial_player = absl::make_unique<SimmingPlayer>(*config);
+  config->set_rollout_threads(3);
+  auto threaded_player = absl::make_unique<SimmingPlayer>(*config);
+
+  DataManager* dm = DataManager::GetInstance();
+  const Tiles* tiles =
+      dm->GetTiles("src/scrabble/testdata/english_scrabble_tiles.textproto");
+  const BoardLayout* layout =
+      dm->GetBoardLayout("src/scrabble/testdata/scrabble_board.textproto");
+  const Board board;
+  const Rack rack(tiles->ToLetterString("QUACKUM").value());
+  const GamePosition pos(*layout, board, 1, 2, rack, 0, 0, 0, 0,
+                         absl::Minutes(25), 0, *tiles);
+  std::vector<GamePosition> previous_positions;
+  const auto all_moves = serial_player->FindMoves(&previous_positions, pos);
+  absl::BitGen gen;
+  std::vector<TileOrdering> orderings;
+  for (int i = 0; i < 23; ++i) {
+    orderings.push_back(
+        TileOrdering(*tiles, gen, 40).Adjust(pos.SeenByPlayer()));
+  }
+
+  auto serial_moves = serial_player->InitialPrune(all_moves);
+  auto threaded_moves = threaded_player->InitialPrune(all_moves);
+  ASSERT_EQ(serial_moves.size(), 5);
+  serial_player->SimMoves(pos, nullptr, orderings, &serial_moves);
+  threaded_player->SimMoves(pos, nullptr, orderings, &threaded_moves);
+  ASSERT_EQ(threaded_moves.size(), serial_moves.size());
+  for (int i = 0; i < serial_moves.size(); ++i) {
+    EXPECT_EQ(threaded_moves[i].GetMove(), serial_moves[i].GetMove());
+    EXPECT_EQ(threaded_moves[i].Iterations(), 23);
+    EXPECT_EQ(threaded_moves[i].SpreadSum(), serial_moves[i].SpreadSum());
+    EXPECT_EQ(threaded_moves[i].SpreadSumOfSquares(),
+              serial_moves[i].SpreadSumOfSquares());
+  }
+}
+
+TEST_F(SimmingPlayerTest, SimMovesOnNonEmptyBoard) {
+  Arena arena;
+  auto config = Arena::CreateMessage<q2::proto::SimmingPlayerConfig>(&arena);
+  google::protobuf::TextFormat::ParseFromString(R"(
+        id: 1
+        name: "Simmie"
+        nickname: "S"
+        anagram_map_file: "src/scrabble/testdata/csw21.qam"
+        board_layout_file: "src/scrabble/testdata/scrabble_board.textproto"
+        tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+        leaves_file: "src/scrabble/testdata/csw_scrabble_macondo.qlv"
+        plies: 2
+        max_plays_considered: 5
+        rollout_player {
+            static_player_config {
+                id: 100
+                name: "Simmie's Static Player"
+                nickname: "SimStat"
+                anagram_map_file: "src/scrabble/testdata/csw21.qam"
+                board_layout_file: "src/scrabble/testdata/scrabble_board.textproto"
+                tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+                leaves_file: "src/scrabble/testdata/csw_scrabble_macondo.qlv"
+            }
+        }
+        )",
+                                                config);
+  auto player = absl::make_unique<SimmingPlayer>(*config);
+
+  DataManager* dm = DataManager::GetInstance();
+  const Tiles* tiles =
+      dm->GetTiles("src/scrabble/testdata/english_scrabble_tiles.textproto");
+  const BoardLayout* layout =
+      dm->GetBoardLayout("src/scrabble/testdata/scrabble_board.textproto");
+  Board board;
+  board.SetLetters(
+      {R"(   A B C D E F G H I J K L M N O)",
+       R"(   ------------------------------)",
+       R"( 1|=     '       =       '     =|)",
+       R"( 2|  -       "       "       -  |)",
+       R"( 3|    -       '   '       -    |)",
+       R"( 4|'     -       '       -     '|)",
+       R"( 5|        -           -        |)",
+       R"( 6|  "       "       "       "  |)",
+       R"( 7|    '       ' Z '       '    |)",
+       R"( 8|=     '     Q U A C K '     =|)",
+       R"( 9|    '       '   '       '    |)",
+       R"(10|  "       "       "       "  |)",
+       R"(11|        -           -        |)",
+       R"(12|'     -       '       -     '|)",
+       R"(13|    -       '   '       -    |)",
+       R"(14|  -       "       "       -  |)",
+       R"(15|=     '       =       '     =|)",
+       R"(   ------------------------------)"},
+      *tiles);
+  const Rack rack(tiles->ToLetterString("OLAUGHS").value());
+  const GamePosition pos(*layout, board, 1, 2, rack, 0, 38, 0, 0,
+                         absl::Minutes(25), 0, *tiles);
+  std::vector<GamePosition> previous_positions;
+  const auto all_moves = player->FindMoves(&previous_positions, pos);
+  absl::BitGen gen;
+  std::vector<TileOrdering> orderings;
+  for (int i = 0; i < 10; ++i) {
+    orderings.push_back(
+        TileOrdering(*tiles, gen, 40).Adjust(pos.SeenByPlayer()));
+  }
+
+  // Crosses passed in must give the same rollouts as the rollout players
+  // scanning the board themselves.
+  auto moves = player->InitialPrune(all_moves);
+  auto rescanned_moves = player->InitialPrune(all_moves);
+  ASSERT_EQ(moves.size(), 5);
+  player->SimMoves(pos, &player->root_crosses_, orderings, &moves);
+  player->SimMoves(pos, nullptr, orderings, &rescanned_moves);
+  for (int i = 0; i < moves.size(); ++i) {
+    EXPECT_EQ(moves[i].GetMove(), rescanned_moves[i].GetMove());
+    EXPECT_EQ(moves[i].Iterations(), 10);
+    EXPECT_EQ(moves[i].SpreadSum(), rescanned_moves[i].SpreadSum());
+    EXPECT_EQ(moves[i].SpreadSumOfSquares(),
+              rescanned_moves[i].SpreadSumOfSquares());
+  }
+}
+
+TEST_F(SimmingPlayerTest, DropTrailingCandidates) {
+  Arena arena;
+  auto config = Arena::CreateMessage<q2::proto::SimmingPlayerConfig>(&arena);
+  google::protobuf::TextFormat::ParseFromString(R"(
+        id: 1
+        name: "Simmie"
+        nickname: "S"
+        anagram_map_file: "src/scrabble/testdata/csw21.qam"
+        board_layout_file: "src/scrabble/testdata/scrabble_board.textproto"
+        tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+        leaves_file: "src/scrabble/testdata/csw_scrabble_macondo.qlv"
+        plies: 2
+        rollout_threads: 1
+        rollout_player {
+            static_player_config {
+                id: 100
+                name: "Simmie's Static Player"
+                nickname: "SimStat"
+                anagram_map_file: "src/scrabble/testdata/csw21.qam"
+                board_layout_file: "src/scrabble/testdata/scrabble_board.textproto"
+                tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+                leaves_file: "src/scrabble/testdata/csw_scrabble_macondo.qlv"
+            }
+        }
+        )",
+                                                config);
+  auto player = absl::make_unique<SimmingPlayer>(*config);
+  const Move moves[4];
+  // Average spreads of 25, 30, 10 and 5, each with a standard error of 2.
+  std::vector<SimmingPlayer::MoveWithResults> candidates;
+  for (int i = 0; i < 4; ++i) {
+    candidates.emplace_back(&moves[i]);
+  }
+  const float averages[] = {25, 30, 10, 5};
+  for (int i = 0; i < 4; ++i) {
+    candidates[i].IncrementIterations(100);
+    for (int j = 0; j < 50; ++j) {
+      candidates[i].RecordSpread(averages[i] - 19.9);
+      candidates[i].RecordSpread(averages[i] + 19.9);
+    }
+    EXPECT_NEAR(candidates[i].SpreadStandardError(), 2, 0.01);
+  }
+  std::vector<SimmingPlayer::MoveWithResults> dropped;
+  player->DropTrailingCandidates(&candidates, &dropped);
+  ASSERT_EQ(candidates.size(), 2);
+  EXPECT_EQ(candidates[0].GetMove(), &moves[0]);
+  EXPECT_EQ(candidates[1].GetMove(), &moves[1]);
+  ASSERT_EQ(dropped.size(), 2);
+  EXPECT_EQ(dropped[0].GetMove(), &moves[2]);
+  EXPECT_EQ(dropped[1].GetMove(), &moves[3]);
+
+  // Nothing is dropped before there is a standard error to go on.
+  std::vector<SimmingPlayer::MoveWithResults> fresh;
+  fresh.emplace_back(&moves[0]);
+  fresh.emplace_back(&moves[1]);
+  fresh[0].IncrementIterations(1);
+  fresh[0].RecordSpread(100);
+  fresh[1].IncrementIterations(1);
+  fresh[1].RecordSpread(-100);
+  player->DropTrailingCandidates(&fresh, &dropped);
+  EXPECT_EQ(fresh.size(), 2);
+  EXPECT_EQ(dropped.size(), 2);
+}
+
+TEST_F(SimmingPlayerTest, SpreadStandardErrorAfterManyIterations) {
+  // 20000 spreads of 1000 +/- 10 have a standard error of 10 / sqrt(20000).
+  // Sums of squares in single precision lose that difference entirely.
+  const Move move;
+  SimmingPlayer::MoveWithResults candidate(&move);
+  candidate.IncrementIterations(20000);
+  for (int i = 0; i < 10000; ++i) {
+    candidate.RecordSpread(990);
+    candidate.RecordSpread(1010);
+  }
+  EXPECT_NEAR(candidate.SpreadStandardError(), 10 / std::sqrt(20000.0),
+              1e-4);
+}
+
+TEST_F(SimmingPlayerTest, ChooseBestMoveInRounds) {
+  Arena arena;
+  auto config = Arena::CreateMessage<q2::proto::SimmingPlayerConfig>(&arena);
+  google::protobuf::TextFormat::ParseFromString(R"(
+        id: 1
+        name: "Simmie"
+        nickname: "S"
+        anagram_map_file: "src/scrabble/testdata/csw21.qam"
+        board_layout_file: "src/scrabble/testdata/scrabble_board.textproto"
+        tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+        leaves_file: "src/scrabble/testdata/csw_scrabble_macondo.qlv"
+        plies: 2
+        max_plays_considered: 9
+        static_equity_pruning_threshold: 100000
+        min_iterations: 50
+        max_iterations: 1000
+        iterations_per_round: 50
+        rollout_player {
+            static_player_config {
+                id: 100
+                name: "Simmie's Static Player"
+                nickname: "SimStat"
+                anagram_map_file: "src/scrabble/testdata/csw21.qam"
+                board_layout_file: "src/scrabble/testdata/scrabble_board.textproto"
+                tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+                leaves_file: "src/scrabble/testdata/csw_scrabble_macondo.qlv"
+            }
+        }
+        )",
+                                                config);
+  auto player = absl::make_unique<SimmingPlayer>(*config);
+  const Board board;
+  DataManager* dm = DataManager::GetInstance();
+  const Tiles* tiles =
+      dm->GetTiles("src/scrabble/testdata/english_scrabble_tiles.textproto");
+  const BoardLayout* layout =
+      dm->GetBoardLayout("src/scrabble/testdata/scrabble_board.textproto");
+  const Rack rack(tiles->ToLetterString("GOULASH").value());
+  const GamePosition pos(*layout, board, 1, 2, rack, 0, 0, 0, 0,
+                         absl::Minutes(25), 0, *tiles);
+  std::vector<GamePosition> previous_positions;
+  const auto all_moves = player->FindMoves(&previous_positions, pos);
+  auto candidates = player->InitialPrune(all_moves);
+  ASSERT_EQ(candidates.size(), 9);
+  std::vector<SimmingPlayer::MoveWithResults> dropped;
+  player->SimInRounds(pos, &player->root_crosses_, &candidates, &dropped);
+  // Trailing candidates stop getting iterations once dropped; the rest play
+  // out all max_iterations.
+  ASSERT_FALSE(dropped.empty());
+  ASSERT_GE(candidates.size(), 2);
+  for (const auto& move : dropped) {
+    EXPECT_LT(move.Iterations(), 1000);
+  }
+  for (const auto& move : candidates) {
+    EXPECT_EQ(move.Iterations(), 1000);
+  }
+
+  const auto move = player->ChooseBestMove(&previous_positions, pos);
+  ExpectMove(move, "8F GOULASH (score = 80)");
+}
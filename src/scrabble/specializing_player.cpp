@@ -26,4 +26,11 @@ void SpecializingPlayer::ResetGameState() {
   for (auto& player : players_) {
     player->ResetGameState();
   }
+}
+
+void SpecializingPlayer::SetRootCrossesAndScores(
+    const CrossesAndScores& crosses_and_scores) {
+  for (auto& player : players_) {
+    player->SetRootCrossesAndScores(crosses_and_scores);
+  }
 }
\ No newline at end of file
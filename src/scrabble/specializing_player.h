@@ -34,6 +34,8 @@ class SpecializingPlayer : public ComputerPlayer {
                       const GamePosition& position) override;
 
   void ResetGameState() override;
+  void SetRootCrossesAndScores(
+      const CrossesAndScores& crosses_and_scores) override;
   
  private:
   std::vector<std::unique_ptr<Predicate>> predicates_;
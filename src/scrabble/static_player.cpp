@@ -12,8 +12,16 @@ Move StaticPlayer::ChooseBestMove(
   CHECK_NE(previous_positions, nullptr);
   //LOG(INFO) << "positions_with_crosses_computed_: "
   //          << positions_with_crosses_computed_;
-  if (positions_with_crosses_computed_ == 0) {
-    move_finder_->ClearHookTables();
+  if (positions_with_crosses_computed_ == 0 && !root_crosses_set_) {
+    const Board& root_board = previous_positions->empty()
+                                  ? pos.GetBoard()
+                                  : (*previous_positions)[0].GetBoard();
+    if (root_board.IsEmpty()) {
+      move_finder_->ClearHookTables();
+    } else {
+      move_finder_->CacheCrossesAndScores(root_board);
+    }
+    root_crosses_set_ = true;
   }
   for (int i = positions_with_crosses_computed_ + 1;
        i < previous_positions->size(); ++i) {
@@ -29,9 +37,8 @@ Move StaticPlayer::ChooseBestMove(
   // LOG(INFO) << "about to find moves (which will require calling
   // GetUnseenToPlayer)"; std::stringstream ss2; pos.Display(ss2); LOG(INFO) <<
   // "pos: " << std::endl << ss2.str() << std::endl;
-  move_finder_->FindMoves(pos.GetRack(), pos.GetBoard(),
-                          pos.GetUnseenToPlayer(), MoveFinder::RecordBest,
-                          false);
+  move_finder_->FindMoves(pos.GetRack(), pos.GetBoard(), pos.NumUnseen(),
+                          MoveFinder::RecordBest, false);
   const auto& moves = move_finder_->Moves();
   CHECK_EQ(moves.size(), 1);
   auto move = moves[0];
@@ -65,4 +72,13 @@ Move StaticPlayer::ChooseBestMove(
   return move;
 }
 
-void StaticPlayer::ResetGameState() { positions_with_crosses_computed_ = 0; }
\ No newline at end of file
+void StaticPlayer::ResetGameState() {
+  positions_with_crosses_computed_ = 0;
+  root_crosses_set_ = false;
+}
+
+void StaticPlayer::SetRootCrossesAndScores(
+    const CrossesAndScores& crosses_and_scores) {
+  move_finder_->SetCrossesAndScores(crosses_and_scores);
+  root_crosses_set_ = true;
+}
\ No newline at end of file
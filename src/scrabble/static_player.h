@@ -41,14 +41,22 @@ class StaticPlayer : public ComputerPlayer {
             *DataManager::GetInstance()->GetBoardLayout(
                 config.board_layout_file()),
             *DataManager::GetInstance()->GetTiles(config.tiles_file()),
-            *DataManager::GetInstance()->GetLeaves(config.leaves_file())) {}
+            *DataManager::GetInstance()->GetLeaves(config.leaves_file())) {
+    move_finder_->SetRackTable(
+        DataManager::GetInstance()->GetRackTable(config.rack_table_file()));
+  }
   Move ChooseBestMove(const std::vector<GamePosition>* previous_positions,
                       const GamePosition& position) override;
   void ResetGameState() override;
+  void SetRootCrossesAndScores(
+      const CrossesAndScores& crosses_and_scores) override;
 
  private:
   std::unique_ptr<MoveFinder> move_finder_;
   int positions_with_crosses_computed_ = 0;
+  // Whether move_finder_ already holds crosses for the first position's
+  // board, set by SetRootCrossesAndScores(...).
+  bool root_crosses_set_ = false;
   const Tiles& tiles_;
 };
 
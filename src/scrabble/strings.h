@@ -22,12 +22,13 @@ class LetterString {
   typedef const char& const_reference;
 
   LetterString();
-  ~LetterString() {}
   LetterString(const Letter* s, size_t n);
   LetterString(size_t n, Letter c);
   LetterString(const Letter* s);
-  LetterString(const LetterString& s);
-  LetterString(LetterString&& s);
+  // Trivially copyable, so arrays of LetterStrings can be mapped straight
+  // from an AnagramMapSnapshot file.
+  LetterString(const LetterString& s) = default;
+  LetterString(LetterString&& s) = default;
 
   int first_position() const;
   int last_position() const;
@@ -52,8 +53,8 @@ class LetterString {
 
   reference operator[](size_type i) { return data_[i]; }
   const_reference operator[](std::size_t i) const { return data_[i]; }
-  LetterString& operator=(const LetterString& s);
-  LetterString& operator=(LetterString&& s);
+  LetterString& operator=(const LetterString& s) = default;
+  LetterString& operator=(LetterString&& s) = default;
 
   std::array<int, 32> Counts() const {
     std::array<int, 32> ret;
@@ -181,22 +182,6 @@ inline LetterString::LetterString(const char* s) {
   last_position_ = sz - 1;
 }
 
-inline LetterString::LetterString(const LetterString& s) {
-  // LOG(INFO) << "called copy constructor";
-  int sz = s.size();
-  memcpy(data_ + s.first_position(), s.data_ + s.first_position(), sz);
-  first_position_ = s.first_position();
-  last_position_ = s.last_position();
-}
-
-inline LetterString::LetterString(LetterString&& s) {
-  // LOG(INFO) << "called std::move constructor";
-  int sz = s.size();
-  memcpy(data_ + s.first_position(), s.data_ + s.first_position(), sz);
-  first_position_ = s.first_position();
-  last_position_ = s.last_position();
-}
-
 inline void LetterString::push_back(char c) {
   if (last_position_ + 1 >= FIXED_STRING_MAXIMUM_LENGTH) {
     //LOG(FATAL) << "String is too long";
@@ -208,22 +193,4 @@ inline void LetterString::push_back(char c) {
 inline int LetterString::first_position() const { return first_position_; }
 inline int LetterString::last_position() const { return last_position_; }
 
-inline LetterString& LetterString::operator=(const LetterString& s) {
-  // LOG(INFO) << "called operator=";
-  int sz = s.size();
-  memcpy(data_, s.data_, sz);
-  first_position_ = s.first_position();
-  last_position_ = s.last_position();
-  return *this;
-}
-
-inline LetterString& LetterString::operator=(LetterString&& s) {
-  // LOG(INFO) << "called std::move operator=";
-  int sz = s.size();
-  memcpy(data_, s.data_, sz);
-  first_position_ = s.first_position();
-  last_position_ = s.last_position();
-  return *this;
-}
-
 #endif  // SRC_SCRABBLE_STRINGS_H
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include <fstream>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/flags/usage.h"
+#include "glog/logging.h"
+#include "google/protobuf/text_format.h"
+#include "src/scrabble/computer_players.pb.h"
+#include "src/scrabble/tournament_runner.h"
+
+ABSL_FLAG(std::vector<std::string>, shard_results_files, {},
+          "comma-separated ShardResults files, one per shard");
+ABSL_FLAG(std::string, output_file, "",
+          "output TournamentResults .textproto file path");
+ABSL_FLAG(std::string, latency_file, "",
+          "output .csv file path for move latency percentiles");
+
+int main(int argc, char *argv[]) {
+  absl::ParseCommandLine(argc, argv);
+  const auto filenames = absl::GetFlag(FLAGS_shard_results_files);
+  if (filenames.empty()) {
+    LOG(ERROR) << "No shard results files given";
+    return 1;
+  }
+  std::vector<q2::proto::ShardResults> shards;
+  for (const auto& filename : filenames) {
+    auto shard = TournamentRunner::ReadShardResults(filename);
+    if (shard == nullptr) {
+      // The other shards are still worth merging.
+      continue;
+    }
+    LOG(INFO) << "Read shard " << shard->shard_index() << " of "
+              << shard->number_of_shards() << " from " << filename << " ("
+              << shard->number_of_pairs() << " pairs)";
+    shards.push_back(*shard);
+  }
+  q2::proto::TournamentResults results;
+  TournamentRunner::MergeShards(shards, &results);
+  std::string text;
+  google::protobuf::TextFormat::PrintToString(results, &text);
+  LOG(INFO) << "Merged results:" << std::endl << text;
+  if (!absl::GetFlag(FLAGS_output_file).empty()) {
+    std::ofstream file(absl::GetFlag(FLAGS_output_file));
+    file << text;
+    if (!file.good()) {
+      LOG(ERROR) << "Failed to write to file: "
+                 << absl::GetFlag(FLAGS_output_file);
+      return 1;
+    }
+  }
+  if (!absl::GetFlag(FLAGS_latency_file).empty()) {
+    const absl::Status status = TournamentRunner::WriteLatencyCsv(
+        results, absl::GetFlag(FLAGS_latency_file));
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+      return 1;
+    }
+  }
+  return 0;
+}
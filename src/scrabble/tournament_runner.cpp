@@ -1,5 +1,12 @@
 #include "src/scrabble/tournament_runner.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
 #include <thread>
 
 #include "src/scrabble/component_factory.h"
@@ -7,14 +14,68 @@
 #include "src/scrabble/computer_players.pb.h"
 #include "src/scrabble/data_manager.h"
 #include "src/scrabble/game.h"
+#include "src/scrabble/game_record.h"
 #include "src/scrabble/passing_player.h"
 #include "src/scrabble/static_player.h"
 
 using ::google::protobuf::Arena;
 
 namespace {
+q2::proto::LatencyHistogram::GamePhase GamePhase(int num_unseen) {
+  if (num_unseen >= 80) {
+    return q2::proto::LatencyHistogram::OPENING;
+  } else if (num_unseen >= 14) {
+    return q2::proto::LatencyHistogram::MIDGAME;
+  } else if (num_unseen >= 8) {
+    return q2::proto::LatencyHistogram::PREENDGAME;
+  }
+  return q2::proto::LatencyHistogram::ENDGAME;
+}
+
+// Fills in results' histograms, one per phase, if it has none yet.
+void AddLatencyHistograms(q2::proto::PlayerResults* results) {
+  if (results->move_latencies_size() > 0) {
+    return;
+  }
+  for (int phase = q2::proto::LatencyHistogram::GamePhase_MIN;
+       phase <= q2::proto::LatencyHistogram::GamePhase_MAX; ++phase) {
+    results->add_move_latencies()->set_phase(
+        static_cast<q2::proto::LatencyHistogram::GamePhase>(phase));
+  }
+}
+
+void AddMoveLatency(const q2::proto::MoveTiming& timing,
+                    q2::proto::PlayerResults* results) {
+  AddLatencyHistograms(results);
+  auto* histogram =
+      results->mutable_move_latencies(GamePhase(timing.num_unseen()));
+  const int64_t micros = std::max<int64_t>(timing.micros(), 0);
+  const int bucket =
+      (micros == 0) ? 0 : static_cast<int>(std::floor(4 * std::log2(micros)));
+  while (histogram->counts_size() <= bucket) {
+    histogram->add_counts(0);
+  }
+  histogram->set_counts(bucket, histogram->counts(bucket) + 1);
+  histogram->set_moves(histogram->moves() + 1);
+  histogram->set_total_micros(histogram->total_micros() + micros);
+  histogram->set_max_micros(std::max(histogram->max_micros(), micros));
+}
+
+void AddLatencyHistogram(const q2::proto::LatencyHistogram& from,
+                         q2::proto::LatencyHistogram* to) {
+  while (to->counts_size() < from.counts_size()) {
+    to->add_counts(0);
+  }
+  for (int i = 0; i < from.counts_size(); ++i) {
+    to->set_counts(i, to->counts(i) + from.counts(i));
+  }
+  to->set_moves(to->moves() + from.moves());
+  to->set_total_micros(to->total_micros() + from.total_micros());
+  to->set_max_micros(std::max(to->max_micros(), from.max_micros()));
+}
+
 void DoGameStats(
-    const q2::proto::GameResult* game, int thread_index, int pair_index,
+    const q2::proto::GameRecord* game, int thread_index, int pair_index,
     std::vector<std::unique_ptr<q2::proto::PlayerResults>>* player_results) {
   int i0 = thread_index * 2;
   int i1 = thread_index * 2 + 1;
@@ -56,10 +117,14 @@ void DoGameStats(
                                       game->micros_remaining(0));
   r1->set_total_time_remaining_micros(r1->total_time_remaining_micros() +
                                       game->micros_remaining(1));
+  for (const auto& timing : game->move_timings()) {
+    AddMoveLatency(timing,
+                   (timing.player_id() == game->player_ids(0)) ? r0 : r1);
+  }
 }
 
 void DoPairStats(
-    const q2::proto::GameResult* g0, const q2::proto::GameResult* g1,
+    const q2::proto::GameRecord* g0, const q2::proto::GameRecord* g1,
     int thread_index,
     std::vector<std::unique_ptr<q2::proto::PlayerResults>>* player_results) {
   int i0 = thread_index * 2;
@@ -120,17 +185,29 @@ void DoPairStats(
 
 void TournamentRunner::RunGames(
     const Tiles& tiles, const BoardLayout& board_layout, int thread_index,
-    int start_index, int num_pairs,
-    std::vector<std::unique_ptr<q2::proto::PlayerResults>>* player_results)
-    const {
-  absl::BitGen gen;
+    std::atomic<int>* next_pair, int end_pair,
+    std::vector<std::unique_ptr<q2::proto::PlayerResults>>* player_results) {
   std::vector<Player*> players;
   for (int i = 0; i < 2; i++) {
     auto& player = players_[thread_index * 2 + i];
     players.push_back(player.get());
   }
-  for (int i = 0; i < num_pairs; i++) {
+  const auto& output_spec = spec_.output_spec();
+  std::unique_ptr<GameRecordWriter> writer;
+  if (!output_spec.records_file().empty()) {
+    writer = GameRecordWriter::Create(output_spec.records_file() + "-" +
+                                      std::to_string(thread_index));
+    CHECK(writer != nullptr);
+  }
+  // Pairs are numbered across all threads, so each game's tile orderings
+  // are its own.
+  for (int i = (*next_pair)++; i < end_pair; i = (*next_pair)++) {
+    if (pair_finished_[i - first_pair_]) {
+      // Played before resuming from a checkpoint.
+      continue;
+    }
     // LOG(INFO) << "Running pair " << i << " on thread " << thread_index;
+    std::mt19937_64 gen = PairGenerator(i);
     Bag bag(tiles);
     bag.Shuffle(gen);
     std::vector<uint16_t> exchange_insertion_dividends;
@@ -138,32 +215,215 @@ void TournamentRunner::RunGames(
       exchange_insertion_dividends.push_back(
           absl::Uniform<uint16_t>(gen, 0, 65535));
     }
-    std::vector<std::unique_ptr<q2::proto::GameResult>> results;
+    std::vector<std::unique_ptr<q2::proto::GameRecord>> results;
     results.resize(2);
     for (int j = 0; j < 2; j++) {
       // LOG(INFO) << "i: " << i << " j: " << j;
       Game game(board_layout, players, tiles, absl::Minutes(25), i);
       game.CreateInitialPosition(bag, exchange_insertion_dividends);
       game.FinishWithComputerPlayers();
-      results[j] = absl::make_unique<q2::proto::GameResult>();
-      game.WriteProto(results[j].get());
+      results[j] = absl::make_unique<q2::proto::GameRecord>();
+      game.WriteRecord(output_spec, results[j].get());
+      if (writer != nullptr) {
+        const absl::Status status = writer->Write(*results[j]);
+        if (!status.ok()) {
+          LOG(ERROR) << status;
+        }
+      }
       std::reverse(players.begin(), players.end());
     }
-    DoGameStats(results[0].get(), thread_index, 0, player_results);
-    DoGameStats(results[1].get(), thread_index, 1, player_results);
-    DoPairStats(results[0].get(), results[1].get(), thread_index,
-                player_results);
     auto* cf = ComponentFactory::GetInstance();
     auto* ordering_provider = cf->GetTileOrderingProvider();
     ordering_provider->RemoveGame(i);
+    {
+      // Under the lock, so early stopping rules can read every thread's
+      // results while games go on.
+      std::lock_guard<std::mutex> lock(progress_mutex_);
+      DoGameStats(results[0].get(), thread_index, 0, player_results);
+      DoGameStats(results[1].get(), thread_index, 1, player_results);
+      DoPairStats(results[0].get(), results[1].get(), thread_index,
+                  player_results);
+      pair_finished_[i - first_pair_] = 1;
+      pairs_finished_++;
+    }
+    progress_cv_.notify_one();
+    if (stop_requested_.load(std::memory_order_relaxed)) {
+      break;
+    }
+  }
+}
 
-    /*
-    if ((thread_index == 0) && (i % 10) == 0) {
-      int thousandths = (1000 * i) / num_pairs;
-      LOG(INFO) << "Progress: " << thousandths << "/1000";
+std::vector<std::unique_ptr<q2::proto::PlayerResults>>
+TournamentRunner::AggregateResults(
+    const std::vector<std::unique_ptr<q2::proto::PlayerResults>>&
+        player_results) {
+  std::vector<std::unique_ptr<q2::proto::PlayerResults>> aggregated_results;
+  aggregated_results.resize(2);
+  for (int i = 0; i < 2; i++) {
+    aggregated_results[i] = absl::make_unique<q2::proto::PlayerResults>();
+  }
+  for (int i = 0; i < player_results.size(); i++) {
+    // LOG(INFO) << "Player " << i
+    //           << " results: " << player_results[i]->DebugString();
+    int target_index = i % 2;
+    auto* p = aggregated_results[target_index].get();
+    p->set_player_id(1 + target_index);
+    AddPlayerResults(*player_results[i], p);
+  }
+  return aggregated_results;
+}
+
+namespace {
+// z such that a standard normal variable is below z with probability p.
+double NormalQuantile(double p) {
+  double lo = -10.0;
+  double hi = 10.0;
+  for (int i = 0; i < 100; ++i) {
+    const double mid = (lo + hi) / 2;
+    if (0.5 * std::erfc(-mid / std::sqrt(2.0)) < p) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return (lo + hi) / 2;
+}
+}  // namespace
+
+q2::proto::EarlyStopConfig::Decision TournamentRunner::CheckEarlyStop(
+    const q2::proto::EarlyStopConfig& config,
+    const q2::proto::PlayerResults& first_player) {
+  // Every pair counts in exactly one of these.
+  const int64_t num_pairs =
+      first_player.mirrored_sweeps() + first_player.mirrored_3quart() +
+      first_player.mirrored_splits() + first_player.mirrored_1quart() +
+      first_player.mirrored_sombreros();
+  const int min_pairs = (config.min_pairs() == 0) ? 100 : config.min_pairs();
+  if (config.rule() == q2::proto::EarlyStopConfig::NONE ||
+      num_pairs < std::max(min_pairs, 2)) {
+    return q2::proto::EarlyStopConfig::UNDECIDED;
+  }
+  // Mean and variance of the first player's spread over a pair.
+  const double sum = first_player.total_mirrored_difference();
+  const double sum_of_squares =
+      first_player.mirrored_score_difference_sum_of_squares();
+  const double mean = sum / num_pairs;
+  const double variance =
+      (sum_of_squares - sum * sum / num_pairs) / (num_pairs - 1);
+  if (variance <= 0) {
+    return q2::proto::EarlyStopConfig::UNDECIDED;
+  }
+  if (config.rule() == q2::proto::EarlyStopConfig::CONFIDENCE_BOUND) {
+    const double confidence =
+        (config.confidence() == 0) ? 0.99 : config.confidence();
+    const double z = NormalQuantile(0.5 + confidence / 2);
+    const double error = z * std::sqrt(variance / num_pairs);
+    if (mean - error > 0) {
+      return q2::proto::EarlyStopConfig::FIRST_PLAYER_AHEAD;
+    } else if (mean + error < 0) {
+      return q2::proto::EarlyStopConfig::SECOND_PLAYER_AHEAD;
+    }
+    return q2::proto::EarlyStopConfig::UNDECIDED;
+  }
+  // SPRT between normal distributions with means spread0 and spread1 and
+  // the variance seen so far.
+  const double alpha = (config.alpha() == 0) ? 0.05 : config.alpha();
+  const double beta = (config.beta() == 0) ? 0.05 : config.beta();
+  const double spread0 = config.spread0();
+  const double spread1 = config.spread1();
+  const double llr = (spread1 - spread0) *
+                     (sum - num_pairs * (spread0 + spread1) / 2) / variance;
+  if (llr >= std::log((1 - beta) / alpha)) {
+    return q2::proto::EarlyStopConfig::SPREAD1_ACCEPTED;
+  } else if (llr <= std::log(beta / (1 - alpha))) {
+    return q2::proto::EarlyStopConfig::SPREAD0_ACCEPTED;
+  }
+  return q2::proto::EarlyStopConfig::UNDECIDED;
+}
+
+std::mt19937_64 TournamentRunner::PairGenerator(int pair_index) const {
+  std::seed_seq seed_seq = {static_cast<uint32_t>(spec_.seed()),
+                            static_cast<uint32_t>(spec_.seed() >> 32),
+                            static_cast<uint32_t>(pair_index)};
+  return std::mt19937_64(seed_seq);
+}
+
+void TournamentRunner::ReportProgress(int num_pairs) const {
+  const absl::Duration elapsed = absl::Now() - start_time_;
+  const int games_finished = pairs_finished_ * 2;
+  const int pairs_played = pairs_finished_ - pairs_resumed_;
+  const double games_per_second =
+      pairs_played * 2 / std::max(absl::ToDoubleSeconds(elapsed), 1e-6);
+  std::stringstream ss;
+  ss << "Progress: " << games_finished << "/" << num_pairs * 2 << " games in "
+     << absl::FormatDuration(absl::Trunc(elapsed, absl::Seconds(1))) << ", "
+     << games_per_second << " games/s";
+  if (pairs_played > 0 && pairs_finished_ < num_pairs &&
+      !stop_requested_.load()) {
+    const absl::Duration remaining =
+        elapsed * (num_pairs - pairs_finished_) / pairs_played;
+    ss << ", finishing in "
+       << absl::FormatDuration(absl::Trunc(remaining, absl::Seconds(1)))
+       << " at "
+       << absl::FormatTime("%H:%M:%S", absl::Now() + remaining,
+                           absl::LocalTimeZone());
+  }
+  LOG(INFO) << ss.str();
+}
+
+q2::proto::TournamentCheckpoint TournamentRunner::MakeCheckpoint(
+    const std::vector<std::unique_ptr<q2::proto::PlayerResults>>&
+        player_results) const {
+  q2::proto::TournamentCheckpoint checkpoint;
+  checkpoint.set_seed(spec_.seed());
+  checkpoint.set_first_pair(first_pair_);
+  int i = 0;
+  while (i < pair_finished_.size() && pair_finished_[i]) {
+    ++i;
+  }
+  checkpoint.set_first_unfinished_pair(first_pair_ + i);
+  for (; i < pair_finished_.size(); ++i) {
+    if (pair_finished_[i]) {
+      checkpoint.add_finished_pairs(first_pair_ + i);
+    }
+  }
+  for (const auto& player_result : AggregateResults(player_results)) {
+    *checkpoint.add_player_results() = *player_result;
+  }
+  return checkpoint;
+}
+
+int TournamentRunner::Resume(
+    const q2::proto::TournamentCheckpoint& checkpoint,
+    std::vector<std::unique_ptr<q2::proto::PlayerResults>>* player_results) {
+  if (checkpoint.seed() != spec_.seed()) {
+    LOG(FATAL) << "Checkpoint seed " << checkpoint.seed()
+               << " doesn't match spec seed " << spec_.seed();
+  }
+  if (checkpoint.first_pair() != first_pair_) {
+    LOG(FATAL) << "Checkpoint starts at pair " << checkpoint.first_pair()
+               << " but this shard starts at pair " << first_pair_;
+  }
+  std::vector<int64_t> finished;
+  for (int64_t i = checkpoint.first_pair();
+       i < checkpoint.first_unfinished_pair(); ++i) {
+    finished.push_back(i);
+  }
+  finished.insert(finished.end(), checkpoint.finished_pairs().begin(),
+                  checkpoint.finished_pairs().end());
+  const int64_t end_pair = first_pair_ + pair_finished_.size();
+  for (const int64_t i : finished) {
+    if (i < first_pair_ || i >= end_pair) {
+      LOG(FATAL) << "Checkpoint pair " << i << " is outside this shard's "
+                 << "pairs " << first_pair_ << " to " << end_pair - 1;
     }
-    */
+    pair_finished_[i - first_pair_] = 1;
   }
+  for (int i = 0; i < checkpoint.player_results_size(); ++i) {
+    AddPlayerResults(checkpoint.player_results(i),
+                     (*player_results)[i % 2].get());
+  }
+  return finished.size();
 }
 
 void TournamentRunner::Run(q2::proto::TournamentResults* tournament_results) {
@@ -182,9 +442,21 @@ void TournamentRunner::Run(q2::proto::TournamentResults* tournament_results) {
   if (spec_.number_of_rounds() < 1) {
     LOG(FATAL) << "At least one round required";
   }
-  if (spec_.number_of_rounds() < 1) {
+  if (spec_.number_of_threads() < 1) {
     LOG(FATAL) << "At least one thread required";
   }
+  const int number_of_shards =
+      (spec_.number_of_shards() == 0) ? 1 : spec_.number_of_shards();
+  if (spec_.shard_index() < 0 || spec_.shard_index() >= number_of_shards) {
+    LOG(FATAL) << "Shard index " << spec_.shard_index()
+               << " out of range for " << number_of_shards << " shards";
+  }
+  if (spec_.early_stop().rule() == q2::proto::EarlyStopConfig::SPRT &&
+      spec_.early_stop().spread1() <= spec_.early_stop().spread0()) {
+    LOG(FATAL) << "SPRT spread1 " << spec_.early_stop().spread1()
+               << " must be greater than spread0 "
+               << spec_.early_stop().spread0();
+  }
   DataManager::GetInstance()->LoadData(data);
 
   const auto& singletons = spec_.singleton_components();
@@ -208,93 +480,361 @@ void TournamentRunner::Run(q2::proto::TournamentResults* tournament_results) {
       *DataManager::GetInstance()->GetBoardLayout(data.board_files(0));
   const auto& tiles =
       *DataManager::GetInstance()->GetTiles(data.tiles_files(0));
+  // Each shard plays its own contiguous range of the pairs.
   const int number_of_pairs = spec_.number_of_rounds() / 2;
-  std::vector<std::unique_ptr<q2::proto::GameResult>> results;
-  results.resize(spec_.number_of_rounds());
+  const int first_pair = static_cast<int64_t>(number_of_pairs) *
+                         spec_.shard_index() / number_of_shards;
+  const int end_pair = static_cast<int64_t>(number_of_pairs) *
+                       (spec_.shard_index() + 1) / number_of_shards;
+  LOG(INFO) << "Shard " << spec_.shard_index() << " of " << number_of_shards
+            << " playing pairs " << first_pair << " to " << end_pair - 1;
+  // Pairs are handed out one at a time rather than split into a block per
+  // thread, since games between simming or endgame-solving players can
+  // vary in length by ten times or more.
+  first_pair_ = first_pair;
+  pair_finished_.assign(end_pair - first_pair, 0);
+  pairs_resumed_ = 0;
+  if (spec_.resume() && !spec_.checkpoint_file().empty()) {
+    if (std::ifstream(spec_.checkpoint_file()).is_open()) {
+      auto checkpoint = ReadCheckpoint(spec_.checkpoint_file());
+      CHECK(checkpoint != nullptr);
+      pairs_resumed_ = Resume(*checkpoint, &player_results);
+      LOG(INFO) << "Resuming with " << pairs_resumed_
+                << " pairs finished from " << spec_.checkpoint_file();
+    } else {
+      LOG(INFO) << "No checkpoint at " << spec_.checkpoint_file()
+                << ", starting from the first pair";
+    }
+  }
+  std::atomic<int> next_pair(first_pair);
+  pairs_finished_ = pairs_resumed_;
+  stop_requested_ = false;
+  start_time_ = absl::Now();
   std::vector<std::thread> threads;
-  const int pairs_per_thread = number_of_pairs / spec_.number_of_threads();
-  const int remainder = number_of_pairs % spec_.number_of_threads();
   LOG(INFO) << "Starting games...";
   for (int i = 0; i < spec_.number_of_threads(); ++i) {
-    int start_index = i * pairs_per_thread;
-    int pairs_to_run = pairs_per_thread;
-    if (i < remainder) {
-      start_index += i;
-      pairs_to_run++;
-    } else {
-      start_index += remainder;
-    }
-    threads.emplace_back([this, &tiles, &board_layout, i, start_index,
-                          pairs_to_run, &player_results]() {
-      RunGames(tiles, board_layout, i, start_index * 2, pairs_to_run,
-               &player_results);
+    threads.emplace_back([this, &tiles, &board_layout, i, &next_pair,
+                          end_pair, &player_results]() {
+      RunGames(tiles, board_layout, i, &next_pair, end_pair, &player_results);
     });
   }
-  // Wait for all threads to finish
+  const int progress_interval_seconds =
+      (spec_.progress_interval_seconds() == 0)
+          ? 30
+          : spec_.progress_interval_seconds();
+  const auto& early_stop = spec_.early_stop();
+  const int check_interval_pairs = (early_stop.check_interval_pairs() == 0)
+                                       ? 1
+                                       : early_stop.check_interval_pairs();
+  const bool checkpointing = !spec_.checkpoint_file().empty();
+  const int checkpoint_interval_seconds =
+      (spec_.checkpoint_interval_seconds() == 0)
+          ? 300
+          : spec_.checkpoint_interval_seconds();
+  const auto write_checkpoint =
+      [this](const q2::proto::TournamentCheckpoint& checkpoint) {
+        const absl::Status status =
+            WriteCheckpoint(checkpoint, spec_.checkpoint_file());
+        if (!status.ok()) {
+          LOG(ERROR) << status;
+        }
+      };
+  const int num_pairs = end_pair - first_pair;
+  auto decision = q2::proto::EarlyStopConfig::UNDECIDED;
+  {
+    std::unique_lock<std::mutex> lock(progress_mutex_);
+    auto next_report = std::chrono::steady_clock::now() +
+                       std::chrono::seconds(progress_interval_seconds);
+    auto next_checkpoint =
+        checkpointing ? std::chrono::steady_clock::now() +
+                            std::chrono::seconds(checkpoint_interval_seconds)
+                      : std::chrono::steady_clock::time_point::max();
+    int next_check = pairs_finished_ + check_interval_pairs;
+    const auto check_due = [&]() {
+      return early_stop.rule() != q2::proto::EarlyStopConfig::NONE &&
+             pairs_finished_ >= next_check;
+    };
+    while (pairs_finished_ < num_pairs) {
+      if (!progress_cv_.wait_until(
+              lock, std::min(next_report, next_checkpoint), [&]() {
+                return pairs_finished_ == num_pairs || check_due();
+              })) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= next_report) {
+          ReportProgress(num_pairs);
+          next_report += std::chrono::seconds(progress_interval_seconds);
+        }
+        if (now >= next_checkpoint) {
+          // Written without the lock so threads can go on recording games.
+          const auto checkpoint = MakeCheckpoint(player_results);
+          lock.unlock();
+          write_checkpoint(checkpoint);
+          lock.lock();
+          next_checkpoint = std::chrono::steady_clock::now() +
+                            std::chrono::seconds(checkpoint_interval_seconds);
+        }
+        continue;
+      }
+      if (check_due()) {
+        next_check = pairs_finished_ + check_interval_pairs;
+        decision =
+            CheckEarlyStop(early_stop, *AggregateResults(player_results)[0]);
+        if (decision != q2::proto::EarlyStopConfig::UNDECIDED) {
+          LOG(INFO) << "Stopping early after " << pairs_finished_
+                    << " pairs: "
+                    << q2::proto::EarlyStopConfig::Decision_Name(decision);
+          stop_requested_ = true;
+          break;
+        }
+      }
+    }
+  }
+  // Wait for all threads to finish, including pairs already started when
+  // stopping early, which are counted too.
   for (auto& thread : threads) {
     thread.join();
   }
+  {
+    std::lock_guard<std::mutex> lock(progress_mutex_);
+    ReportProgress(num_pairs);
+    if (checkpointing) {
+      write_checkpoint(MakeCheckpoint(player_results));
+    }
+  }
   LOG(INFO) << "Finished games!";
-  std::vector<std::unique_ptr<q2::proto::PlayerResults>> aggregated_results;
-  aggregated_results.resize(2);
-  for (int i = 0; i < 2; i++) {
-    aggregated_results[i] = absl::make_unique<q2::proto::PlayerResults>();
+  tournament_results->set_pairs_played(pairs_finished_);
+  tournament_results->set_early_stop_decision(decision);
+  const auto aggregated_results = AggregateResults(player_results);
+  for (const auto& player_result : aggregated_results) {
+    LOG(INFO) << "player_result: " << player_result->DebugString();
   }
-  for (int i = 0; i < player_results.size(); i++) {
-    // LOG(INFO) << "Player " << i
-    //           << " results: " << player_results[i]->DebugString();
-    int target_index = i % 2;
-    auto* p = aggregated_results[target_index].get();
-    p->set_player_id(1 + target_index);
-    p->set_games_started(p->games_started() +
-                         player_results[i]->games_started());
-    p->set_num_wins(p->num_wins() + player_results[i]->num_wins());
-    p->set_num_losses(p->num_losses() + player_results[i]->num_losses());
-    p->set_num_draws(p->num_draws() + player_results[i]->num_draws());
-    p->set_total_score(p->total_score() + player_results[i]->total_score());
-    p->set_total_opponent_score(p->total_opponent_score() +
-                                player_results[i]->total_opponent_score());
-    p->set_score_difference_sum_of_squares(
-        p->score_difference_sum_of_squares() +
-        player_results[i]->score_difference_sum_of_squares());
-    p->set_total_time_used_micros(p->total_time_used_micros() +
-                                  player_results[i]->total_time_used_micros());
-    p->set_total_time_remaining_micros(
-        p->total_time_remaining_micros() +
-        player_results[i]->total_time_remaining_micros());
-    p->set_total_mirrored_difference(
-        p->total_mirrored_difference() +
-        player_results[i]->total_mirrored_difference());
-    p->set_mirrored_sweeps(p->mirrored_sweeps() +
-                           player_results[i]->mirrored_sweeps());
-    p->set_mirrored_3quart(p->mirrored_3quart() +
-                           player_results[i]->mirrored_3quart());
-    p->set_mirrored_splits(p->mirrored_splits() +
-                           player_results[i]->mirrored_splits());
-    p->set_mirrored_1quart(p->mirrored_1quart() +
-                           player_results[i]->mirrored_1quart());
-    p->set_mirrored_sombreros(p->mirrored_sombreros() +
-                              player_results[i]->mirrored_sombreros());
-    p->set_mirrored_with_difference(
-        p->mirrored_with_difference() +
-        player_results[i]->mirrored_with_difference());
-    p->set_mirrored_score_difference_sum_of_squares(
-        p->mirrored_score_difference_sum_of_squares() +
-        player_results[i]->mirrored_score_difference_sum_of_squares());
+  if (!spec_.shard_results_file().empty()) {
+    q2::proto::ShardResults shard;
+    shard.set_shard_index(spec_.shard_index());
+    shard.set_number_of_shards(number_of_shards);
+    shard.set_first_pair(first_pair);
+    shard.set_number_of_pairs(pairs_finished_);
+    for (const auto& player_result : aggregated_results) {
+      *shard.add_player_results() = *player_result;
+    }
+    const absl::Status status =
+        WriteShardResults(shard, spec_.shard_results_file());
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+    }
   }
   for (const auto& player_result : aggregated_results) {
-    LOG(INFO) << "player_result: " << player_result->DebugString();
+    *tournament_results->add_player_results() = *player_result;
   }
   std::vector<std::unique_ptr<q2::proto::PlayerAverages>> averages;
   ComputeAverages(aggregated_results, &averages);
   for (const auto& average : averages) {
     tournament_results->add_player_averages()->CopyFrom(*average);
   }
+  if (!spec_.output_spec().latency_file().empty()) {
+    const absl::Status status = WriteLatencyCsv(
+        *tournament_results, spec_.output_spec().latency_file());
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+    }
+  }
+}
+
+void TournamentRunner::AddPlayerResults(const q2::proto::PlayerResults& from,
+                                        q2::proto::PlayerResults* p) {
+  p->set_games_started(p->games_started() + from.games_started());
+  p->set_num_wins(p->num_wins() + from.num_wins());
+  p->set_num_losses(p->num_losses() + from.num_losses());
+  p->set_num_draws(p->num_draws() + from.num_draws());
+  p->set_total_score(p->total_score() + from.total_score());
+  p->set_total_opponent_score(p->total_opponent_score() +
+                              from.total_opponent_score());
+  p->set_score_difference_sum_of_squares(
+      p->score_difference_sum_of_squares() +
+      from.score_difference_sum_of_squares());
+  p->set_total_time_used_micros(p->total_time_used_micros() +
+                                from.total_time_used_micros());
+  p->set_total_time_remaining_micros(p->total_time_remaining_micros() +
+                                     from.total_time_remaining_micros());
+  p->set_total_mirrored_difference(p->total_mirrored_difference() +
+                                   from.total_mirrored_difference());
+  p->set_mirrored_sweeps(p->mirrored_sweeps() + from.mirrored_sweeps());
+  p->set_mirrored_3quart(p->mirrored_3quart() + from.mirrored_3quart());
+  p->set_mirrored_splits(p->mirrored_splits() + from.mirrored_splits());
+  p->set_mirrored_1quart(p->mirrored_1quart() + from.mirrored_1quart());
+  p->set_mirrored_sombreros(p->mirrored_sombreros() +
+                            from.mirrored_sombreros());
+  p->set_mirrored_with_difference(p->mirrored_with_difference() +
+                                  from.mirrored_with_difference());
+  p->set_mirrored_score_difference_sum_of_squares(
+      p->mirrored_score_difference_sum_of_squares() +
+      from.mirrored_score_difference_sum_of_squares());
+  if (from.move_latencies_size() > 0) {
+    AddLatencyHistograms(p);
+    for (const auto& histogram : from.move_latencies()) {
+      AddLatencyHistogram(histogram,
+                          p->mutable_move_latencies(histogram.phase()));
+    }
+  }
+}
+
+int64_t TournamentRunner::LatencyPercentile(
+    const q2::proto::LatencyHistogram& histogram, double fraction) {
+  const int64_t target = std::max<int64_t>(
+      1, static_cast<int64_t>(std::ceil(fraction * histogram.moves())));
+  int64_t seen = 0;
+  for (int i = 0; i < histogram.counts_size(); ++i) {
+    seen += histogram.counts(i);
+    if (seen >= target) {
+      const int64_t upper = std::ceil(std::exp2((i + 1) / 4.0));
+      return std::min(upper, histogram.max_micros());
+    }
+  }
+  return histogram.max_micros();
+}
+
+absl::Status TournamentRunner::WriteLatencyCsv(
+    const q2::proto::TournamentResults& results, const std::string& filename) {
+  std::ofstream file(filename, std::ios::out);
+  if (!file.is_open()) {
+    return absl::NotFoundError("Could not open file " + filename);
+  }
+  file << "player_id,phase,moves,average_micros,p50_micros,p90_micros,"
+          "p99_micros,max_micros\n";
+  for (const auto& averages : results.player_averages()) {
+    for (const auto& latencies : averages.move_latencies()) {
+      file << averages.player_id() << ","
+           << q2::proto::LatencyHistogram::GamePhase_Name(latencies.phase())
+           << "," << latencies.moves() << "," << latencies.average_micros()
+           << "," << latencies.p50_micros() << "," << latencies.p90_micros()
+           << "," << latencies.p99_micros() << "," << latencies.max_micros()
+           << "\n";
+    }
+  }
+  file.close();
+  if (file.fail()) {
+    return absl::InternalError("Could not write to file " + filename);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status TournamentRunner::WriteShardResults(
+    const q2::proto::ShardResults& shard, const std::string& filename) {
+  std::ofstream file(filename, std::ios::out | std::ios::binary);
+  if (!file.is_open()) {
+    return absl::NotFoundError("Could not open file " + filename);
+  }
+  if (!shard.SerializeToOstream(&file)) {
+    return absl::InternalError("Could not write to file " + filename);
+  }
+  return absl::OkStatus();
+}
+
+std::unique_ptr<q2::proto::ShardResults> TournamentRunner::ReadShardResults(
+    const std::string& filename) {
+  std::ifstream file(filename, std::ios::in | std::ios::binary);
+  if (!file.is_open()) {
+    LOG(ERROR) << "Could not open file " << filename;
+    return nullptr;
+  }
+  auto shard = absl::make_unique<q2::proto::ShardResults>();
+  if (!shard->ParseFromIstream(&file)) {
+    LOG(ERROR) << "Could not parse shard results from " << filename;
+    return nullptr;
+  }
+  return shard;
+}
+
+absl::Status TournamentRunner::WriteCheckpoint(
+    const q2::proto::TournamentCheckpoint& checkpoint,
+    const std::string& filename) {
+  const std::string temp_filename = filename + ".tmp";
+  {
+    std::ofstream file(temp_filename, std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+      return absl::NotFoundError("Could not open file " + temp_filename);
+    }
+    if (!checkpoint.SerializeToOstream(&file)) {
+      return absl::InternalError("Could not write to file " + temp_filename);
+    }
+    file.close();
+    if (file.fail()) {
+      return absl::InternalError("Could not write to file " + temp_filename);
+    }
+  }
+  if (std::rename(temp_filename.c_str(), filename.c_str()) != 0) {
+    return absl::InternalError("Could not rename " + temp_filename + " to " +
+                               filename);
+  }
+  return absl::OkStatus();
+}
+
+std::unique_ptr<q2::proto::TournamentCheckpoint>
+TournamentRunner::ReadCheckpoint(const std::string& filename) {
+  std::ifstream file(filename, std::ios::in | std::ios::binary);
+  if (!file.is_open()) {
+    LOG(ERROR) << "Could not open file " << filename;
+    return nullptr;
+  }
+  auto checkpoint = absl::make_unique<q2::proto::TournamentCheckpoint>();
+  if (!checkpoint->ParseFromIstream(&file)) {
+    LOG(ERROR) << "Could not parse checkpoint from " << filename;
+    return nullptr;
+  }
+  return checkpoint;
+}
+
+void TournamentRunner::MergeShards(
+    const std::vector<q2::proto::ShardResults>& shards,
+    q2::proto::TournamentResults* tournament_results) {
+  std::vector<std::unique_ptr<q2::proto::PlayerResults>> merged_results;
+  std::vector<bool> merged_shards;
+  for (const auto& shard : shards) {
+    if (merged_shards.empty()) {
+      merged_shards.resize(shard.number_of_shards());
+    }
+    if (shard.number_of_shards() != merged_shards.size() ||
+        shard.shard_index() < 0 ||
+        shard.shard_index() >= merged_shards.size()) {
+      LOG(ERROR) << "Skipping shard " << shard.shard_index() << " of "
+                 << shard.number_of_shards() << ", expected one of "
+                 << merged_shards.size();
+      continue;
+    }
+    if (merged_shards[shard.shard_index()]) {
+      LOG(ERROR) << "Skipping repeated shard " << shard.shard_index();
+      continue;
+    }
+    merged_shards[shard.shard_index()] = true;
+    for (int i = 0; i < shard.player_results_size(); ++i) {
+      if (i == merged_results.size()) {
+        merged_results.push_back(
+            absl::make_unique<q2::proto::PlayerResults>());
+        merged_results.back()->set_player_id(
+            shard.player_results(i).player_id());
+      }
+      AddPlayerResults(shard.player_results(i), merged_results[i].get());
+    }
+  }
+  for (int i = 0; i < merged_shards.size(); ++i) {
+    if (!merged_shards[i]) {
+      LOG(WARNING) << "Shard " << i << " of " << merged_shards.size()
+                   << " is missing, so its games are left out";
+    }
+  }
+  for (const auto& player_result : merged_results) {
+    *tournament_results->add_player_results() = *player_result;
+  }
+  std::vector<std::unique_ptr<q2::proto::PlayerAverages>> averages;
+  ComputeAverages(merged_results, &averages);
+  for (const auto& average : averages) {
+    tournament_results->add_player_averages()->CopyFrom(*average);
+  }
 }
 
 void TournamentRunner::ComputeAverages(
     const std::vector<std::unique_ptr<q2::proto::PlayerResults>>& results,
-    std::vector<std::unique_ptr<q2::proto::PlayerAverages>>* averages) const {
+    std::vector<std::unique_ptr<q2::proto::PlayerAverages>>* averages) {
   averages->reserve(results.size());
   for (const auto& result : results) {
     averages->emplace_back(absl::make_unique<q2::proto::PlayerAverages>());
@@ -335,5 +875,19 @@ void TournamentRunner::ComputeAverages(
       a->set_mirrored_confidence_upper_bound(a->average_score_difference() +
                                              mirrored_error);
     }
+    for (const auto& histogram : result->move_latencies()) {
+      if (histogram.moves() == 0) {
+        continue;
+      }
+      auto* latencies = a->add_move_latencies();
+      latencies->set_phase(histogram.phase());
+      latencies->set_moves(histogram.moves());
+      latencies->set_average_micros(
+          static_cast<float>(histogram.total_micros()) / histogram.moves());
+      latencies->set_p50_micros(LatencyPercentile(histogram, 0.5));
+      latencies->set_p90_micros(LatencyPercentile(histogram, 0.9));
+      latencies->set_p99_micros(LatencyPercentile(histogram, 0.99));
+      latencies->set_max_micros(histogram.max_micros());
+    }
   }
 }
\ No newline at end of file
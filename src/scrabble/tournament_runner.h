@@ -1,6 +1,14 @@
 #ifndef SRC_SCRABBLE_TOURNAMENT_RUNNER_H
 #define SRC_SCRABBLE_TOURNAMENT_RUNNER_H
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/time/time.h"
 #include "src/scrabble/computer_player.h"
 #include "src/scrabble/computer_players.pb.h"
 
@@ -8,18 +16,106 @@ class TournamentRunner {
  public:
   explicit TournamentRunner(const q2::proto::TournamentSpec& spec)
       : spec_(spec) {}
+  // Plays pairs with thread_index's own players, taking the next pair to
+  // play from next_pair until it reaches end_pair, so threads that draw
+  // quick games play more of them.
   void RunGames(const Tiles& tiles, const BoardLayout& board_layout,
-                int thread_index, int start_index, int num_pairs,
+                int thread_index, std::atomic<int>* next_pair, int end_pair,
                 std::vector<std::unique_ptr<q2::proto::PlayerResults>>*
-                    player_results) const;
-  void ComputeAverages(
+                    player_results);
+  static void ComputeAverages(
       const std::vector<std::unique_ptr<q2::proto::PlayerResults>>& results,
-      std::vector<std::unique_ptr<q2::proto::PlayerAverages>>* averages) const;
+      std::vector<std::unique_ptr<q2::proto::PlayerAverages>>* averages);
   void Run(q2::proto::TournamentResults* results);
 
+  // Whether first_player's results so far settle the match, by config's
+  // rule, going by the score difference of each mirrored pair. Rules are
+  // checked repeatedly, so the confidence bound is more likely to stop on
+  // a chance lead than its level suggests; SPRT's error rates allow for
+  // that.
+  static q2::proto::EarlyStopConfig::Decision CheckEarlyStop(
+      const q2::proto::EarlyStopConfig& config,
+      const q2::proto::PlayerResults& first_player);
+
+  // Adds every count and total in from to to, leaving its player_id alone.
+  static void AddPlayerResults(const q2::proto::PlayerResults& from,
+                               q2::proto::PlayerResults* to);
+  static absl::Status WriteShardResults(const q2::proto::ShardResults& shard,
+                                        const std::string& filename);
+  // Returns nullptr if filename can't be read.
+  static std::unique_ptr<q2::proto::ShardResults> ReadShardResults(
+      const std::string& filename);
+  // Sums the results of a tournament's shards and computes averages as Run
+  // would have for the whole tournament. Shards that don't belong with the
+  // first one, or repeat one already merged, are skipped, and missing
+  // shards are logged.
+  static void MergeShards(const std::vector<q2::proto::ShardResults>& shards,
+                          q2::proto::TournamentResults* tournament_results);
+
+  // Upper end of the histogram bucket holding the move at fraction of the
+  // way through its moves by latency, capped at the slowest move.
+  static int64_t LatencyPercentile(const q2::proto::LatencyHistogram& histogram,
+                                   double fraction);
+  // Writes the move latencies in results' PlayerAverages as CSV.
+  static absl::Status WriteLatencyCsv(
+      const q2::proto::TournamentResults& results,
+      const std::string& filename);
+
+  // Writes to a temporary file first and renames it over filename, so an
+  // interrupted write leaves the previous checkpoint in place.
+  static absl::Status WriteCheckpoint(
+      const q2::proto::TournamentCheckpoint& checkpoint,
+      const std::string& filename);
+  // Returns nullptr if filename can't be read.
+  static std::unique_ptr<q2::proto::TournamentCheckpoint> ReadCheckpoint(
+      const std::string& filename);
+
  private:
+  // Generates pair_index's bag order and exchange insertion dividends, the
+  // same whichever shard or thread plays it.
+  std::mt19937_64 PairGenerator(int pair_index) const;
+
+  // Sums each thread's results into one PlayerResults per player in the
+  // spec.
+  static std::vector<std::unique_ptr<q2::proto::PlayerResults>>
+  AggregateResults(const std::vector<std::unique_ptr<q2::proto::PlayerResults>>&
+                       player_results);
+
+  // Logs games finished, games per second and when the tournament should
+  // finish at that rate. Called with progress_mutex_ held.
+  void ReportProgress(int num_pairs) const;
+
+  // Finished pairs and their results so far. Called with progress_mutex_
+  // held.
+  q2::proto::TournamentCheckpoint MakeCheckpoint(
+      const std::vector<std::unique_ptr<q2::proto::PlayerResults>>&
+          player_results) const;
+
+  // Adds checkpoint's results to thread 0's and marks its pairs finished.
+  // Returns the number of pairs resumed.
+  int Resume(const q2::proto::TournamentCheckpoint& checkpoint,
+             std::vector<std::unique_ptr<q2::proto::PlayerResults>>*
+                 player_results);
+
   const q2::proto::TournamentSpec& spec_;
   std::vector<std::unique_ptr<ComputerPlayer>> players_;
+
+  // Pairs finished by all threads, and the threads' PlayerResults, guarded
+  // by progress_mutex_. Finished pairs are signalled on progress_cv_.
+  std::mutex progress_mutex_;
+  std::condition_variable progress_cv_;
+  int pairs_finished_ = 0;
+  absl::Time start_time_;
+  // Whether each of the shard's pairs, from first_pair_, is finished. Set
+  // under progress_mutex_, but a pair's entry is only written by the
+  // thread playing it, so threads check theirs without the lock.
+  int first_pair_ = 0;
+  std::vector<char> pair_finished_;
+  // Pairs finished before this run, which don't count towards its rate.
+  int pairs_resumed_ = 0;
+  // Set when an early stopping rule has decided the match. Threads finish
+  // the pair they're playing and take no more.
+  std::atomic<bool> stop_requested_{false};
 };
 
 #endif  // SRC_SCRABBLE_TOURNAMENT_RUNNER_H
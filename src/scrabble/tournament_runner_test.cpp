@@ -2,6 +2,9 @@
 
 #include <google/protobuf/text_format.h>
 
+#include <cstdio>
+#include <fstream>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "src/scrabble/alpha_beta_player.h"
@@ -329,6 +332,411 @@ TEST_F(TournamentRunnerTest, HeadsUpMirroredSpecializing) {
 }
 */
 
+TEST_F(TournamentRunnerTest, MoreThreadsThanPairs) {
+  // Pairs are handed out as threads ask for them, so a thread can end up
+  // with none.
+  Arena arena;
+  auto spec = Arena::CreateMessage<q2::proto::TournamentSpec>(&arena);
+  google::protobuf::TextFormat::ParseFromString(R"(
+        data_collection {
+          tiles_files: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+          board_files: "src/scrabble/testdata/scrabble_board.textproto"
+        }
+        singleton_components {
+          tile_ordering_provider_config {
+            tile_ordering_cache_config {
+              tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+            }
+          }
+        }
+        number_of_rounds: 6
+        number_of_threads: 4
+        players {
+          passing_player_config {
+            id: 1
+            name: "Passer 1"
+            nickname: "P1"
+          }
+        }
+        players {
+          passing_player_config {
+            id: 2
+            name: "Passer 2"
+            nickname: "P2"
+          }
+        }
+    )",
+                                                spec);
+  TournamentRunner runner(*spec);
+  auto results = Arena::CreateMessage<q2::proto::TournamentResults>(&arena);
+  runner.Run(results);
+  ASSERT_EQ(results->player_averages_size(), 2);
+  EXPECT_FLOAT_EQ(results->player_averages(0).average_score_difference(),
+                  -results->player_averages(1).average_score_difference());
+}
+
+TEST_F(TournamentRunnerTest, MergeShards) {
+  // Passing players' scores come down to their racks, which are the same
+  // for a pair wherever it is played.
+  Arena arena;
+  auto spec = Arena::CreateMessage<q2::proto::TournamentSpec>(&arena);
+  google::protobuf::TextFormat::ParseFromString(R"(
+        data_collection {
+          tiles_files: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+          board_files: "src/scrabble/testdata/scrabble_board.textproto"
+        }
+        singleton_components {
+          tile_ordering_provider_config {
+            tile_ordering_cache_config {
+              tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+            }
+          }
+        }
+        number_of_rounds: 10
+        number_of_threads: 2
+        seed: 12345
+        players {
+          passing_player_config {
+            id: 1
+            name: "Passer 1"
+            nickname: "P1"
+          }
+        }
+        players {
+          passing_player_config {
+            id: 2
+            name: "Passer 2"
+            nickname: "P2"
+          }
+        }
+    )",
+                                                spec);
+  auto whole = Arena::CreateMessage<q2::proto::TournamentResults>(&arena);
+  {
+    TournamentRunner runner(*spec);
+    runner.Run(whole);
+  }
+  std::vector<q2::proto::ShardResults> shards;
+  for (int shard_index = 0; shard_index < 3; ++shard_index) {
+    auto shard_spec = Arena::CreateMessage<q2::proto::TournamentSpec>(&arena);
+    *shard_spec = *spec;
+    shard_spec->set_number_of_shards(3);
+    shard_spec->set_shard_index(shard_index);
+    shard_spec->set_shard_results_file(::testing::TempDir() + "/shard_" +
+                                       std::to_string(shard_index));
+    TournamentRunner runner(*shard_spec);
+    auto results = Arena::CreateMessage<q2::proto::TournamentResults>(&arena);
+    runner.Run(results);
+    auto shard =
+        TournamentRunner::ReadShardResults(shard_spec->shard_results_file());
+    ASSERT_NE(shard, nullptr);
+    EXPECT_EQ(shard->shard_index(), shard_index);
+    shards.push_back(*shard);
+  }
+  // 5 pairs split 1, 2, 2.
+  EXPECT_EQ(shards[0].number_of_pairs(), 1);
+  EXPECT_EQ(shards[1].first_pair(), 1);
+  EXPECT_EQ(shards[2].number_of_pairs(), 2);
+  auto merged = Arena::CreateMessage<q2::proto::TournamentResults>(&arena);
+  TournamentRunner::MergeShards(shards, merged);
+  ASSERT_EQ(merged->player_results_size(), 2);
+  for (int i = 0; i < 2; ++i) {
+    const auto& a = whole->player_results(i);
+    const auto& b = merged->player_results(i);
+    EXPECT_EQ(b.num_wins() + b.num_losses() + b.num_draws(), 10);
+    EXPECT_EQ(b.num_wins(), a.num_wins());
+    EXPECT_EQ(b.total_score(), a.total_score());
+    EXPECT_EQ(b.total_mirrored_difference(), a.total_mirrored_difference());
+    EXPECT_FLOAT_EQ(merged->player_averages(i).average_score(),
+                    whole->player_averages(i).average_score());
+  }
+}
+
+TEST_F(TournamentRunnerTest, ResumeFromCheckpoint) {
+  // A tournament of 2 pairs, checkpointed and then extended to 5, ends up
+  // with the same results as playing all 5 at once.
+  Arena arena;
+  auto spec = Arena::CreateMessage<q2::proto::TournamentSpec>(&arena);
+  google::protobuf::TextFormat::ParseFromString(R"(
+        data_collection {
+          tiles_files: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+          board_files: "src/scrabble/testdata/scrabble_board.textproto"
+        }
+        singleton_components {
+          tile_ordering_provider_config {
+            tile_ordering_cache_config {
+              tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+            }
+          }
+        }
+        number_of_rounds: 10
+        number_of_threads: 2
+        seed: 12345
+        players {
+          passing_player_config {
+            id: 1
+            name: "Passer 1"
+            nickname: "P1"
+          }
+        }
+        players {
+          passing_player_config {
+            id: 2
+            name: "Passer 2"
+            nickname: "P2"
+          }
+        }
+    )",
+                                                spec);
+  auto whole = Arena::CreateMessage<q2::proto::TournamentResults>(&arena);
+  {
+    TournamentRunner runner(*spec);
+    runner.Run(whole);
+  }
+  const std::string checkpoint_file = ::testing::TempDir() + "/checkpoint";
+  std::remove(checkpoint_file.c_str());
+  auto partial_spec = Arena::CreateMessage<q2::proto::TournamentSpec>(&arena);
+  *partial_spec = *spec;
+  partial_spec->set_number_of_rounds(4);
+  partial_spec->set_checkpoint_file(checkpoint_file);
+  partial_spec->set_resume(true);
+  {
+    TournamentRunner runner(*partial_spec);
+    auto results = Arena::CreateMessage<q2::proto::TournamentResults>(&arena);
+    runner.Run(results);
+  }
+  const auto checkpoint = TournamentRunner::ReadCheckpoint(checkpoint_file);
+  ASSERT_NE(checkpoint, nullptr);
+  EXPECT_EQ(checkpoint->first_unfinished_pair(), 2);
+  EXPECT_EQ(checkpoint->finished_pairs_size(), 0);
+  ASSERT_EQ(checkpoint->player_results_size(), 2);
+
+  auto resumed_spec = Arena::CreateMessage<q2::proto::TournamentSpec>(&arena);
+  *resumed_spec = *partial_spec;
+  resumed_spec->set_number_of_rounds(10);
+  auto resumed = Arena::CreateMessage<q2::proto::TournamentResults>(&arena);
+  {
+    TournamentRunner runner(*resumed_spec);
+    runner.Run(resumed);
+  }
+  EXPECT_EQ(resumed->pairs_played(), 5);
+  ASSERT_EQ(resumed->player_results_size(), 2);
+  for (int i = 0; i < 2; ++i) {
+    const auto& a = whole->player_results(i);
+    const auto& b = resumed->player_results(i);
+    EXPECT_EQ(b.num_wins() + b.num_losses() + b.num_draws(), 10);
+    EXPECT_EQ(b.num_wins(), a.num_wins());
+    EXPECT_EQ(b.total_score(), a.total_score());
+    EXPECT_EQ(b.total_opponent_score(), a.total_opponent_score());
+  }
+  EXPECT_EQ(TournamentRunner::ReadCheckpoint(checkpoint_file)
+                ->first_unfinished_pair(),
+            5);
+}
+
+TEST_F(TournamentRunnerTest, MoveLatencies) {
+  // Each passer passes three times a game, all in the opening. The deadwood
+  // penalties that end the game aren't timed.
+  Arena arena;
+  auto spec = Arena::CreateMessage<q2::proto::TournamentSpec>(&arena);
+  google::protobuf::TextFormat::ParseFromString(R"(
+        data_collection {
+          tiles_files: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+          board_files: "src/scrabble/testdata/scrabble_board.textproto"
+        }
+        singleton_components {
+          tile_ordering_provider_config {
+            tile_ordering_cache_config {
+              tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+            }
+          }
+        }
+        number_of_rounds: 10
+        number_of_threads: 2
+        players {
+          passing_player_config {
+            id: 1
+            name: "Passer 1"
+            nickname: "P1"
+          }
+        }
+        players {
+          passing_player_config {
+            id: 2
+            name: "Passer 2"
+            nickname: "P2"
+          }
+        }
+    )",
+                                                spec);
+  const std::string latency_file = ::testing::TempDir() + "/latencies.csv";
+  spec->mutable_output_spec()->set_latency_file(latency_file);
+  TournamentRunner runner(*spec);
+  auto results = Arena::CreateMessage<q2::proto::TournamentResults>(&arena);
+  runner.Run(results);
+  ASSERT_EQ(results->player_results_size(), 2);
+  ASSERT_EQ(results->player_results(0).move_latencies_size(), 4);
+  const auto& opening = results->player_results(0).move_latencies(
+      q2::proto::LatencyHistogram::OPENING);
+  EXPECT_EQ(opening.moves(), 30);
+  int64_t counted = 0;
+  for (const int64_t count : opening.counts()) {
+    counted += count;
+  }
+  EXPECT_EQ(counted, 30);
+  EXPECT_EQ(results->player_results(0)
+                .move_latencies(q2::proto::LatencyHistogram::ENDGAME)
+                .moves(),
+            0);
+  ASSERT_EQ(results->player_averages(0).move_latencies_size(), 1);
+  const auto& latencies = results->player_averages(0).move_latencies(0);
+  EXPECT_EQ(latencies.phase(), q2::proto::LatencyHistogram::OPENING);
+  EXPECT_EQ(latencies.moves(), 30);
+  EXPECT_LE(latencies.p50_micros(), latencies.p90_micros());
+  EXPECT_LE(latencies.p99_micros(), latencies.max_micros());
+
+  std::ifstream file(latency_file);
+  std::string line;
+  ASSERT_TRUE(std::getline(file, line));
+  EXPECT_EQ(line,
+            "player_id,phase,moves,average_micros,p50_micros,p90_micros,"
+            "p99_micros,max_micros");
+  ASSERT_TRUE(std::getline(file, line));
+  EXPECT_EQ(line.substr(0, 13), "1,OPENING,30,");
+}
+
+TEST_F(TournamentRunnerTest, LatencyPercentile) {
+  // Bucket i holds latencies from 2^(i/4) up to 2^((i+1)/4) micros. 90
+  // moves in bucket 40 (1024 to 1217 micros) and 10 in bucket 53 (9741 to
+  // 11585).
+  q2::proto::LatencyHistogram histogram;
+  for (int i = 0; i <= 53; ++i) {
+    histogram.add_counts(0);
+  }
+  histogram.set_counts(40, 90);
+  histogram.set_counts(53, 10);
+  histogram.set_moves(100);
+  histogram.set_max_micros(10000);
+  EXPECT_EQ(TournamentRunner::LatencyPercentile(histogram, 0.5), 1218);
+  EXPECT_EQ(TournamentRunner::LatencyPercentile(histogram, 0.9), 1218);
+  EXPECT_EQ(TournamentRunner::LatencyPercentile(histogram, 0.99), 10000);
+}
+
+namespace {
+// Results of num_pairs pairs, alternating spreads of mean - 10 and
+// mean + 10 for the first player.
+q2::proto::PlayerResults PairResults(int num_pairs, int mean) {
+  q2::proto::PlayerResults results;
+  results.set_mirrored_splits(num_pairs);
+  results.set_total_mirrored_difference(num_pairs * mean);
+  results.set_mirrored_score_difference_sum_of_squares(
+      num_pairs / 2 * ((mean - 10) * (mean - 10) + (mean + 10) * (mean + 10)));
+  return results;
+}
+}  // namespace
+
+TEST_F(TournamentRunnerTest, CheckEarlyStop) {
+  q2::proto::EarlyStopConfig config;
+  EXPECT_EQ(TournamentRunner::CheckEarlyStop(config, PairResults(100, 10)),
+            q2::proto::EarlyStopConfig::UNDECIDED);
+
+  // The standard error of the mean is about 1 point.
+  config.set_rule(q2::proto::EarlyStopConfig::CONFIDENCE_BOUND);
+  EXPECT_EQ(TournamentRunner::CheckEarlyStop(config, PairResults(100, 10)),
+            q2::proto::EarlyStopConfig::FIRST_PLAYER_AHEAD);
+  EXPECT_EQ(TournamentRunner::CheckEarlyStop(config, PairResults(100, -10)),
+            q2::proto::EarlyStopConfig::SECOND_PLAYER_AHEAD);
+  EXPECT_EQ(TournamentRunner::CheckEarlyStop(config, PairResults(100, 2)),
+            q2::proto::EarlyStopConfig::UNDECIDED);
+  config.set_confidence(0.9);
+  EXPECT_EQ(TournamentRunner::CheckEarlyStop(config, PairResults(100, 2)),
+            q2::proto::EarlyStopConfig::FIRST_PLAYER_AHEAD);
+  // Too few pairs to go by.
+  EXPECT_EQ(TournamentRunner::CheckEarlyStop(config, PairResults(50, 10)),
+            q2::proto::EarlyStopConfig::UNDECIDED);
+  config.set_min_pairs(50);
+  EXPECT_EQ(TournamentRunner::CheckEarlyStop(config, PairResults(50, 10)),
+            q2::proto::EarlyStopConfig::FIRST_PLAYER_AHEAD);
+
+  config.set_rule(q2::proto::EarlyStopConfig::SPRT);
+  config.set_spread0(0);
+  config.set_spread1(10);
+  EXPECT_EQ(TournamentRunner::CheckEarlyStop(config, PairResults(100, 10)),
+            q2::proto::EarlyStopConfig::SPREAD1_ACCEPTED);
+  EXPECT_EQ(TournamentRunner::CheckEarlyStop(config, PairResults(100, 0)),
+            q2::proto::EarlyStopConfig::SPREAD0_ACCEPTED);
+  config.set_spread1(0.5);
+  EXPECT_EQ(TournamentRunner::CheckEarlyStop(config, PairResults(100, 0)),
+            q2::proto::EarlyStopConfig::UNDECIDED);
+}
+
+TEST_F(TournamentRunnerTest, StopEarly) {
+  // A static player is far enough ahead of a passing one for SPRT to accept
+  // spread1 long before all the pairs are played.
+  Arena arena;
+  auto spec = Arena::CreateMessage<q2::proto::TournamentSpec>(&arena);
+  google::protobuf::TextFormat::ParseFromString(R"(
+        data_collection {
+          tiles_files: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+          board_files: "src/scrabble/testdata/scrabble_board.textproto"
+          anagram_map_file_specs {
+            anagram_map_filename: "src/scrabble/testdata/csw21.qam"
+            tiles_filename: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+          }
+          leaves_file_specs {
+            leaves_filename: "src/scrabble/testdata/csw_scrabble_macondo.qlv"
+            tiles_filename: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+          }
+        }
+        singleton_components {
+          tile_ordering_provider_config {
+            tile_ordering_cache_config {
+              tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+            }
+          }
+        }
+        number_of_rounds: 200
+        number_of_threads: 2
+        seed: 12345
+        early_stop {
+          rule: SPRT
+          min_pairs: 5
+          spread0: 0
+          spread1: 100
+        }
+        players {
+          static_player_config {
+            id: 1
+            name: "Static"
+            nickname: "S"
+            anagram_map_file: "src/scrabble/testdata/csw21.qam"
+            board_layout_file: "src/scrabble/testdata/scrabble_board.textproto"
+            tiles_file: "src/scrabble/testdata/english_scrabble_tiles.textproto"
+            leaves_file: "src/scrabble/testdata/csw_scrabble_macondo.qlv"
+          }
+        }
+        players {
+          passing_player_config {
+            id: 2
+            name: "Passer"
+            nickname: "P"
+          }
+        }
+    )",
+                                                spec);
+  TournamentRunner runner(*spec);
+  auto results = Arena::CreateMessage<q2::proto::TournamentResults>(&arena);
+  runner.Run(results);
+  EXPECT_EQ(results->early_stop_decision(),
+            q2::proto::EarlyStopConfig::SPREAD1_ACCEPTED);
+  EXPECT_GE(results->pairs_played(), 5);
+  EXPECT_LT(results->pairs_played(), 100);
+  ASSERT_EQ(results->player_results_size(), 2);
+  const auto& first = results->player_results(0);
+  EXPECT_EQ(first.num_wins() + first.num_losses() + first.num_draws(),
+            2 * results->pairs_played());
+}
+
 TEST_F(TournamentRunnerTest, HeadsUpMirroredSpecializingMvQ) {
   Arena arena;
   auto spec = Arena::CreateMessage<q2::proto::TournamentSpec>(&arena);
@@ -0,0 +1,77 @@
+#include "src/scrabble/transposition_table.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "glog/logging.h"
+
+constexpr int TranspositionTable::kMaxDepth;
+
+namespace {
+// Packed data: value bits in 0-31, depth in 32-39, bound in 40-41, best move
+// index + 1 in 42-57 and a set bit 63, so no stored data is zero.
+constexpr uint64_t kValid = 1ULL << 63;
+constexpr int kMaxMoveIndex = 0xfffe;
+}  // namespace
+
+TranspositionTable::TranspositionTable(int log2_num_slots)
+    : mask_((1ULL << log2_num_slots) - 1) {
+  CHECK_GE(log2_num_slots, 1);
+  CHECK_LE(log2_num_slots, 32);
+  slots_.reset(new Slot[NumSlots()]);
+  Clear();
+}
+
+void TranspositionTable::Clear() {
+  for (uint64_t i = 0; i < NumSlots(); ++i) {
+    slots_[i].checked_key.store(0, std::memory_order_relaxed);
+    slots_[i].data.store(0, std::memory_order_relaxed);
+  }
+}
+
+uint64_t TranspositionTable::Pack(const Entry& entry) {
+  uint32_t value_bits;
+  std::memcpy(&value_bits, &entry.value, sizeof(value_bits));
+  const uint64_t depth = std::min(std::max(entry.depth, 0), kMaxDepth);
+  const uint64_t move_index =
+      (entry.best_move_index < 0 || entry.best_move_index > kMaxMoveIndex)
+          ? 0
+          : entry.best_move_index + 1;
+  return kValid | value_bits | (depth << 32) |
+         (static_cast<uint64_t>(entry.bound) << 40) | (move_index << 42);
+}
+
+TranspositionTable::Entry TranspositionTable::Unpack(uint64_t data) {
+  Entry entry;
+  const uint32_t value_bits = data & 0xffffffff;
+  std::memcpy(&entry.value, &value_bits, sizeof(value_bits));
+  entry.depth = (data >> 32) & 0xff;
+  entry.bound = static_cast<Bound>((data >> 40) & 3);
+  entry.best_move_index = static_cast<int>((data >> 42) & 0xffff) - 1;
+  return entry;
+}
+
+bool TranspositionTable::Probe(uint64_t key, Entry* entry) const {
+  const Slot& slot = slots_[key & mask_];
+  const uint64_t data = slot.data.load(std::memory_order_relaxed);
+  const uint64_t checked_key = slot.checked_key.load(std::memory_order_relaxed);
+  if (data == 0 || (checked_key ^ data) != key) {
+    return false;
+  }
+  *entry = Unpack(data);
+  return true;
+}
+
+void TranspositionTable::Store(uint64_t key, const Entry& entry) {
+  Slot& slot = slots_[key & mask_];
+  const uint64_t old_data = slot.data.load(std::memory_order_relaxed);
+  const uint64_t old_checked_key =
+      slot.checked_key.load(std::memory_order_relaxed);
+  if (old_data != 0 && (old_checked_key ^ old_data) == key &&
+      Unpack(old_data).depth > entry.depth) {
+    return;
+  }
+  const uint64_t data = Pack(entry);
+  slot.checked_key.store(key ^ data, std::memory_order_relaxed);
+  slot.data.store(data, std::memory_order_relaxed);
+}
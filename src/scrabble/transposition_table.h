@@ -0,0 +1,49 @@
+#ifndef SRC_SCRABBLE_TRANSPOSITION_TABLE_H
+#define SRC_SCRABBLE_TRANSPOSITION_TABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Fixed-size hash table of search results, indexed by the low bits of a
+// position hash (see Zobrist). Each slot is two 64-bit words, the data and
+// the data XORed with the full key, so a slot torn by concurrent writers
+// fails the key check instead of returning mixed results, and no locks are
+// needed. Colliding positions simply replace each other.
+class TranspositionTable {
+ public:
+  enum Bound { Exact, Lower, Upper };
+  // Deeper depths are stored as this.
+  static constexpr int kMaxDepth = 0xff;
+  struct Entry {
+    float value;
+    int depth;
+    Bound bound;
+    // Index of the best move in the position's sorted move list, or -1.
+    int best_move_index;
+  };
+
+  // The table has 2^log2_num_slots slots of 16 bytes.
+  explicit TranspositionTable(int log2_num_slots);
+
+  bool Probe(uint64_t key, Entry* entry) const;
+  // Keeps a deeper result already stored for the same key.
+  void Store(uint64_t key, const Entry& entry);
+  void Clear();
+
+  uint64_t NumSlots() const { return mask_ + 1; }
+
+ private:
+  struct Slot {
+    std::atomic<uint64_t> checked_key;
+    std::atomic<uint64_t> data;
+  };
+
+  static uint64_t Pack(const Entry& entry);
+  static Entry Unpack(uint64_t data);
+
+  const uint64_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+};
+
+#endif  // SRC_SCRABBLE_TRANSPOSITION_TABLE_H
@@ -0,0 +1,48 @@
+#include "src/scrabble/transposition_table.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+TEST(TranspositionTableTest, StoreAndProbe) {
+  TranspositionTable table(4);
+  EXPECT_EQ(table.NumSlots(), 16);
+  TranspositionTable::Entry entry;
+  EXPECT_FALSE(table.Probe(0, &entry));
+  EXPECT_FALSE(table.Probe(12345, &entry));
+
+  table.Store(12345, {-17.5, 3, TranspositionTable::Lower, 41});
+  ASSERT_TRUE(table.Probe(12345, &entry));
+  EXPECT_FLOAT_EQ(entry.value, -17.5);
+  EXPECT_EQ(entry.depth, 3);
+  EXPECT_EQ(entry.bound, TranspositionTable::Lower);
+  EXPECT_EQ(entry.best_move_index, 41);
+  // Same slot, different key.
+  EXPECT_FALSE(table.Probe(12345 + 16, &entry));
+
+  table.Store(777, {0.0, 0, TranspositionTable::Exact, -1});
+  ASSERT_TRUE(table.Probe(777, &entry));
+  EXPECT_EQ(entry.best_move_index, -1);
+  EXPECT_EQ(entry.bound, TranspositionTable::Exact);
+
+  table.Clear();
+  EXPECT_FALSE(table.Probe(12345, &entry));
+}
+
+TEST(TranspositionTableTest, Replacement) {
+  TranspositionTable table(4);
+  TranspositionTable::Entry entry;
+  table.Store(5, {10.0, 4, TranspositionTable::Exact, 2});
+  // A shallower result for the same position doesn't replace a deeper one.
+  table.Store(5, {20.0, 2, TranspositionTable::Exact, 3});
+  ASSERT_TRUE(table.Probe(5, &entry));
+  EXPECT_FLOAT_EQ(entry.value, 10.0);
+  table.Store(5, {30.0, 4, TranspositionTable::Upper, 4});
+  ASSERT_TRUE(table.Probe(5, &entry));
+  EXPECT_FLOAT_EQ(entry.value, 30.0);
+  EXPECT_EQ(entry.bound, TranspositionTable::Upper);
+  // A different position in the same slot always does.
+  table.Store(5 + 16, {40.0, 1, TranspositionTable::Exact, 0});
+  EXPECT_FALSE(table.Probe(5, &entry));
+  ASSERT_TRUE(table.Probe(5 + 16, &entry));
+  EXPECT_FLOAT_EQ(entry.value, 40.0);
+}
@@ -0,0 +1,87 @@
+#include "src/scrabble/zobrist.h"
+
+#include "glog/logging.h"
+
+constexpr int Zobrist::kNumLetters;
+constexpr int Zobrist::kMaxCopies;
+constexpr int Zobrist::kMaxCapIndices;
+
+namespace {
+// SplitMix64, from a fixed seed.
+class KeyGenerator {
+ public:
+  uint64_t Next() {
+    uint64_t z = (state_ += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+ private:
+  uint64_t state_ = 0x5132a0b3c1d2e3f4ULL;
+};
+}  // namespace
+
+Zobrist::Zobrist() {
+  KeyGenerator gen;
+  for (auto& square : squares_) {
+    for (auto& key : square) {
+      key = gen.Next();
+    }
+  }
+  for (auto& side : racks_) {
+    for (auto& letter : side) {
+      for (auto& key : letter) {
+        key = gen.Next();
+      }
+    }
+  }
+  turn_ = gen.Next();
+  after_pass_ = gen.Next();
+  for (auto& key : cap_indices_) {
+    key = gen.Next();
+  }
+}
+
+uint64_t Zobrist::BoardHash(const Board& board) const {
+  uint64_t hash = 0;
+  for (int row = 0; row < 15; ++row) {
+    for (int col = 0; col < 15; ++col) {
+      const Letter letter = board.At(row, col);
+      if (letter) {
+        hash ^= Square(row, col, letter);
+      }
+    }
+  }
+  return hash;
+}
+
+uint64_t Zobrist::MoveHash(const Move& move) const {
+  if (move.GetAction() != Move::Place) {
+    return 0;
+  }
+  uint64_t hash = 0;
+  int row = move.StartRow();
+  int col = move.StartCol();
+  for (const Letter letter : move.Letters()) {
+    if (letter) {
+      hash ^= Square(row, col, letter);
+    }
+    if (move.Direction() == Move::Across) {
+      col++;
+    } else {
+      row++;
+    }
+  }
+  return hash;
+}
+
+uint64_t Zobrist::RackHash(const LetterString& letters, int side) const {
+  std::array<uint8_t, kNumLetters> copies = {0};
+  uint64_t hash = 0;
+  for (const Letter letter : letters) {
+    CHECK_LT(copies[letter], kMaxCopies);
+    hash ^= racks_[side][letter][copies[letter]++];
+  }
+  return hash;
+}
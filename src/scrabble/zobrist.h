@@ -0,0 +1,55 @@
+#ifndef SRC_SCRABBLE_ZOBRIST_H
+#define SRC_SCRABBLE_ZOBRIST_H
+
+#include <array>
+#include <cstdint>
+
+#include "glog/logging.h"
+
+#include "src/scrabble/board.h"
+#include "src/scrabble/move.h"
+#include "src/scrabble/strings.h"
+
+// Random keys for hashing endgame positions: one per (square, letter), one
+// per copy of each letter on either rack, and one each for the side to move
+// and for following a pass, plus one per ply index into a search's move caps.
+// A position's hash is the XOR of the keys of everything in it, so placing a
+// move changes the board hash by MoveHash(move), and undoing it changes it
+// back. Keys are fixed, so hashes are the same from run to run.
+class Zobrist {
+ public:
+  Zobrist();
+
+  uint64_t Square(int row, int col, Letter letter) const {
+    return squares_[row * 15 + col][letter];
+  }
+  uint64_t BoardHash(const Board& board) const;
+  // Zero for anything but a Place move.
+  uint64_t MoveHash(const Move& move) const;
+
+  // side is 0 for the player to move and 1 for their opponent.
+  uint64_t RackHash(const LetterString& letters, int side) const;
+
+  uint64_t Turn() const { return turn_; }
+  uint64_t AfterPass() const { return after_pass_; }
+  // For positions searched under the caps starting at caps_per_ply[index].
+  uint64_t CapIndex(int index) const {
+    CHECK_LT(index, kMaxCapIndices);
+    return cap_indices_[index];
+  }
+
+  static constexpr int kMaxCapIndices = 64;
+
+ private:
+  static constexpr int kNumLetters = 64;
+  static constexpr int kMaxCopies = 8;
+
+  std::array<std::array<uint64_t, kNumLetters>, 225> squares_;
+  std::array<std::array<std::array<uint64_t, kMaxCopies>, kNumLetters>, 2>
+      racks_;
+  uint64_t turn_;
+  uint64_t after_pass_;
+  std::array<uint64_t, kMaxCapIndices> cap_indices_;
+};
+
+#endif  // SRC_SCRABBLE_ZOBRIST_H
@@ -0,0 +1,80 @@
+#include "src/scrabble/zobrist.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/scrabble/board.h"
+#include "src/scrabble/move.h"
+#include "src/scrabble/tiles.h"
+
+class ZobristTest : public testing::Test {
+ protected:
+  ZobristTest()
+      : tiles_("src/scrabble/testdata/english_scrabble_tiles.textproto") {}
+
+  Move ParseMove(const std::string& s) {
+    return Move::Parse(s, tiles_).value();
+  }
+
+  LetterString Letters(const std::string& s) {
+    return tiles_.ToLetterString(s).value();
+  }
+
+  Tiles tiles_;
+  Zobrist zobrist_;
+};
+
+TEST_F(ZobristTest, MoveHashUpdatesBoardHash) {
+  Board board;
+  EXPECT_EQ(zobrist_.BoardHash(board), 0);
+  const Move quack = ParseMove("8D QUACK");
+  const Move muzak = ParseMove("E7 M.ZAK");
+  board.UnsafePlaceMove(quack);
+  EXPECT_EQ(zobrist_.BoardHash(board), zobrist_.MoveHash(quack));
+  board.UnsafePlaceMove(muzak);
+  EXPECT_EQ(zobrist_.BoardHash(board),
+            zobrist_.MoveHash(quack) ^ zobrist_.MoveHash(muzak));
+  board.UnsafeUndoMove(muzak);
+  EXPECT_EQ(zobrist_.BoardHash(board), zobrist_.MoveHash(quack));
+
+  Move exchange(Move::Exchange, Letters("QU"), 0);
+  EXPECT_EQ(zobrist_.MoveHash(exchange), 0);
+}
+
+TEST_F(ZobristTest, DisjointMovesTranspose) {
+  const Move cat = ParseMove("8D CAT");
+  const Move dog = ParseMove("3A DOG");
+  Board board1;
+  board1.UnsafePlaceMove(cat);
+  board1.UnsafePlaceMove(dog);
+  Board board2;
+  board2.UnsafePlaceMove(dog);
+  board2.UnsafePlaceMove(cat);
+  EXPECT_EQ(zobrist_.BoardHash(board1), zobrist_.BoardHash(board2));
+  // A blank is a different tile from the letter it stands for.
+  Board board3;
+  board3.UnsafePlaceMove(ParseMove("8D CaT"));
+  board3.UnsafePlaceMove(dog);
+  EXPECT_NE(zobrist_.BoardHash(board1), zobrist_.BoardHash(board3));
+}
+
+TEST_F(ZobristTest, RackHash) {
+  // Racks are multisets: order doesn't matter, counts do.
+  EXPECT_EQ(zobrist_.RackHash(Letters("AEIR"), 0),
+            zobrist_.RackHash(Letters("RIEA"), 0));
+  EXPECT_NE(zobrist_.RackHash(Letters("AAR"), 0),
+            zobrist_.RackHash(Letters("AR"), 0));
+  EXPECT_NE(zobrist_.RackHash(Letters("AAR"), 0),
+            zobrist_.RackHash(Letters("ARR"), 0));
+  // The same rack hashes differently for each side.
+  EXPECT_NE(zobrist_.RackHash(Letters("AEIR"), 0),
+            zobrist_.RackHash(Letters("AEIR"), 1));
+  EXPECT_EQ(zobrist_.RackHash(Letters(""), 1), 0);
+}
+
+TEST_F(ZobristTest, CapIndex) {
+  // Positions searched under different caps never share a hash.
+  EXPECT_NE(zobrist_.CapIndex(0), 0);
+  EXPECT_NE(zobrist_.CapIndex(0), zobrist_.CapIndex(1));
+  EXPECT_NE(zobrist_.CapIndex(1),
+            zobrist_.CapIndex(Zobrist::kMaxCapIndices - 1));
+}